@@ -21,6 +21,14 @@ if (Test-Path $outputFile)
 $sourceFiles = @(
     "$srcDir/Color.cpp",
     "$srcDir/Canvas.cpp",
+    "$srcDir/Kernels.cpp",
+    "$srcDir/Convolution.cpp",
+    "$srcDir/FFT.cpp",
+    "$srcDir/Scheduler.cpp",
+    "$srcDir/Jobs.cpp",
+    "$srcDir/MappedFile.cpp",
+    "$srcDir/TransferFunction.cpp",
+    "$srcDir/ColorSpaces.cpp",
     "$srcDir/Gradient.cpp",
     "$srcDir/ColorPicker.cpp",
     "$srcDir/Showcase.cpp",
@@ -31,7 +39,7 @@ $sourceFiles = @(
     "$srcDir/exports/ShowcaseExports.cpp"
 ) -join " "
 
-$compilerFlags = "-DBUILDING_DLL -fPIC -std=c++17 -Wall -Wextra"
+$compilerFlags = "-DBUILDING_DLL -fPIC -std=c++17 -O2 -fno-math-errno -fno-trapping-math -Wall -Wextra"
 $linkerFlags = '-static -static-libgcc -static-libstdc++ "-Wl,--enable-stdcall-fixup" "-Wl,-Bstatic"'
 $libraries = "-lgdi32 -lgdiplus -fopenmp"
 $includes = "-I$includeDir"
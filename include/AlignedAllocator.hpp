@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace KTLib
+{
+    // Allocator whose blocks start on an `Alignment` byte boundary. alignas on a container only aligns the
+    // container object, the heap block it points at still comes from plain operator new
+    template<typename T, size_t Alignment>
+    struct AlignedAllocator
+    {
+        static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+
+        using value_type = T;
+
+        template<typename U>
+        struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+        AlignedAllocator() noexcept = default;
+
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+        T* allocate(size_t count)
+        {
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+        }
+
+        void deallocate(T* pointer, size_t) noexcept
+        {
+            ::operator delete(pointer, std::align_val_t(Alignment));
+        }
+
+        template<typename U>
+        bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+
+        template<typename U>
+        bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+    };
+}
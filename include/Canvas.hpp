@@ -1,12 +1,50 @@
 #pragma once
 
+#include "AlignedAllocator.hpp"
 #include "Color.hpp"
 #include "Gradient.hpp"
+#include "TransferFunction.hpp"
+#include "ColorSpaces.hpp"
+#include "Convolution.hpp"
+#include "MappedFile.hpp"
+
+#include <atomic>
+#include <memory>
 
 namespace KTLib
 {
     class Gradient;
 
+    // Byte order of the 32-bit pixels in memory a Canvas wraps
+    enum class PixelFormat
+    {
+        ARGB32, // 0xAARRGGBB words, B G R A in memory like DIB sections and GDI+ 32bppARGB
+        ABGR32  // 0xAABBGGRR words, R G B A in memory
+    };
+
+    // What a Canvas's filters compute with, see Canvas::SetPrecision
+    enum class PixelPrecision
+    {
+        UInt8,  // 8 bits per channel, rounded after every filter
+        Float32 // A float per channel on a 0-1 scale, unclamped until the pixels are read back as 8-bit
+    };
+
+    // How a Canvas stores colour against alpha, see Canvas::SetAlphaMode
+    enum class AlphaMode
+    {
+        Straight,     // Colour channels independent of alpha
+        Premultiplied // Colour channels already multiplied by alpha
+    };
+
+    // Where one image sits against another, see Canvas::PhaseCorrelate. `peak` is near 1 for a clean match
+    // and falls towards 0 as the images stop resembling each other
+    struct PhaseCorrelation
+    {
+        double dx;
+        double dy;
+        double peak;
+    };
+
     class Canvas
     {
         public:
@@ -17,6 +55,43 @@ namespace KTLib
             Canvas(const std::vector<std::vector<Color>>& colors);
             Canvas(const Gradient& gradient, int width, int height);
 
+            // Copies of an owned canvas share its pixels until one of them writes, copies of wrapped memory,
+            // views and canvases that have views get their own packed ARGB32 pixels straight away
+            Canvas(const Canvas& other);
+            Canvas(Canvas&& other) noexcept;
+            Canvas& operator=(Canvas other);
+            ~Canvas();
+
+            // Works on caller-owned pixels in place instead of copying them. `stride` is the distance between
+            // row starts in bytes, negative for bottom-up bitmaps. The memory must outlive the canvas, and
+            // operations that change the canvas size throw. ABGR32 memory is swizzled to ARGB32 in place
+            // while it is wrapped and back when the canvas is destroyed
+            static Canvas* Wrap(void* pixels, int width, int height, int stride, PixelFormat format = PixelFormat::ARGB32);
+
+            // Wraps the bits of a 32 bpp DIB section, top-down or bottom-up
+            static Canvas* WrapDIBSection(HBITMAP hBitmap);
+
+            bool IsWrapped() const { return m_wrapped; }
+            PixelFormat GetFormat() const { return m_format; }
+
+            // Canvases kept in a file instead of memory, paged in and out by the OS as they are touched. They
+            // behave like wrapped memory: their size is fixed and copies of them live in memory.
+            // OpenMapped without `writable` keeps every change in memory and leaves the file as it is
+            static Canvas* CreateMapped(const std::string& path, int width, int height, Color col = Color::Transparent());
+            static Canvas* OpenMapped(const std::string& path, bool writable);
+
+            bool IsMapped() const { return m_file != nullptr; }
+
+            // Writes the changes made so far to the file of a writable mapped canvas
+            void FlushMapped() const;
+
+            // A canvas over a rectangle of this one that shares its pixels, every operation on it only touches
+            // that rectangle. Views must be deleted before their parent, which cannot change size while it has any
+            Canvas* View(int x, int y, int width, int height);
+
+            // The canvas that owns a view's pixels, nullptr for anything that is not a view
+            const Canvas* GetParent() const { return m_parent; }
+
             void Rotate(double angle);
             void Resize(int newWidth, int newHeight, int resizeImage, Color fillColor);
             void Scale(double scale);
@@ -33,17 +108,23 @@ namespace KTLib
 
             int GetWidth() const { return m_width; }
             int GetHeight() const { return m_height; }
-            int GetSize() const { return m_colors.size() * sizeof(Color); }
-            int GetStride() const { return std::round(GetSize() / m_height); }
-            const Color& operator[](int index) const { return m_colors[index]; }
+            // Sizes and pixel indices are 64-bit, a 25000 x 25000 canvas is already past 2^31 bytes
+            size_t GetSize() const { return PixelCount() * sizeof(uint32_t); }
+            // Owned rows are padded to a whole number of cache lines and start 64-byte aligned, wrapped memory keeps
+            // the caller's stride. Always step rows by GetStride(), never by the width
+            int GetStride() const { return static_cast<int>(m_stride * static_cast<ptrdiff_t>(sizeof(uint32_t))); }
+            Color operator[](int64_t index) const { FlushMatrixBatch(); return Color(PixelAt(index)); }
+
+            // The top row, the others follow GetStride() bytes apart
+            uint32_t* GetPixels() { PrepareWrite(); return m_data; } // The caller may write, so shared pixels are copied first
+            const uint32_t* GetPixels() const { FlushMatrixBatch(); return m_data; }
 
-            Color& Get(int x, int y);
-            const Color& Get(int x, int y) const;
+            Color Get(int x, int y) const;
             void Set(int x, int y, const Color& color);
-            Color GetAt(int index) const;
-            void SetAt(int index, const Color& color);
-            void GetXY(int index, int& x, int& y) const;
-            void GetIndex(int x, int y, int& index) const;
+            Color GetAt(int64_t index) const;
+            void SetAt(int64_t index, const Color& color);
+            void GetXY(int64_t index, int& x, int& y) const;
+            void GetIndex(int x, int y, int64_t& index) const;
 
             void ShiftRed(int amount);
             void ShiftGreen(int amount);
@@ -57,6 +138,44 @@ namespace KTLib
 
             void ApplyMatrix(const ColorMatrix& matrix);
 
+            // In Float32 the canvas keeps a float copy of its pixels. Matrix filters, channel shifts, Invert and
+            // GaussianBlur work on it without rounding, so chains of them do not band; every other filter runs
+            // on the 8-bit pixels and the floats are rebuilt from them afterwards. The two sides are only
+            // synced when one is needed after the other changed. Needs a canvas that owns its pixels and has
+            // no views
+            void SetPrecision(PixelPrecision precision);
+            PixelPrecision GetPrecision() const { return m_precision; }
+
+            // Float32 canvases only, width * height * 4 packed values in R G B A order
+            float* GetFloatPixels();
+            const float* GetFloatPixels() const;
+
+            // Converts the pixels in place. Nothing else translates: Get, Set, GetPixels and the filters all see
+            // the stored values, so resampling and blurs on a premultiplied canvas weight colour by alpha and
+            // transparent pixels stop bleeding into their neighbours. OverlayImage onto a premultiplied canvas
+            // composites with a vectorised source-over and accepts overlays in either mode. Views share their
+            // parent's mode, a canvas with views cannot change it
+            void SetAlphaMode(AlphaMode mode);
+            AlphaMode GetAlphaMode() const { return m_alphaMode; }
+
+            // While batching, matrix filters are composed into one matrix and applied in a single
+            // pass on EndMatrixBatch, FlushMatrixBatch or before any other operation touches the pixels.
+            // Views cannot batch, their parent's operations would not know to flush them
+            void BeginMatrixBatch();
+            void EndMatrixBatch();
+            void FlushMatrixBatch() const;
+            bool IsMatrixBatching() const { return m_matrixBatching; }
+
+            // Decodes every pixel to linear RGBA floats (4 per pixel) and back, FromLinear
+            // expects width * height * 4 values and replaces the canvas contents
+            std::vector<float> ToLinear(TransferCurve curve = TransferCurve::sRGB) const;
+            void FromLinear(const float* linear, TransferCurve curve = TransferCurve::sRGB);
+
+            // Same layout for any of the batch color spaces, see ColorSpaces::FromPixels
+            std::vector<float> ToSpace(ColorSpace space) const;
+            void ToSpace(ColorSpace space, float* values) const;
+            void FromSpace(const float* values, ColorSpace space);
+
             void Invert();
             void ShiftHue(double degrees);
             void Grayscale();
@@ -75,9 +194,29 @@ namespace KTLib
             void ShiftBlackLevel(double amount);
             void ShiftContrast(double amount);
             void Pixelate(int pixelSize);
-            void Blur(int radius);
+            // Box blur, constant time per pixel whatever the radius. Three passes come close to a Gaussian
+            void Blur(int radius, int passes = 1);
+
+            // Sigma is the standard deviation in pixels. Up to 3 the kernel is applied directly, above that a
+            // recursive filter takes the same time per pixel whatever sigma is. The radius overload blurs as far as
+            // `radius` pixels out, which is sigma = radius / 3
             void GaussianBlur(double sigma);
+            void GaussianBlurRadius(int radius);
+
+            // Borders repeat the edge pixels. Kernels too large for fixed point go through the FFT when a cost
+            // estimate says it beats direct convolution. Sharpen, Emboss and EdgeDetect are 3x3 kernels run through this
+            void Convolve(const ConvolutionKernel& kernel, ConvolveAlpha alpha = ConvolveAlpha::Keep);
             void Sharpen(float amount);
+
+            // Gaussian filters in the frequency domain, `cutoff` is the response's standard deviation in cycles per
+            // pixel (0.5 is the highest frequency an image holds). Colour only, alpha is kept. HighPass leaves the
+            // detail around mid grey
+            void LowPass(double cutoff);
+            void HighPass(double cutoff);
+
+            // How far `other`, the same size as this canvas, is shifted from it to within a fraction of a pixel:
+            // other(x, y) ~ this(x - dx, y - dy), wrapping around the edges
+            PhaseCorrelation PhaseCorrelate(const Canvas& other) const;
             void Flip(bool horizontal);
             void Crop(int x, int y, int width, int height);
             void AdjustContrast(double factor);
@@ -87,14 +226,14 @@ namespace KTLib
             void Emboss();
             void EdgeDetect();
             void Vignette(double strength = 0.3, double radius = 1.0);
-            void TwoColorNoise(double density = 0.05, const Color& saltColor = Color::White(), const Color& pepperColor = Color::Black());
-            void GaussianNoise(double mean = 0.0, double stdDev = 10.0);
-            void PerlinNoise(double frequency, double amplitude, int octaves, double persistence, double lacunarity);
-            void SimplexNoise(double frequency, double amplitude, int octaves, double persistence, double lacunarity);
-            void FractalBrownianMotion(double frequency, double amplitude, int octaves, double persistence, double lacunarity);
-            void Voronoi(int numPoints, double falloff, double strength);
+            void TwoColorNoise(double density = 0.05, const Color& saltColor = Color::White(), const Color& pepperColor = Color::Black(), uint64_t seed = 0);
+            void GaussianNoise(double mean = 0.0, double stdDev = 10.0, uint64_t seed = 0);
+            void PerlinNoise(double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed = 0);
+            void SimplexNoise(double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed = 0);
+            void FractalBrownianMotion(double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed = 0);
+            void Voronoi(int numPoints, double falloff, double strength, uint64_t seed = 0);
             void Plasma(double frequency, double phase);
-            void DiamondSquare(double roughness, double waterLevel, double levelsPerStop);
+            void DiamondSquare(double roughness, double waterLevel, double levelsPerStop, uint64_t seed = 0);
             void Posterize(int levels);
 
             Canvas* Copy() const;
@@ -102,22 +241,115 @@ namespace KTLib
             size_t CountUniqueColors() const;
             void MapColors(int x, int y, int width, int height, unsigned int (*mapFunction)(int, int, unsigned int));
             void ForEach(const std::function<void(const Color&)>& func) const;
-            int Find(const Color& color) const;
-            int FindLast(const Color& color) const;
+            int64_t Find(const Color& color) const;
+            int64_t FindLast(const Color& color) const;
             void Swap(size_t index1, size_t index2);
             Canvas Filter(const std::function<bool(const Color&)>& predicate) const;
-            int Count(const Color& color) const;
-            void Shuffle();
+            size_t Count(const Color& color) const;
+            void Shuffle(uint64_t seed = 0);
             void Clear();
             void Sort(const std::function<bool(const Color&, const Color&)>& compare);
             void AppendRight(const Canvas& other);
             void AppendBottom(const Canvas& other);
-            std::vector<int> FindAll(const Color& color) const;
+            std::vector<int64_t> FindAll(const Color& color) const;
             Color CalculateAverageColor(int startX = 0, int startY = 0, int pixelWidth = 0, int pixelHeight = 0);
 
         private:
-            alignas(32) std::vector<Color> m_colors;
+            Canvas(const Canvas& parent, int x, int y, int width, int height);
+
+            uint32_t* Row(int y) const { return m_data + static_cast<ptrdiff_t>(y) * m_stride; }
+            uint32_t& Pixel(int x, int y) const { return Row(y)[x]; }
+            uint32_t& PixelAt(size_t index) const { return Row(static_cast<int>(index / m_width))[index % m_width]; }
+            size_t PixelCount() const { return static_cast<size_t>(m_width) * m_height; }
+            bool IsContiguous() const { return m_stride == m_width; }
+
+            // func(pixels, count, index) over runs of consecutive pixels in parallel, `index` is the
+            // row-major index of the first one
+            template<typename Func>
+            void ForEachSpan(Func&& func) const;
+
+            // pixel = func(pixel) for every pixel
+            template<typename Func>
+            void MapPixels(Func&& func);
+
+            std::vector<uint32_t> Packed() const;
+            void Unpack(const uint32_t* packed);
+
+            void RecursiveGaussianBlur(double sigma);
+
+            // Convolve through the FFT, for the first `channels` channels
+            void SpectralConvolve(const ConvolutionKernel& kernel, int channels);
+            // One channel of the pixels with the edge pixels repeated out `left`, `top`, `right` and `bottom`
+            // pixels, as doubles at the top left of a transformWidth x transformHeight image zeroed elsewhere
+            void FillChannel(double* image, size_t transformWidth, size_t transformHeight, int left, int top, int right, int bottom, int shift) const;
+            void FrequencyFilter(double cutoff, bool highPass);
+
+            // Size changes swap in a new owned buffer, which a wrapped canvas cannot do and which would leave
+            // views pointing at freed memory
+            void RequireNoViews(const char* operation) const;
+            void RequireResizable(const char* operation) const;
+            // Owned storage: rows are RowAlignment bytes apart at least and start on that boundary, so kernels can
+            // use aligned loads and non-temporal stores on any owned row
+            static constexpr size_t RowAlignment = 64;
+            using PixelBuffer = std::vector<uint32_t, AlignedAllocator<uint32_t, RowAlignment>>;
+
+            static ptrdiff_t PaddedStride(int width);
+            static PixelBuffer AllocatePixels(int width, int height, uint32_t fill = 0);
+            void ReplacePixels(PixelBuffer&& pixels, int width, int height);
+            void ReleaseWrapped();
+
+            // Copy-on-write: every method that changes pixels in place calls one of these first. Detach gives
+            // the canvas its own buffer if a copy still shares it, PrepareWrite also flushes the matrix batch
+            void Detach();
+            void PrepareWrite();
+
+            // Float32 canvases: FlushFloats brings the floats up to date, pending matrix included, and
+            // PrepareFloatWrite is PrepareWrite for filters that work on them
+            void FlushFloats() const;
+            void PrepareFloatWrite();
+            void ApplyMatrixToFloats(const ColorMatrix& matrix) const;
+
+            // func(rgba) for every float pixel and true on Float32 canvases, false and nothing on 8-bit ones
+            template<typename Func>
+            bool MapFloats(Func&& func);
+
+            // Nearest-neighbour copy into a width x height ARGB32 buffer with rows `stride` pixels apart
+            void SampleInto(uint32_t* destination, int width, int height, ptrdiff_t stride) const;
+
+            // Pixels are stored as 0xAARRGGBB words, Color is only used at the API edge. Owned pixels live in
+            // m_pixels, shared between copies until one writes. A wrapped canvas leaves it null and points
+            // m_data at the caller's memory
+            std::shared_ptr<PixelBuffer> m_pixels;
+            uint32_t* m_data = nullptr;
+            ptrdiff_t m_stride = 0; // In pixels
             int m_width = 0;
             int m_height = 0;
+            bool m_wrapped = false;
+            PixelFormat m_format = PixelFormat::ARGB32;
+            std::unique_ptr<MappedFile> m_file; // Set for mapped canvases, which are also wrapped
+
+            // The whole region Wrap was given. Crop narrows m_data and the size, the caller still gets all of
+            // this back in its own format
+            uint32_t* m_wrappedData = nullptr;
+            int m_wrappedWidth = 0;
+            int m_wrappedHeight = 0;
+
+            const Canvas* m_parent = nullptr;     // Always the canvas that owns the pixels, never another view
+            mutable std::atomic<int> m_views{0};  // Views currently looking into this canvas
+
+            bool m_matrixBatching = false;
+            mutable bool m_hasPendingMatrix = false;
+            mutable ColorMatrix m_pendingMatrix;
+
+            // Float32 pixels, packed, and shared between copies like m_pixels. The stale flags say which side
+            // changed last, the other one is rebuilt from it when needed. A canvas with stale 8-bit pixels
+            // never shares them
+            using FloatBuffer = std::vector<float, AlignedAllocator<float, RowAlignment>>;
+            PixelPrecision m_precision = PixelPrecision::UInt8;
+            mutable std::shared_ptr<FloatBuffer> m_floats;
+            mutable bool m_floatsStale = false;
+            mutable bool m_bytesStale = false;
+
+            AlphaMode m_alphaMode = AlphaMode::Straight;
     };
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Constants.h"
 
 #include <unordered_set>
+#include <type_traits>
 #include <functional>
 #include <algorithm>
 #include <windows.h>
@@ -14,64 +15,217 @@
 
 namespace KTLib
 {
+    // 5x5 colour matrix working on 0-1 channels: rows 0-3 produce R, G, B, A from
+    // (R, G, B, A, 1). Everything is constexpr so the built-in effects and their
+    // compositions fold at compile time.
     struct ColorMatrix
     {
         double data[5][5];
 
-        const double* operator[](int index) const { return data[index]; }
+        constexpr const double* operator[](int index) const { return data[index]; }
 
-        ColorMatrix operator*(double factor) const
+        constexpr ColorMatrix operator*(double factor) const
         {
-            ColorMatrix result;
-            #pragma omp parallel for
-            for(int i = 0; i < 25; i++) result.data[i/5][i%5] = data[i/5][i%5] * factor;
+            ColorMatrix result{};
+            for (int i = 0; i < 5; i++)
+                for (int j = 0; j < 5; j++)
+                    result.data[i][j] = data[i][j] * factor;
             return result;
         }
 
-        ColorMatrix operator*(const ColorMatrix& other) const
+        constexpr ColorMatrix operator*(const ColorMatrix& other) const
         {
-            ColorMatrix result;
-            #pragma omp parallel for collapse(2)
-            for(int i = 0; i < 5; i++)
-            {
-                for(int j = 0; j < 5; j++)
-                {
-                    result.data[i][j] = 0;
-                    for(int k = 0; k < 5; k++) result.data[i][j] += data[i][k] * other.data[k][j];
-                }
-            }
+            ColorMatrix result{};
+            for (int i = 0; i < 5; i++)
+                for (int j = 0; j < 5; j++)
+                    for (int k = 0; k < 5; k++)
+                        result.data[i][j] += data[i][k] * other.data[k][j];
             return result;
         }
 
-        ColorMatrix operator+(const ColorMatrix& other) const
+        constexpr ColorMatrix operator+(const ColorMatrix& other) const
         {
-            ColorMatrix result;
-            #pragma omp parallel for
-            for(int i = 0; i < 25; i++) result.data[i/5][i%5] = data[i/5][i%5] + other.data[i/5][i%5];
+            ColorMatrix result{};
+            for (int i = 0; i < 5; i++)
+                for (int j = 0; j < 5; j++)
+                    result.data[i][j] = data[i][j] + other.data[i][j];
             return result;
         }
 
-        ColorMatrix operator-(const ColorMatrix& other) const
+        constexpr ColorMatrix operator-(const ColorMatrix& other) const
         {
-            ColorMatrix result;
-            #pragma omp parallel for
-            for(int i = 0; i < 25; i++) result.data[i/5][i%5] = data[i/5][i%5] - other.data[i/5][i%5];
+            ColorMatrix result{};
+            for (int i = 0; i < 5; i++)
+                for (int j = 0; j < 5; j++)
+                    result.data[i][j] = data[i][j] - other.data[i][j];
             return result;
         }
 
-        ColorMatrix Transpose() const
+        constexpr ColorMatrix Transpose() const
         {
-            ColorMatrix result;
-            #pragma omp parallel for collapse(2)
-            for(int i = 0; i < 5; i++)
-                for(int j = 0; j < 5; j++)
+            ColorMatrix result{};
+            for (int i = 0; i < 5; i++)
+                for (int j = 0; j < 5; j++)
                     result.data[i][j] = data[j][i];
             return result;
         }
 
-        friend ColorMatrix operator*(double factor, const ColorMatrix& matrix) { return matrix * factor; }
+        // Matrix that applies this one and then `next`. Only rows 0-3 are ever applied,
+        // so the bottom row is treated as (0, 0, 0, 0, 1) on both sides
+        constexpr ColorMatrix Then(const ColorMatrix& next) const
+        {
+            ColorMatrix result{};
+            for (int row = 0; row < 4; ++row)
+            {
+                for (int col = 0; col < 5; ++col)
+                {
+                    double sum = (col == 4) ? next.data[row][4] : 0.0;
+                    for (int k = 0; k < 4; ++k) sum += next.data[row][k] * data[k][col];
+                    result.data[row][col] = sum;
+                }
+            }
+            result.data[4][4] = 1.0;
+            return result;
+        }
+
+        // Scales the RGB 3x3 block, which is how the effect strength `factor` is applied
+        constexpr ColorMatrix ScaleRGB(double factor) const
+        {
+            ColorMatrix result = *this;
+            for (int i = 0; i < 3; i++)
+                for (int j = 0; j < 3; j++)
+                    result.data[i][j] *= factor;
+            return result;
+        }
+
+        friend constexpr ColorMatrix operator*(double factor, const ColorMatrix& matrix) { return matrix * factor; }
+
+        static constexpr ColorMatrix Identity();
+        static constexpr ColorMatrix Grayscale(double factor = 1);
+        static constexpr ColorMatrix Sepia(double factor = 1);
+        static constexpr ColorMatrix CrossProcess(double factor = 1);
+        static constexpr ColorMatrix Moonlight(double factor = 1);
+        static constexpr ColorMatrix VintageFilm(double factor = 1);
+        static constexpr ColorMatrix Technicolor(double factor = 1);
+        static constexpr ColorMatrix Polaroid(double factor = 1);
+        static constexpr ColorMatrix WhiteLevel(double amount);
+        static constexpr ColorMatrix BlackLevel(double amount);
+        static constexpr ColorMatrix Contrast(double amount);
     };
 
+    // Built-in effect matrices at full strength
+    namespace ColorMatrices
+    {
+        inline constexpr ColorMatrix Identity = {{
+            {1, 0, 0, 0, 0},
+            {0, 1, 0, 0, 0},
+            {0, 0, 1, 0, 0},
+            {0, 0, 0, 1, 0},
+            {0, 0, 0, 0, 1}
+        }};
+
+        inline constexpr ColorMatrix Grayscale = {{
+            {0.299, 0.587, 0.114, 0, 0},
+            {0.299, 0.587, 0.114, 0, 0},
+            {0.299, 0.587, 0.114, 0, 0},
+            {0    , 0    , 0    , 1, 0},
+            {0    , 0    , 0    , 0, 1}
+        }};
+
+        inline constexpr ColorMatrix Sepia = {{
+            {0.393, 0.769, 0.189, 0, 0},
+            {0.349, 0.686, 0.168, 0, 0},
+            {0.272, 0.534, 0.131, 0, 0},
+            {0    , 0    , 0    , 1, 0},
+            {0    , 0    , 0    , 0, 1}
+        }};
+
+        inline constexpr ColorMatrix CrossProcess = {{
+            {1.0, 0.2,  0.1, 0, 0},
+            {0.0, 1.1, -0.1, 0, 0},
+            {0.1, 0.1,  1.0, 0, 0},
+            {0  , 0  ,  0  , 1, 0},
+            {0  , 0  ,  0  , 0, 1}
+        }};
+
+        inline constexpr ColorMatrix Moonlight = {{
+            {0.7, 0.0, 0.3, 0, 0},
+            {0.0, 0.9, 0.1, 0, 0},
+            {0.2, 0.1, 1.1, 0, 0},
+            {0  , 0  , 0  , 1, 0},
+            {0  , 0  , 0  , 0, 1}
+        }};
+
+        inline constexpr ColorMatrix VintageFilm = {{
+            {0.9, 0.1, 0.1, 0, 0},
+            {0.1, 0.9, 0.1, 0, 0},
+            {0.1, 0.2, 0.7, 0, 0},
+            {0  , 0  , 0  , 1, 0},
+            {0  , 0  , 0  , 0, 1}
+        }};
+
+        inline constexpr ColorMatrix Technicolor = {{
+            { 1.6, -0.4, -0.2, 0, 0},
+            {-0.2,  1.4, -0.2, 0, 0},
+            {-0.2, -0.4,  1.6, 0, 0},
+            { 0  ,  0  ,  0  , 1, 0},
+            { 0  ,  0  ,  0  , 0, 1}
+        }};
+
+        inline constexpr ColorMatrix Polaroid = {{
+            { 1.438, -0.062, -0.062, 0, 0},
+            {-0.122,  1.378, -0.122, 0, 0},
+            {-0.016, -0.016,  1.483, 0, 0},
+            { 0    ,  0    ,  0    , 1, 0},
+            { 0    ,  0    ,  0    , 0, 1}
+        }};
+    }
+
+    constexpr ColorMatrix ColorMatrix::Identity()                    { return ColorMatrices::Identity; }
+    constexpr ColorMatrix ColorMatrix::Grayscale(double factor)      { return ColorMatrices::Grayscale.ScaleRGB(factor); }
+    constexpr ColorMatrix ColorMatrix::Sepia(double factor)          { return ColorMatrices::Sepia.ScaleRGB(factor); }
+    constexpr ColorMatrix ColorMatrix::CrossProcess(double factor)   { return ColorMatrices::CrossProcess.ScaleRGB(factor); }
+    constexpr ColorMatrix ColorMatrix::Moonlight(double factor)      { return ColorMatrices::Moonlight.ScaleRGB(factor); }
+    constexpr ColorMatrix ColorMatrix::VintageFilm(double factor)    { return ColorMatrices::VintageFilm.ScaleRGB(factor); }
+    constexpr ColorMatrix ColorMatrix::Technicolor(double factor)    { return ColorMatrices::Technicolor.ScaleRGB(factor); }
+    constexpr ColorMatrix ColorMatrix::Polaroid(double factor)       { return ColorMatrices::Polaroid.ScaleRGB(factor); }
+
+    constexpr ColorMatrix ColorMatrix::WhiteLevel(double amount)
+    {
+        double w = std::clamp(amount / 100.0, -1.0, 1.0);
+
+        return {{
+            {1, w, w, 0, 0},
+            {w, 1, w, 0, 0},
+            {w, w, 1, 0, 0},
+            {0, 0, 0, 1, 0},
+            {0, 0, 0, 0, 1}
+        }};
+    }
+
+    constexpr ColorMatrix ColorMatrix::BlackLevel(double amount)
+    {
+        double b = 1.0 - std::clamp(amount / 100.0, -1.0, 1.0);
+        return ColorMatrices::Identity.ScaleRGB(b);
+    }
+
+    constexpr ColorMatrix ColorMatrix::Contrast(double amount)
+    {
+        amount = std::clamp(amount / 100, -1.0, 1.0);
+        double factor = 1.0 / (1.0 - amount) - 1.0;
+
+        // Scale around mid-grey: the offset column pulls the result back by half the added gain
+        return {{
+            {1.0 + factor, 0           , 0           , 0, -factor / 2},
+            {0           , 1.0 + factor, 0           , 0, -factor / 2},
+            {0           , 0           , 1.0 + factor, 0, -factor / 2},
+            {0           , 0           , 0           , 1, 0          },
+            {0           , 0           , 0           , 0, 1          }
+        }};
+    }
+
+    static_assert(ColorMatrices::Sepia.Then(ColorMatrices::Identity).data[0][1] == ColorMatrices::Sepia.data[0][1], "ColorMatrix must stay usable in constant expressions");
+
     enum class YCbCrType
     {
         BT601,
@@ -81,9 +235,6 @@ namespace KTLib
 
     class Color
     {
-        private:
-            std::string formatString;
-            std::string typeString;
         public:
             union
             {
@@ -103,7 +254,6 @@ namespace KTLib
 
             template<typename T> T Convert() const { return T(*this); }
             static constexpr double DefaultGamma = 2.2;
-            double gamma = DefaultGamma;
 
             Color operator+(int value) const;
             Color operator+(const Color& other) const;
@@ -165,10 +315,6 @@ namespace KTLib
             void Invert() { *this = -*this; }
             bool IsLight() const { return GetLuminance() > 0.5; }
             bool IsDark() const { return GetLuminance() <= 0.5; }
-            const std::string& GetFormatString() const { return formatString; }
-            void SetFormatString(const std::string& format) { formatString = format; }
-            const std::string& GetTypeString() const { return typeString; }
-            void SetTypeString(const std::string& type) { typeString = type; }
             std::string ToString(const char* type = "", const std::string& format = "") const;
             static std::string ReplaceAll(std::string str, const std::string& from, const std::string& to);
             static std::string GetDefaultFormat(const char* type);
@@ -455,6 +601,20 @@ namespace KTLib
             static inline Color Yellow()               { return Color(0xFFFFFF00); }
             static inline Color YellowGreen()          { return Color(0xFF9ACD32); }
     };
+
+    static_assert(sizeof(Color) == 4 && std::is_trivially_copyable_v<Color>, "Color must stay a packed 4-byte value type");
+
+    // Holds the string representation settings that used to live on every Color instance
+    struct ColorFormatter
+    {
+        std::string type = "RGB";
+        std::string format;
+
+        ColorFormatter() = default;
+        ColorFormatter(const std::string& type, const std::string& format = "") : type(type), format(format) { }
+
+        std::string Format(const Color& color) const { return color.ToString(type.c_str(), format); }
+    };
 }
 
 namespace std
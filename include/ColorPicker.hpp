@@ -63,8 +63,7 @@ namespace KTLib
             int m_previewYOffset = 10;
             bool m_isActive = false;
 
-            std::string m_colorSpace;
-            std::string m_format;
+            ColorFormatter m_formatter;
 
             int m_previewWidth = 128;
             int m_previewHeight = 128;
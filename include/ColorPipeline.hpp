@@ -0,0 +1,683 @@
+#pragma once
+
+#include "Scheduler.hpp"
+#include "TransferFunction.hpp"
+#include "Constants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+// Compile-time conversion pipelines. Every space is a tag type that either hangs off a parent space
+// through a pair of stages (Lab -> XYZ_D65, HSL -> SRGB, ...) or is a linear root that reaches linear sRGB
+// with a 3x3 matrix. ConvertPixels<Src, Dst> walks up to the nearest space both share, or bridges the two
+// roots with a single matrix multiplied out at compile time, so nothing is decoded twice along the way
+namespace KTLib
+{
+    namespace ColorSpaces
+    {
+        namespace Detail
+        {
+            // Colours are converted in blocks of this many, one component per array so the
+            // `omp simd` loops below vectorise
+            constexpr size_t BlockSize = 256;
+
+            struct Block
+            {
+                float c0[BlockSize];
+                float c1[BlockSize];
+                float c2[BlockSize];
+                float alpha[BlockSize];
+            };
+
+            struct Matrix3
+            {
+                double m[3][3];
+            };
+
+            constexpr Matrix3 Multiply(const Matrix3& a, const Matrix3& b)
+            {
+                Matrix3 result{};
+                for (int i = 0; i < 3; ++i)
+                    for (int j = 0; j < 3; ++j)
+                        result.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+                return result;
+            }
+
+            constexpr Matrix3 Scale(const Matrix3& a, double factor)
+            {
+                Matrix3 result{};
+                for (int i = 0; i < 3; ++i)
+                    for (int j = 0; j < 3; ++j)
+                        result.m[i][j] = a.m[i][j] * factor;
+                return result;
+            }
+
+            constexpr Matrix3 Identity = {{
+                {1.0, 0.0, 0.0},
+                {0.0, 1.0, 0.0},
+                {0.0, 0.0, 1.0}
+            }};
+
+            // Same coefficients as the matching Color::To*/From* methods, XYZ is 0-1 here
+            constexpr Matrix3 LinearToXYZ_D65 = {{
+                {0.4124564, 0.3575761, 0.1804375},
+                {0.2126729, 0.7151522, 0.0721750},
+                {0.0193339, 0.1191920, 0.9503041}
+            }};
+
+            constexpr Matrix3 XYZ_D65ToLinear = {{
+                { 3.2406255, -1.5372080, -0.4986286},
+                {-0.9689307,  1.8757610,  0.0415175},
+                { 0.0557101, -0.2040211,  1.0569959}
+            }};
+
+            constexpr Matrix3 LinearToXYZ_D50 = {{
+                {0.4360747, 0.3850649, 0.1430804},
+                {0.2225045, 0.7168786, 0.0606169},
+                {0.0139322, 0.0971045, 0.7141733}
+            }};
+
+            constexpr Matrix3 XYZ_D50ToLinear = {{
+                { 3.1338561, -1.6168667, -0.4906146},
+                {-0.9787684,  1.9161415,  0.0334540},
+                { 0.0719453, -0.2289914,  1.4052427}
+            }};
+
+            constexpr Matrix3 XYZToLMS = {{
+                {0.8189330101, 0.3618667424, -0.1288597137},
+                {0.0329845436, 0.9293118715,  0.0361456387},
+                {0.0482003018, 0.2643662691,  0.6338517070}
+            }};
+
+            constexpr Matrix3 LMSToXYZ = {{
+                { 1.2270138511, -0.5577999807,  0.2812561490},
+                {-0.0405801784,  1.1122568696, -0.0716766787},
+                {-0.0763812845, -0.4214819784,  1.5861632204}
+            }};
+
+            constexpr Matrix3 LMSToOKLab = {{
+                {0.2104542553,  0.7936177850, -0.0040720468},
+                {1.9779984951, -2.4285922050,  0.4505937099},
+                {0.0259040371,  0.7827717662, -0.8086757660}
+            }};
+
+            constexpr Matrix3 OKLabToLMS = {{
+                {1.0,  0.3963377774,  0.2158037573},
+                {1.0, -0.1055613458, -0.0638541728},
+                {1.0, -0.0894841775, -1.2914855480}
+            }};
+
+            // D65 reference white, 0-100 like Color::ToXYZ_D65
+            constexpr float WhiteX = 95.047f;
+            constexpr float WhiteY = 100.000f;
+            constexpr float WhiteZ = 108.883f;
+
+            constexpr float DegreesPerRadian = static_cast<float>(180.0 / CONST_PI);
+
+            #pragma region Math
+            // Bit-level estimate refined by two Halley steps, accurate to float precision and branch free
+            inline float Cbrt(float x)
+            {
+                float ax = std::fabs(x);
+                uint32_t bits;
+                std::memcpy(&bits, &ax, sizeof(bits));
+                bits = bits / 3 + 0x2A5137A0;
+
+                float y;
+                std::memcpy(&y, &bits, sizeof(y));
+
+                float y3 = y * y * y;
+                y = y * (y3 + 2.0f * ax) / (2.0f * y3 + ax);
+                y3 = y * y * y;
+                y = y * (y3 + 2.0f * ax) / (2.0f * y3 + ax);
+
+                y = (ax > 0.0f) ? y : 0.0f;
+                return (x < 0.0f) ? -y : y;
+            }
+
+            // log2 for positive normal floats. The mantissa is centred on 1 so four terms of the atanh
+            // series are within 2e-7
+            inline float Log2(float x)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &x, sizeof(bits));
+                int exponent = static_cast<int>(bits >> 23) - 127;
+                bits = (bits & 0x007FFFFF) | 0x3F800000;
+
+                float m;
+                std::memcpy(&m, &bits, sizeof(m));
+                bool high = m > 1.41421356f;
+                m = high ? m * 0.5f : m;
+                exponent = high ? exponent + 1 : exponent;
+
+                float t = (m - 1.0f) / (m + 1.0f);
+                float t2 = t * t;
+                float ln = t * (2.0f + t2 * (2.0f / 3.0f + t2 * (2.0f / 5.0f + t2 * (2.0f / 7.0f))));
+                return static_cast<float>(exponent) + ln * 1.44269504f;
+            }
+
+            // 2^y split into an exponent and a Taylor series on the +-0.5 remainder, relative error below 2e-7
+            inline float Exp2(float y)
+            {
+                y = std::min(std::max(y, -126.0f), 127.0f);
+                int whole = static_cast<int>(y + ((y >= 0.0f) ? 0.5f : -0.5f));
+                float f = (y - static_cast<float>(whole)) * 0.69314718f;
+                float p = 1.0f + f * (1.0f + f * (1.0f / 2.0f + f * (1.0f / 6.0f + f * (1.0f / 24.0f + f * (1.0f / 120.0f + f * (1.0f / 720.0f))))));
+
+                uint32_t bits = static_cast<uint32_t>(whole + 127) << 23;
+                float scale;
+                std::memcpy(&scale, &bits, sizeof(scale));
+                return p * scale;
+            }
+
+            inline float Pow(float x, float y) { return (x > 0.0f) ? Exp2(y * Log2(x)) : 0.0f; }
+
+            // The sRGB curve, inlined so it vectorises with the stages around it
+            inline float DecodeSRGB(float v) { return (v <= 0.04045f) ? v * (1.0f / 12.92f) : Pow((v + 0.055f) * (1.0f / 1.055f), 2.4f); }
+            inline float EncodeSRGB(float v) { return (v > 0.0031308f) ? 1.055f * Pow(v, 1.0f / 2.4f) - 0.055f : 12.92f * v; }
+
+            // atan2 in degrees, 0-360 like Color::ToLCHab. Polynomial on 0-1 after folding the octants
+            inline float HueDegrees(float y, float x)
+            {
+                float ax = std::fabs(x);
+                float ay = std::fabs(y);
+                float hi = std::max(ax, ay);
+                float lo = std::min(ax, ay);
+                float t = (hi > 0.0f) ? lo / hi : 0.0f;
+                float s = t * t;
+
+                float r = (((((-0.0117212f * s + 0.05265332f) * s - 0.11643287f) * s + 0.19354346f) * s - 0.33262347f) * s + 0.99997726f) * t;
+                r = (ay > ax) ? 1.57079637f - r : r;
+                r = (x < 0.0f) ? 3.14159274f - r : r;
+                r = (y < 0.0f) ? -r : r;
+
+                float h = r * DegreesPerRadian;
+                return (h < 0.0f) ? h + 360.0f : h;
+            }
+
+            // Reduces to +-45 degrees around the nearest quadrant and evaluates Taylor polynomials there
+            inline void SinCosDegrees(float degrees, float& outSin, float& outCos)
+            {
+                float q = degrees / 90.0f;
+                int quadrant = static_cast<int>(q + ((q >= 0.0f) ? 0.5f : -0.5f));
+                float r = (degrees - static_cast<float>(quadrant) * 90.0f) / DegreesPerRadian;
+                float r2 = r * r;
+
+                float sn = r + r * r2 * (-1.0f / 6.0f + r2 * (1.0f / 120.0f + r2 * (-1.0f / 5040.0f)));
+                float cs = 1.0f + r2 * (-0.5f + r2 * (1.0f / 24.0f + r2 * (-1.0f / 720.0f + r2 * (1.0f / 40320.0f))));
+
+                int k = quadrant & 3;
+                outSin = (k == 0) ? sn : (k == 1) ? cs : (k == 2) ? -sn : -cs;
+                outCos = (k == 0) ? cs : (k == 1) ? -sn : (k == 2) ? -cs : sn;
+            }
+
+            // How far a channel sits between min and max at sextant hue `k`, as in Color::FromHSL/FromHSV
+            inline float HueChannel(float k)
+            {
+                k = (k >= 6.0f) ? k - 6.0f : k;
+                return 1.0f - std::min(std::max(std::min(k, 4.0f - k), 0.0f), 1.0f);
+            }
+
+            // Hue in sextants (0-6) from 0-1 channels, 0 for greys
+            inline float Sextant(float r, float g, float b, float mx, float chroma)
+            {
+                float h = (mx == r) ? (g - b) / chroma : (mx == g) ? 2.0f + (b - r) / chroma : 4.0f + (r - g) / chroma;
+                h = (chroma > 0.0f) ? h : 0.0f;
+                return (h < 0.0f) ? h + 6.0f : h;
+            }
+
+            // Any angle in degrees to sextants 0-6
+            inline float WrapSextant(float degrees)
+            {
+                float h = degrees - static_cast<float>(static_cast<int>(degrees / 360.0f)) * 360.0f;
+                h = (h < 0.0f) ? h + 360.0f : h;
+                return h / 60.0f;
+            }
+            #pragma endregion
+
+            #pragma region Stages
+            inline void Transform(Block& b, size_t n, const Matrix3& matrix)
+            {
+                const float m00 = static_cast<float>(matrix.m[0][0]), m01 = static_cast<float>(matrix.m[0][1]), m02 = static_cast<float>(matrix.m[0][2]);
+                const float m10 = static_cast<float>(matrix.m[1][0]), m11 = static_cast<float>(matrix.m[1][1]), m12 = static_cast<float>(matrix.m[1][2]);
+                const float m20 = static_cast<float>(matrix.m[2][0]), m21 = static_cast<float>(matrix.m[2][1]), m22 = static_cast<float>(matrix.m[2][2]);
+
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    float x = b.c0[i], y = b.c1[i], z = b.c2[i];
+                    b.c0[i] = m00 * x + m01 * y + m02 * z;
+                    b.c1[i] = m10 * x + m11 * y + m12 * z;
+                    b.c2[i] = m20 * x + m21 * y + m22 * z;
+                }
+            }
+
+            inline void DecodeAll(Block& b, size_t n)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    b.c0[i] = DecodeSRGB(b.c0[i]);
+                    b.c1[i] = DecodeSRGB(b.c1[i]);
+                    b.c2[i] = DecodeSRGB(b.c2[i]);
+                }
+            }
+
+            inline void EncodeAll(Block& b, size_t n)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    b.c0[i] = EncodeSRGB(b.c0[i]);
+                    b.c1[i] = EncodeSRGB(b.c1[i]);
+                    b.c2[i] = EncodeSRGB(b.c2[i]);
+                }
+            }
+
+            inline void CbrtAll(Block& b, size_t n)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    b.c0[i] = Cbrt(b.c0[i]);
+                    b.c1[i] = Cbrt(b.c1[i]);
+                    b.c2[i] = Cbrt(b.c2[i]);
+                }
+            }
+
+            inline void CubeAll(Block& b, size_t n)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    b.c0[i] = b.c0[i] * b.c0[i] * b.c0[i];
+                    b.c1[i] = b.c1[i] * b.c1[i] * b.c1[i];
+                    b.c2[i] = b.c2[i] * b.c2[i] * b.c2[i];
+                }
+            }
+
+            // Cartesian (L, a, b) -> polar (L, C, H)
+            inline void ToPolar(Block& b, size_t n)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    float x = b.c1[i], y = b.c2[i];
+                    b.c1[i] = std::sqrt(x * x + y * y);
+                    b.c2[i] = HueDegrees(y, x);
+                }
+            }
+
+            inline void FromPolar(Block& b, size_t n)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    float s, c;
+                    SinCosDegrees(b.c2[i], s, c);
+                    float chroma = b.c1[i];
+                    b.c1[i] = chroma * c;
+                    b.c2[i] = chroma * s;
+                }
+            }
+
+            // XYZ D65 (0-100) -> CIE Lab
+            inline void XYZToLab(Block& b, size_t n)
+            {
+                auto f = [](float t) { return (t > 0.008856f) ? Cbrt(t) : (903.3f * t + 16.0f) / 116.0f; };
+
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    float fx = f(b.c0[i] / WhiteX);
+                    float fy = f(b.c1[i] / WhiteY);
+                    float fz = f(b.c2[i] / WhiteZ);
+                    b.c0[i] = 116.0f * fy - 16.0f;
+                    b.c1[i] = 500.0f * (fx - fy);
+                    b.c2[i] = 200.0f * (fy - fz);
+                }
+            }
+
+            inline void LabToXYZ(Block& b, size_t n)
+            {
+                auto fInv = [](float t) { return (t > 0.206893f) ? t * t * t : (t - 16.0f / 116.0f) / 7.787f; };
+
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    float fy = (b.c0[i] + 16.0f) / 116.0f;
+                    float fx = b.c1[i] / 500.0f + fy;
+                    float fz = fy - b.c2[i] / 200.0f;
+                    b.c0[i] = WhiteX * fInv(fx);
+                    b.c1[i] = WhiteY * fInv(fy);
+                    b.c2[i] = WhiteZ * fInv(fz);
+                }
+            }
+
+            // 0-1 sRGB -> HSL or HSV with hue 0-360 and the rest 0-100
+            template<bool HSV>
+            void RGBToHue(Block& b, size_t n)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    float r = b.c0[i], g = b.c1[i], bl = b.c2[i];
+                    float mx = std::max(std::max(r, g), bl);
+                    float mn = std::min(std::min(r, g), bl);
+                    float chroma = mx - mn;
+                    float s, third;
+
+                    if constexpr (HSV)
+                    {
+                        s = (mx > 0.0f) ? chroma / mx : 0.0f;
+                        third = mx;
+                    }
+                    else
+                    {
+                        third = (mx + mn) * 0.5f;
+                        s = (third > 0.0f && third < 1.0f) ? chroma / (1.0f - std::fabs(2.0f * third - 1.0f)) : 0.0f;
+                    }
+
+                    b.c0[i] = Sextant(r, g, bl, mx, chroma) * 60.0f;
+                    b.c1[i] = s * 100.0f;
+                    b.c2[i] = third * 100.0f;
+                }
+            }
+
+            template<bool HSV>
+            void HueToRGB(Block& b, size_t n)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    float h = WrapSextant(b.c0[i]);
+                    float s = b.c1[i] / 100.0f;
+                    float third = b.c2[i] / 100.0f;
+
+                    float chroma = HSV ? third * s : (1.0f - std::fabs(2.0f * third - 1.0f)) * s;
+                    float m = HSV ? third - chroma : third - chroma * 0.5f;
+
+                    b.c0[i] = m + chroma * HueChannel(h + 5.0f);
+                    b.c1[i] = m + chroma * HueChannel(h + 3.0f);
+                    b.c2[i] = m + chroma * HueChannel(h + 1.0f);
+                }
+            }
+            #pragma endregion
+
+            #pragma region Packing
+            // Exact 8-bit sRGB decode, built once from the Transfer tables
+            inline const float* DecodeTable()
+            {
+                static const struct Table
+                {
+                    float values[256];
+                    Table() { for (int i = 0; i < 256; ++i) values[i] = static_cast<float>(Transfer::Decode8(TransferCurve::sRGB, static_cast<uint8_t>(i))); }
+                } table;
+
+                return table.values;
+            }
+
+            inline void Unpack(const uint32_t* pixels, size_t n, Block& b)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                {
+                    uint32_t p = pixels[i];
+                    b.c0[i] = static_cast<float>((p >> 16) & 0xFF) / 255.0f;
+                    b.c1[i] = static_cast<float>((p >> 8) & 0xFF) / 255.0f;
+                    b.c2[i] = static_cast<float>(p & 0xFF) / 255.0f;
+                    b.alpha[i] = static_cast<float>(p >> 24);
+                }
+            }
+
+            inline void UnpackLinear(const uint32_t* pixels, size_t n, Block& b, const float* decode)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    uint32_t p = pixels[i];
+                    b.c0[i] = decode[(p >> 16) & 0xFF];
+                    b.c1[i] = decode[(p >> 8) & 0xFF];
+                    b.c2[i] = decode[p & 0xFF];
+                    b.alpha[i] = static_cast<float>(p >> 24);
+                }
+            }
+
+            inline uint32_t ToByte(float v) { return static_cast<uint32_t>(std::min(std::max(v * 255.0f + 0.5f, 0.0f), 255.0f)); }
+            inline uint32_t AlphaByte(float v) { return static_cast<uint32_t>(std::min(std::max(v + 0.5f, 0.0f), 255.0f)); }
+
+            inline void Pack(const Block& b, size_t n, uint32_t* pixels)
+            {
+                #pragma omp simd
+                for (size_t i = 0; i < n; ++i)
+                    pixels[i] = (AlphaByte(b.alpha[i]) << 24) | (ToByte(b.c0[i]) << 16) | (ToByte(b.c1[i]) << 8) | ToByte(b.c2[i]);
+            }
+
+            inline void PackLinear(const Block& b, size_t n, uint32_t* pixels)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    pixels[i] = (AlphaByte(b.alpha[i]) << 24)
+                              | (static_cast<uint32_t>(Transfer::EncodeByte(TransferCurve::sRGB, b.c0[i])) << 16)
+                              | (static_cast<uint32_t>(Transfer::EncodeByte(TransferCurve::sRGB, b.c1[i])) << 8)
+                              |  static_cast<uint32_t>(Transfer::EncodeByte(TransferCurve::sRGB, b.c2[i]));
+                }
+            }
+
+            inline void Interleave(const Block& b, size_t n, float* out)
+            {
+                for (size_t i = 0; i < n; ++i, out += 4)
+                {
+                    out[0] = b.c0[i];
+                    out[1] = b.c1[i];
+                    out[2] = b.c2[i];
+                    out[3] = b.alpha[i];
+                }
+            }
+
+            inline void Deinterleave(const float* values, size_t n, Block& b)
+            {
+                for (size_t i = 0; i < n; ++i, values += 4)
+                {
+                    b.c0[i] = values[0];
+                    b.c1[i] = values[1];
+                    b.c2[i] = values[2];
+                    b.alpha[i] = values[3];
+                }
+            }
+            #pragma endregion
+
+            // Cone response space OKLab is built on, a linear root that never leaves the pipeline
+            struct LMS
+            {
+                using Parent = void;
+                static constexpr Matrix3 ToLinear = Multiply(XYZ_D65ToLinear, LMSToXYZ);
+                static constexpr Matrix3 FromLinear = Multiply(XYZToLMS, LinearToXYZ_D65);
+            };
+        }
+
+        #pragma region Spaces
+        // Linear roots
+        struct LinearSRGB
+        {
+            using Parent = void;
+            static constexpr Detail::Matrix3 ToLinear = Detail::Identity;
+            static constexpr Detail::Matrix3 FromLinear = Detail::Identity;
+        };
+
+        // 0-100 like Color::ToXYZ_D65
+        struct XYZ_D65
+        {
+            using Parent = void;
+            static constexpr Detail::Matrix3 ToLinear = Detail::Scale(Detail::XYZ_D65ToLinear, 0.01);
+            static constexpr Detail::Matrix3 FromLinear = Detail::Scale(Detail::LinearToXYZ_D65, 100.0);
+        };
+
+        struct XYZ_D50
+        {
+            using Parent = void;
+            static constexpr Detail::Matrix3 ToLinear = Detail::XYZ_D50ToLinear;
+            static constexpr Detail::Matrix3 FromLinear = Detail::LinearToXYZ_D50;
+        };
+
+        // Derived spaces, ToParent/FromParent move a block one step towards/away from the root
+        struct SRGB
+        {
+            using Parent = LinearSRGB;
+            static void ToParent(Detail::Block& b, size_t n) { Detail::DecodeAll(b, n); }
+            static void FromParent(Detail::Block& b, size_t n) { Detail::EncodeAll(b, n); }
+        };
+
+        struct HSL
+        {
+            using Parent = SRGB;
+            static void ToParent(Detail::Block& b, size_t n) { Detail::HueToRGB<false>(b, n); }
+            static void FromParent(Detail::Block& b, size_t n) { Detail::RGBToHue<false>(b, n); }
+        };
+
+        struct HSV
+        {
+            using Parent = SRGB;
+            static void ToParent(Detail::Block& b, size_t n) { Detail::HueToRGB<true>(b, n); }
+            static void FromParent(Detail::Block& b, size_t n) { Detail::RGBToHue<true>(b, n); }
+        };
+
+        struct Lab
+        {
+            using Parent = XYZ_D65;
+            static void ToParent(Detail::Block& b, size_t n) { Detail::LabToXYZ(b, n); }
+            static void FromParent(Detail::Block& b, size_t n) { Detail::XYZToLab(b, n); }
+        };
+
+        struct LCHab
+        {
+            using Parent = Lab;
+            static void ToParent(Detail::Block& b, size_t n) { Detail::FromPolar(b, n); }
+            static void FromParent(Detail::Block& b, size_t n) { Detail::ToPolar(b, n); }
+        };
+
+        struct OKLab
+        {
+            using Parent = Detail::LMS;
+            static void ToParent(Detail::Block& b, size_t n) { Detail::Transform(b, n, Detail::OKLabToLMS); Detail::CubeAll(b, n); }
+            static void FromParent(Detail::Block& b, size_t n) { Detail::CbrtAll(b, n); Detail::Transform(b, n, Detail::LMSToOKLab); }
+        };
+
+        struct OKLCH
+        {
+            using Parent = OKLab;
+            static void ToParent(Detail::Block& b, size_t n) { Detail::FromPolar(b, n); }
+            static void FromParent(Detail::Block& b, size_t n) { Detail::ToPolar(b, n); }
+        };
+        #pragma endregion
+
+        namespace Detail
+        {
+            #pragma region Graph
+            // True if A is B or one of B's parents
+            template<typename A, typename B>
+            constexpr bool IsAncestor()
+            {
+                if constexpr (std::is_same_v<A, B>) return true;
+                else if constexpr (std::is_void_v<typename B::Parent>) return false;
+                else return IsAncestor<A, typename B::Parent>();
+            }
+
+            template<typename S, typename P = typename S::Parent>
+            struct RootOf { using Type = typename RootOf<P>::Type; };
+
+            template<typename S>
+            struct RootOf<S, void> { using Type = S; };
+
+            // Nearest space both A and B descend from, void when they sit under different roots
+            template<typename A, typename B>
+            struct CommonOf { using Type = std::conditional_t<IsAncestor<A, B>(), A, typename CommonOf<typename A::Parent, B>::Type>; };
+
+            template<typename B>
+            struct CommonOf<void, B> { using Type = void; };
+
+            // Root to root in one matrix, folded at compile time
+            template<typename From, typename To>
+            inline constexpr Matrix3 BridgeMatrix = Multiply(To::FromLinear, From::ToLinear);
+
+            template<typename From, typename To>
+            void Up(Block& b, size_t n)
+            {
+                if constexpr (!std::is_same_v<From, To>)
+                {
+                    From::ToParent(b, n);
+                    Up<typename From::Parent, To>(b, n);
+                }
+            }
+
+            template<typename From, typename To>
+            void Down(Block& b, size_t n)
+            {
+                if constexpr (!std::is_same_v<From, To>)
+                {
+                    Down<From, typename To::Parent>(b, n);
+                    To::FromParent(b, n);
+                }
+            }
+
+            template<typename Src, typename Dst>
+            void ConvertBlock(Block& b, size_t n)
+            {
+                using Common = typename CommonOf<Src, Dst>::Type;
+
+                if constexpr (!std::is_void_v<Common>)
+                {
+                    Up<Src, Common>(b, n);
+                    Down<Common, Dst>(b, n);
+                }
+                else
+                {
+                    using SrcRoot = typename RootOf<Src>::Type;
+                    using DstRoot = typename RootOf<Dst>::Type;
+
+                    Up<Src, SrcRoot>(b, n);
+                    Transform(b, n, BridgeMatrix<SrcRoot, DstRoot>);
+                    Down<DstRoot, Dst>(b, n);
+                }
+            }
+            #pragma endregion
+        }
+
+        // SRGB is read and written as packed ARGB pixels, every other space as four floats per colour:
+        // the components in Color::To* units followed by alpha (0-255)
+        template<typename S>
+        using PixelType = std::conditional_t<std::is_same_v<S, SRGB>, uint32_t, float>;
+
+        // Converts `count` colours from Src to Dst. When a packed SRGB end has to go through linear light
+        // the transfer curve is folded into the load/store (exact tables, rounded to nearest) instead
+        // of running as a separate stage
+        template<typename Src, typename Dst>
+        void ConvertPixels(const PixelType<Src>* in, size_t count, PixelType<Dst>* out)
+        {
+            constexpr bool decodeOnLoad = std::is_same_v<Src, SRGB> && !Detail::IsAncestor<SRGB, Dst>();
+            constexpr bool encodeOnStore = std::is_same_v<Dst, SRGB> && !Detail::IsAncestor<SRGB, Src>();
+            using From = std::conditional_t<decodeOnLoad, LinearSRGB, Src>;
+            using To = std::conditional_t<encodeOnStore, LinearSRGB, Dst>;
+
+            const float* decode = decodeOnLoad ? Detail::DecodeTable() : nullptr;
+
+            Scheduler::ForEachRange(count, Detail::BlockSize, [&](size_t begin, size_t n)
+            {
+                Detail::Block b;
+
+                if constexpr (decodeOnLoad) Detail::UnpackLinear(in + begin, n, b, decode);
+                else if constexpr (std::is_same_v<Src, SRGB>) Detail::Unpack(in + begin, n, b);
+                else Detail::Deinterleave(in + begin * 4, n, b);
+
+                Detail::ConvertBlock<From, To>(b, n);
+
+                if constexpr (encodeOnStore) Detail::PackLinear(b, n, out + begin);
+                else if constexpr (std::is_same_v<Dst, SRGB>) Detail::Pack(b, n, out + begin);
+                else Detail::Interleave(b, n, out + begin * 4);
+            });
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace KTLib
+{
+    // Color spaces supported by the batch conversions. The values are part of the DLL interface
+    enum class ColorSpace
+    {
+        LinearSRGB,
+        XYZ_D65,
+        XYZ_D50,
+        Lab,
+        LCHab,
+        OKLab,
+        OKLCH,
+        HSL,
+        HSV
+    };
+
+    namespace ColorSpaces
+    {
+        // Runtime front end over ConvertPixels (ColorPipeline.hpp), which fuses fixed pairs of spaces at compile time
+
+        // Converts `count` packed ARGB values to `space`. `out` receives four floats per colour: the three
+        // components in the same units as the matching Color::To* method, then alpha (0-255)
+        void FromPixels(ColorSpace space, const uint32_t* pixels, size_t count, float* out);
+
+        // The reverse, reading four floats per colour like Color::From*. Channels are rounded to nearest
+        // so a FromPixels/ToPixels round trip gives back the original pixels
+        void ToPixels(ColorSpace space, const float* values, size_t count, uint32_t* pixels);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace KTLib
+{
+    // What Canvas::Convolve does with the alpha channel
+    enum class ConvolveAlpha
+    {
+        Convolve, // Filtered like the colour channels
+        Keep,     // Left as it was
+        Opaque    // Set to 255
+    };
+
+    // A width x height kernel anchored at its centre pixel (width / 2, height / 2). Each output channel is the
+    // weighted sum of its neighbourhood plus `bias`, rounded and clamped to 0-255. Weights are used as given,
+    // nothing normalises them. How the kernel runs is worked out once here: small kernels whose weights fit
+    // 16-bit fixed point accumulate in integers, rank one kernels run as a row pass and a column pass
+    class ConvolutionKernel
+    {
+        public:
+            ConvolutionKernel(int width, int height, std::vector<float> weights, float bias = 0.0f);
+
+            int GetWidth() const { return m_width; }
+            int GetHeight() const { return m_height; }
+            const std::vector<float>& GetWeights() const { return m_weights; }
+            float GetBias() const { return m_bias; }
+
+            // weights[y][x] == column[y] * row[x] for every tap, up to float rounding
+            bool IsSeparable() const { return !m_row.empty(); }
+            const std::vector<float>& GetRowFactor() const { return m_row; }
+            const std::vector<float>& GetColumnFactor() const { return m_column; }
+
+            // Weights scaled by 2^GetFixedShift() and rounded, empty when the kernel is too large for the
+            // integer path or rounding would cost more than FixedPointTolerance of a channel
+            bool IsFixedPoint() const { return !m_fixed.empty(); }
+            const std::vector<int16_t>& GetFixedWeights() const { return m_fixed; }
+            int GetFixedShift() const { return m_fixedShift; }
+
+            static constexpr int MaxFixedPointTaps = 49;
+            static constexpr float FixedPointTolerance = 0.5f;
+
+        private:
+            void FindFactors();
+            void FindFixedPoint();
+
+            int m_width;
+            int m_height;
+            std::vector<float> m_weights;
+            float m_bias;
+
+            std::vector<float> m_row;
+            std::vector<float> m_column;
+
+            std::vector<int16_t> m_fixed;
+            int m_fixedShift = 0;
+    };
+}
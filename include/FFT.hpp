@@ -0,0 +1,82 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace KTLib
+{
+    namespace FFT
+    {
+        using Complex = std::complex<double>;
+
+        // Smallest length >= n made only of the factors 2, 3 and 5, the lengths Plan is fastest at
+        size_t GoodSize(size_t n);
+
+        // A complex transform of one length, mixed radix and self-sorting, so data goes in and comes out in
+        // natural order. Any length works, lengths with prime factors above 5 fall back to a plain DFT for
+        // those factors. A plan is read-only once built and can be shared between threads
+        class Plan
+        {
+            public:
+                explicit Plan(size_t length);
+
+                size_t GetLength() const { return m_length; }
+
+                // Forward is unscaled with e^(-2 pi i k n / length), Inverse uses e^(+...) and divides by the
+                // length, so one undoes the other. `scratch` must hold GetLength() values
+                void Forward(Complex* data, Complex* scratch) const;
+                void Inverse(Complex* data, Complex* scratch) const;
+
+            private:
+                struct Stage
+                {
+                    size_t radix;
+                    size_t span;                   // Product of the radices before this stage
+                    std::vector<Complex> twiddles; // (radix - 1) per k < span, e^(-2 pi i k r / (span * radix))
+                    std::vector<Complex> roots;    // e^(-2 pi i q / radix), for radices without a hand-written butterfly
+                };
+
+                void Transform(Complex* data, Complex* scratch, bool inverse) const;
+
+                size_t m_length;
+                std::vector<Stage> m_stages;
+        };
+
+        // The 2D transform of a real width x height image. Real input has a Hermitian spectrum, so only the
+        // width / 2 + 1 non-negative horizontal frequencies are kept, for every vertical one. Rows are
+        // transformed two at a time as the real and imaginary halves of one complex row, columns in blocks,
+        // both spread over the scheduler
+        class Spectrum
+        {
+            public:
+                Spectrum(size_t width, size_t height);
+
+                size_t GetWidth() const { return m_width; }
+                size_t GetHeight() const { return m_height; }
+                size_t GetBins() const { return m_bins; }
+
+                // Bin (kx, ky) for kx < GetBins() and ky < GetHeight()
+                Complex* Row(size_t ky) { return m_data.data() + ky * m_bins; }
+                const Complex* Row(size_t ky) const { return m_data.data() + ky * m_bins; }
+
+                // Transforms width * height values with rows `stride` apart into the spectrum
+                void Forward(const double* image, size_t stride);
+
+                // Transforms the spectrum back into the image, scaled so Inverse(Forward(x)) == x. The spectrum
+                // is used up doing it
+                void Inverse(double* image, size_t stride);
+
+                // Multiplies every bin by the matching bin of `other`, which must be the same size
+                void Multiply(const Spectrum& other);
+
+            private:
+                size_t m_width;
+                size_t m_height;
+                size_t m_bins;
+                Plan m_rowPlan;
+                Plan m_columnPlan;
+                std::vector<Complex> m_data;
+        };
+    }
+}
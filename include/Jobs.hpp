@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Canvas.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace KTLib
+{
+    // Background execution of Canvas operations. Jobs run one after another on a single job thread, the
+    // operations inside them still spread across the Scheduler pool, which they share with whatever the
+    // calling thread runs in the meantime
+    namespace Jobs
+    {
+        enum class JobState
+        {
+            Pending,   // Built but not started yet
+            Queued,
+            Running,
+            Completed,
+            Cancelled,
+            Failed
+        };
+
+        using Operation = std::function<void(Canvas&)>;
+
+        // Looks an operation up by the name of the Canvas method it runs, e.g. "GaussianBlur". Missing
+        // trailing arguments take the same defaults as the AHK wrappers
+        Operation MakeOperation(const std::string& name, const std::vector<double>& args);
+
+        class Job
+        {
+            public:
+                explicit Job(Canvas* canvas);
+
+                // Cancels and waits, the canvas must not be touched by a job that no longer exists
+                ~Job();
+
+                Job(const Job&) = delete;
+                Job& operator=(const Job&) = delete;
+
+                void Add(Operation operation);
+
+                // Queues the job. From here until it finishes the canvas is locked, see WaitForCanvas
+                void Start();
+
+                // Skips every operation that has not started yet, the one running finishes first
+                void Cancel();
+
+                // Returns true once the job has finished, timeoutMs < 0 waits indefinitely
+                bool Wait(int timeoutMs = -1);
+
+                JobState GetState() const { return m_state.load(); }
+
+                // Fraction of operations finished, 0-1
+                double GetProgress() const;
+
+                const std::string& GetError() const { return m_error; }
+
+            private:
+                friend class Runner;
+
+                void Run(const std::atomic<bool>& stopping);
+                void Finish(JobState state);
+
+                Canvas* m_canvas;
+                std::vector<Operation> m_operations;
+                std::atomic<JobState> m_state{JobState::Pending};
+                std::atomic<size_t> m_completed{0};
+                std::atomic<bool> m_cancelled{false};
+                std::string m_error;
+
+                mutable std::mutex m_mutex;
+                std::condition_variable m_finished;
+        };
+
+        // Blocks until no started job is using `canvas` and returns it. Every export that touches a
+        // canvas goes through this, so synchronous calls queue up behind the canvas's jobs. A view
+        // counts as its parent, see Canvas::View
+        Canvas* WaitForCanvas(Canvas* canvas);
+
+        // Cancels everything queued and joins the job thread, see Scheduler::Shutdown
+        void Shutdown();
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Color.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace KTLib
+{
+    namespace Kernels
+    {
+        enum class Level
+        {
+            Scalar,
+            SSE2,
+            AVX2
+        };
+
+        // Highest instruction set supported by the running CPU, detected once
+        Level GetSupportedLevel();
+
+        // Instruction set the kernels currently dispatch to, never higher than GetSupportedLevel()
+        Level GetLevel();
+        void SetLevel(Level level);
+
+        // A ColorMatrix pre-scaled for 0-255 channels: out = m * (r, g, b, a) + offset
+        struct MatrixCoefficients
+        {
+            alignas(16) float m[4][4];
+            alignas(16) float offset[4];
+
+            MatrixCoefficients() = default;
+            explicit MatrixCoefficients(const ColorMatrix& matrix);
+        };
+
+        // Applies the matrix to `count` packed ARGB pixels in place
+        void ApplyMatrix(uint32_t* pixels, size_t count, const MatrixCoefficients& coefficients);
+
+        enum class ComponentShift
+        {
+            Hue,
+            Saturation,
+            Lightness,
+            Value,
+            Intensity
+        };
+
+        // Shifts one HSL/HSV/HSI component of `count` packed ARGB pixels in place, `amount` means the
+        // same as for the matching Color::Shift* method
+        void ShiftComponent(uint32_t* pixels, size_t count, ComponentShift component, double amount);
+
+        // Float pixels are 4 floats in R G B A order on a 0-1 scale. Nothing clamps them until they are
+        // quantized back to 8 bits, which rounds to nearest
+        void ExpandPixels(const uint32_t* pixels, size_t count, float* values);
+        void QuantizePixels(const float* values, size_t count, uint32_t* pixels);
+
+        // The 0-1 matrix applied to `count` float pixels in place, without clamping
+        void ApplyMatrix(float* values, size_t count, const ColorMatrix& matrix);
+
+        // One nonzero weight of an integer convolution kernel: `row` indexes the source rows passed alongside,
+        // `column` is the offset from the output pixel's column
+        struct FixedTap
+        {
+            int row;
+            int column;
+            int16_t weight;
+        };
+
+        // One output row of a fixed-point convolution, each channel (offset + sum of weight * channel) >> shift
+        // clamped to 0-255. `offset` carries the bias and the rounding half. Reads run up to count - 1 plus the
+        // largest tap column past each row pointer, so the source must be padded
+        void ConvolveFixed(const uint32_t* const* rows, const FixedTap* taps, size_t tapCount, int shift, int32_t offset, size_t count, uint32_t* dest);
+
+        // Float convolution pieces. acc holds 4 floats per pixel in memory byte order (B G R A); AccumulateTaps
+        // adds weights[j] * source[x + j] for j < taps, PackChannels rounds acc + bias into clamped pixels
+        void AccumulateTaps(const uint32_t* source, const float* weights, int taps, size_t count, float* acc);
+        void PackChannels(const float* acc, size_t count, float bias, uint32_t* dest);
+
+        // Recursive (IIR) Gaussian for one sigma: a third order forward and backward pass whose cost per sample
+        // does not depend on sigma. Meant for sigma of about 1 and up, below that the fit falls apart
+        struct GaussianCoefficients
+        {
+            double gain;
+            double feedback[3];
+            double edge[3][3]; // Backward pass start state for a clamped right edge, see the constructor
+
+            explicit GaussianCoefficients(double sigma);
+        };
+
+        // Blurs `width` independent signals in place. Sample i of every signal is in the i-th of `length` runs
+        // of `width` floats, `step` floats apart, so a strip of rows blurs its columns and a block of pixels
+        // transposed to x-major order blurs its rows. Edges behave as if the end samples repeated
+        void RecursiveGaussian(float* values, size_t width, size_t length, ptrdiff_t step, const GaussianCoefficients& g);
+
+        // Scales each pixel's colour channels by its alpha, rounding to nearest. Unpremultiply divides it
+        // back out, fully transparent pixels become 0 and precision lost to rounding stays lost
+        void Premultiply(uint32_t* pixels, size_t count);
+        void Unpremultiply(uint32_t* pixels, size_t count);
+
+        // Premultiplied source-over: dest = source * opacity + dest * (1 - source alpha * opacity), with
+        // `opacity` on a 0-255 scale. Every level produces the same bits
+        void CompositeOver(uint32_t* dest, const uint32_t* source, size_t count, uint32_t opacity);
+
+        // Box blur building blocks. Running sums are 4 ints per pixel in memory byte order (B G R A) and
+        // averages truncate like integer division at every level
+        constexpr int MaxBoxWindow = 65536;
+
+        // Averages each pixel of a row over [x - radius, x + radius], clipped to the row
+        void BoxBlurRow(const uint32_t* source, uint32_t* dest, int width, int radius);
+
+        // Adds the `entering` row to and subtracts the `leaving` row from `count` columns' sums, either may be null
+        void SlideColumns(int32_t* sums, const uint32_t* entering, const uint32_t* leaving, size_t count);
+        void AverageColumns(const int32_t* sums, size_t count, int divisor, uint32_t* dest);
+    }
+}
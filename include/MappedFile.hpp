@@ -0,0 +1,45 @@
+#pragma once
+
+#include <windows.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace KTLib
+{
+    // A whole file mapped into the address space. Nothing is read up front, the OS pages the file in as it
+    // is touched and can drop clean pages again under memory pressure
+    class MappedFile
+    {
+        public:
+            // Creates `path`, or truncates it if it exists, at `size` zeroed bytes and maps it read-write
+            static std::unique_ptr<MappedFile> Create(const std::string& path, uint64_t size);
+
+            // Maps an existing file. Without `writable` the file is opened read-only and anything written to the
+            // mapping goes to private copy-on-write pages that never reach the file
+            static std::unique_ptr<MappedFile> Open(const std::string& path, bool writable);
+
+            ~MappedFile();
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            uint8_t* GetData() const { return m_data; }
+            uint64_t GetSize() const { return m_size; }
+            bool IsWritable() const { return m_writable; }
+
+            // Writes dirty pages back to the file, does nothing for a read-only mapping
+            void Flush() const;
+
+        private:
+            MappedFile() = default;
+
+            void Map(const std::string& path, DWORD protect, DWORD access);
+
+            HANDLE m_file = INVALID_HANDLE_VALUE;
+            HANDLE m_mapping = nullptr;
+            uint8_t* m_data = nullptr;
+            uint64_t m_size = 0;
+            bool m_writable = false;
+    };
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+
+#include "Constants.h"
+
+namespace KTLib
+{
+    // Counter-based random numbers: every value is a pure function of (seed, index, stream), so a parallel
+    // pass can draw for pixel i on whatever thread handles it and still produce the same image for a seed
+    namespace Random
+    {
+        using Block = std::array<uint32_t, 4>;
+
+        #pragma region Philox4x32-10
+        namespace Detail
+        {
+            constexpr uint32_t Multiplier0 = 0xD2511F53, Multiplier1 = 0xCD9E8D57;
+            constexpr uint32_t Weyl0 = 0x9E3779B9, Weyl1 = 0xBB67AE85;
+
+            inline void Round(Block& counter, uint32_t key0, uint32_t key1)
+            {
+                uint64_t product0 = static_cast<uint64_t>(Multiplier0) * counter[0];
+                uint64_t product1 = static_cast<uint64_t>(Multiplier1) * counter[2];
+                counter = {
+                    static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key0,
+                    static_cast<uint32_t>(product1),
+                    static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key1,
+                    static_cast<uint32_t>(product0)
+                };
+            }
+
+            // 53 random bits as a double in [0, 1)
+            inline double ToUnit(uint32_t high, uint32_t low) { return ((static_cast<uint64_t>(high) << 21) ^ (low >> 11)) * 0x1.0p-53; }
+        }
+
+        // 128 random bits for one (seed, index, stream) triple
+        inline Block Philox(uint64_t seed, uint64_t index, uint64_t stream = 0)
+        {
+            Block counter = { static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32) };
+            uint32_t key0 = static_cast<uint32_t>(seed), key1 = static_cast<uint32_t>(seed >> 32);
+
+            for (int round = 0; round < 9; ++round)
+            {
+                Detail::Round(counter, key0, key1);
+                key0 += Detail::Weyl0;
+                key1 += Detail::Weyl1;
+            }
+            Detail::Round(counter, key0, key1);
+
+            return counter;
+        }
+        #pragma endregion
+
+        #pragma region Distributions
+        inline uint32_t Bits(uint64_t seed, uint64_t index, uint64_t stream = 0) { return Philox(seed, index, stream)[0]; }
+
+        // Uniform in [0, 1)
+        inline double Uniform(uint64_t seed, uint64_t index, uint64_t stream = 0)
+        {
+            Block block = Philox(seed, index, stream);
+            return Detail::ToUnit(block[0], block[1]);
+        }
+
+        // Uniform in [0, bound), multiply-shift instead of a modulo
+        inline uint32_t Below(uint32_t bound, uint64_t seed, uint64_t index, uint64_t stream = 0)
+        {
+            return static_cast<uint32_t>((static_cast<uint64_t>(Bits(seed, index, stream)) * bound) >> 32);
+        }
+
+        // Standard normal from one block (Box-Muller)
+        inline double Normal(uint64_t seed, uint64_t index, uint64_t stream = 0)
+        {
+            Block block = Philox(seed, index, stream);
+            double u1 = 1.0 - Detail::ToUnit(block[0], block[1]); // (0, 1], keeps log away from zero
+            double u2 = Detail::ToUnit(block[2], block[3]);
+            return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * CONST_PI * u2);
+        }
+        #pragma endregion
+
+        #pragma region Seeds
+        // A fresh seed for callers that did not ask for a reproducible result
+        inline uint64_t NewSeed()
+        {
+            static std::atomic<uint64_t> calls{0};
+            uint64_t entropy = (static_cast<uint64_t>(std::random_device{}()) << 32) ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+            Block block = Philox(entropy, calls.fetch_add(1, std::memory_order_relaxed));
+            return (static_cast<uint64_t>(block[0]) << 32) | block[1];
+        }
+
+        // Seed 0 means "any seed", every other value reproduces the same output
+        inline uint64_t ResolveSeed(uint64_t seed) { return seed != 0 ? seed : NewSeed(); }
+        #pragma endregion
+
+        // Sequential draws for serial code (permutation tables, point sets). Satisfies
+        // UniformRandomBitGenerator, but the members below avoid the implementation-defined std distributions
+        class Stream
+        {
+            public:
+                using result_type = uint32_t;
+
+                explicit Stream(uint64_t seed, uint64_t stream = 0) : m_seed(seed), m_stream(stream) { }
+
+                static constexpr result_type min() { return 0; }
+                static constexpr result_type max() { return UINT32_MAX; }
+
+                result_type operator()() { return Bits(m_seed, m_index++, m_stream); }
+                double Uniform() { return Random::Uniform(m_seed, m_index++, m_stream); }
+                uint32_t Below(uint32_t bound) { return Random::Below(bound, m_seed, m_index++, m_stream); }
+
+                // Fisher-Yates with Below, so a seed gives the same order on every standard library
+                template<typename Iterator>
+                void Shuffle(Iterator first, Iterator last)
+                {
+                    for (auto i = last - first - 1; i > 0; --i)
+                        std::swap(first[i], first[Below(static_cast<uint32_t>(i + 1))]);
+                }
+
+            private:
+                uint64_t m_seed;
+                uint64_t m_stream;
+                uint64_t m_index = 0;
+        };
+    }
+}
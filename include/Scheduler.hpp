@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace KTLib
+{
+    // Thread pool shared by every Canvas operation. Work is split into tasks up front, each thread starts on
+    // its own contiguous share of them and steals half of the fullest remaining share once it runs dry.
+    // Operations started from different threads at once run side by side, idle workers join whichever has
+    // the fewest helpers
+    namespace Scheduler
+    {
+        // Threads used per operation, including the calling thread. 0 picks one per hardware thread
+        void SetThreadCount(int count);
+        int GetThreadCount();
+
+        // Joins the worker threads, they are started again on the next operation. Must be called before
+        // the DLL is unloaded, joining them from a static destructor would deadlock on the loader lock
+        void Shutdown();
+
+        // Runs task(context, i) for every i in [0, count) and returns when all of them have finished.
+        // Any thread may call this, concurrent calls share the workers rather than waiting for each other.
+        // Calls made from inside a task run inline on that thread. The first exception a task throws
+        // stops the remaining tasks and is rethrown here
+        void Run(size_t count, void (*task)(void* context, size_t index), void* context);
+
+        template<typename Func>
+        void For(size_t count, Func&& func)
+        {
+            using F = std::remove_reference_t<Func>;
+            Run(count, [](void* context, size_t index) { (*static_cast<F*>(context))(index); }, const_cast<void*>(static_cast<const void*>(std::addressof(func))));
+        }
+
+        // func(begin, length) over consecutive ranges of at most `grain` items
+        template<typename Func>
+        void ForEachRange(size_t count, size_t grain, Func&& func)
+        {
+            For((count + grain - 1) / grain, [&](size_t i)
+            {
+                size_t begin = i * grain;
+                func(begin, std::min(grain, count - begin));
+            });
+        }
+
+        #pragma region Tiles
+        // 256 x 32 packed pixels is 32 KB, small enough to stay in cache while a filter works on it
+        constexpr int TileWidth = 256;
+        constexpr int TileHeight = 32;
+
+        // Square tiles for passes that read the source along a different axis than they write it
+        // (rotation, resampling), a wide short tile would touch a new source cache line per pixel
+        constexpr int SquareTileSize = 64;
+
+        // `index` only depends on the image size and the tile position, so per-tile state can be kept in a
+        // vector and combined in a fixed order afterwards
+        struct Tile
+        {
+            int x, y, width, height;
+            size_t index;
+        };
+
+        inline size_t TilesAcross(int width, int tileWidth = TileWidth)
+        {
+            return static_cast<size_t>((width + tileWidth - 1) / tileWidth);
+        }
+
+        inline size_t TileCount(int width, int height, int tileWidth = TileWidth, int tileHeight = TileHeight)
+        {
+            if (width <= 0 || height <= 0) return 0;
+            return TilesAcross(width, tileWidth) * static_cast<size_t>((height + tileHeight - 1) / tileHeight);
+        }
+
+        inline Tile GetTile(int width, int height, size_t index, int tileWidth = TileWidth, int tileHeight = TileHeight)
+        {
+            size_t across = TilesAcross(width, tileWidth);
+            int x = static_cast<int>(index % across) * tileWidth;
+            int y = static_cast<int>(index / across) * tileHeight;
+            return { x, y, std::min(tileWidth, width - x), std::min(tileHeight, height - y), index };
+        }
+
+        template<typename Func>
+        void ForEachTile(int width, int height, int tileWidth, int tileHeight, Func&& func)
+        {
+            For(TileCount(width, height, tileWidth, tileHeight), [&](size_t i)
+            {
+                func(GetTile(width, height, i, tileWidth, tileHeight));
+            });
+        }
+
+        template<typename Func>
+        void ForEachTile(int width, int height, Func&& func)
+        {
+            ForEachTile(width, height, TileWidth, TileHeight, std::forward<Func>(func));
+        }
+
+        // func(x, y, index) for every pixel of a width x height image, tile by tile
+        template<typename Func>
+        void ForEachPixel(int width, int height, int tileWidth, int tileHeight, Func&& func)
+        {
+            ForEachTile(width, height, tileWidth, tileHeight, [&](const Tile& tile)
+            {
+                for (int y = tile.y; y < tile.y + tile.height; ++y)
+                {
+                    size_t index = static_cast<size_t>(y) * width + tile.x;
+                    for (int x = tile.x; x < tile.x + tile.width; ++x, ++index) func(x, y, index);
+                }
+            });
+        }
+
+        template<typename Func>
+        void ForEachPixel(int width, int height, Func&& func)
+        {
+            ForEachPixel(width, height, TileWidth, TileHeight, std::forward<Func>(func));
+        }
+
+        // tileFunc(tile) gives each tile's partial result, they are combined in tile order so the
+        // result never depends on which thread ran what
+        template<typename T, typename TileFunc, typename Combine>
+        T ReduceTiles(int width, int height, T identity, TileFunc&& tileFunc, Combine&& combine)
+        {
+            std::vector<T> partials(TileCount(width, height), identity);
+            ForEachTile(width, height, [&](const Tile& tile) { partials[tile.index] = tileFunc(tile); });
+
+            T result = identity;
+            for (const T& partial : partials) result = combine(result, partial);
+            return result;
+        }
+        #pragma endregion
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace KTLib
+{
+    // Transfer (gamma) curves of the RGB spaces Color converts to. Display P3 shares the sRGB curve
+    enum class TransferCurve
+    {
+        sRGB,
+        AdobeRGB,
+        ProPhoto,
+        Rec2020
+    };
+
+    namespace Transfer
+    {
+        // Reference curves evaluated with std::pow, encoded and linear values are both 0-1
+        double DecodeExact(TransferCurve curve, double encoded);
+        double EncodeExact(TransferCurve curve, double linear);
+
+        // Table-driven curves used by the Color conversions. Decode8 is an exact 256 entry lookup,
+        // Decode and Encode interpolate a dense table and fall back to the exact curve near zero
+        // (where the power segments are too steep to interpolate) and outside 0-1
+        double Decode8(TransferCurve curve, uint8_t encoded);
+        double Decode(TransferCurve curve, double encoded);
+        double Encode(TransferCurve curve, double linear);
+
+        // Linear 0-1 straight to the nearest 8-bit code, exact and table-driven
+        uint8_t EncodeByte(TransferCurve curve, float linear);
+
+        // Packed ARGB pixels <-> linear RGBA floats, four per pixel with alpha scaled to 0-1.
+        // EncodePixels rounds to nearest so a round trip gives back the same pixels
+        void DecodePixels(TransferCurve curve, const uint32_t* pixels, size_t count, float* linear);
+        void EncodePixels(TransferCurve curve, const float* linear, size_t count, uint32_t* pixels);
+    }
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../Canvas.hpp"
+#include "../Jobs.hpp"
+#include "../Scheduler.hpp"
 
 extern "C"
 {
@@ -12,6 +14,11 @@ extern "C"
     COLOR_API Canvas* CreateCanvasFromBuffer(unsigned int* buffer, int width, int height);
     COLOR_API Canvas* CreateCanvasFromGradient(Gradient* gradient, int width, int height);
 
+    COLOR_API Canvas* CreateCanvasFromMemory(void* pixels, int width, int height, int stride, int format);
+    COLOR_API Canvas* CreateCanvasFromDIBSection(HBITMAP hBitmap);
+    COLOR_API Canvas* CreateCanvasMapped(const char* path, int width, int height, Color* col);
+    COLOR_API Canvas* OpenCanvasMapped(const char* path, int writable);
+
     COLOR_API HBITMAP ExportCanvasAsHBITMAP(Canvas* buffer, int targetWidth, int targetHeight);
     COLOR_API Canvas* CreateCanvasFromHBITMAP(HBITMAP hBitmap, int width, int height);
 
@@ -44,12 +51,17 @@ extern "C"
 
     COLOR_API int GetCanvasWidth(Canvas* buffer);
     COLOR_API int GetCanvasHeight(Canvas* buffer);
-    COLOR_API int GetCanvasSize(Canvas* buffer);
+    COLOR_API int64_t GetCanvasSize(Canvas* buffer);
     COLOR_API int GetCanvasStride(Canvas* buffer);
-    COLOR_API Color* CanvasGetAt(Canvas* buffer, int index);
-    COLOR_API void CanvasSetAt(Canvas* buffer, int index, Color* color);
-    COLOR_API void CanvasGetXY(Canvas* buffer, int index, int* x, int* y);
-    COLOR_API void CanvasGetIndex(Canvas* buffer, int x, int y, int* index);
+    COLOR_API uint32_t* GetCanvasPixels(Canvas* buffer);
+    COLOR_API int GetCanvasFormat(Canvas* buffer);
+    COLOR_API int IsCanvasWrapped(Canvas* buffer);
+    COLOR_API int IsCanvasMapped(Canvas* buffer);
+    COLOR_API void FlushCanvasMapped(Canvas* buffer);
+    COLOR_API Color* CanvasGetAt(Canvas* buffer, int64_t index);
+    COLOR_API void CanvasSetAt(Canvas* buffer, int64_t index, Color* color);
+    COLOR_API void CanvasGetXY(Canvas* buffer, int64_t index, int* x, int* y);
+    COLOR_API void CanvasGetIndex(Canvas* buffer, int x, int y, int64_t* index);
 
     COLOR_API unsigned int GetColorIntFromBuffer(Canvas* buffer, int x, int y);
     COLOR_API void SetColorIntInBuffer(Canvas* buffer, int x, int y, unsigned int colorInt);
@@ -74,8 +86,13 @@ extern "C"
     COLOR_API void GrayscaleCanvas(Canvas* buffer);
     COLOR_API void SepiaCanvas(Canvas* buffer, double factor);
     COLOR_API void PixelateCanvas(Canvas* buffer, int pixelSize);
-    COLOR_API void BlurCanvas(Canvas* buffer, int radius);
-    COLOR_API void GaussianBlurCanvas(Canvas* buffer, int radius);
+    COLOR_API void BlurCanvas(Canvas* buffer, int radius, int passes);
+    COLOR_API void GaussianBlurCanvas(Canvas* buffer, double sigma);
+    COLOR_API void GaussianBlurRadiusCanvas(Canvas* buffer, int radius);
+    COLOR_API void ConvolveCanvas(Canvas* buffer, int width, int height, const float* weights, float bias, int alpha);
+    COLOR_API void LowPassCanvas(Canvas* buffer, double cutoff);
+    COLOR_API void HighPassCanvas(Canvas* buffer, double cutoff);
+    COLOR_API double PhaseCorrelateCanvas(Canvas* buffer, Canvas* other, double* dx, double* dy);
     COLOR_API void SharpenCanvas(Canvas* buffer, float amount);
     COLOR_API void CrossProcessCanvas(Canvas* buffer, double factor);
     COLOR_API void MoonlightCanvas(Canvas* buffer, double factor);
@@ -86,14 +103,14 @@ extern "C"
     COLOR_API void ApplyEmbossCanvas(Canvas* buffer);
     COLOR_API void ApplyEdgeDetectCanvas(Canvas* buffer);
     COLOR_API void ApplyVignetteCanvas(Canvas* buffer, double strength, double radius);
-    COLOR_API void ApplyTwoColorNoiseCanvas(Canvas* buffer, double density, Color* saltColor, Color* pepperColor);
-    COLOR_API void ApplyGaussianNoiseCanvas(Canvas* buffer, double mean, double stdDev);
-    COLOR_API void ApplyPerlinNoiseCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity);
-    COLOR_API void ApplySimplexNoiseCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity);
-    COLOR_API void ApplyFractalBrownianMotionCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity);
-    COLOR_API void ApplyVoronoiDiagramCanvas(Canvas* buffer, int numberOfPoints, double falloff, double strength);
+    COLOR_API void ApplyTwoColorNoiseCanvas(Canvas* buffer, double density, Color* saltColor, Color* pepperColor, uint64_t seed);
+    COLOR_API void ApplyGaussianNoiseCanvas(Canvas* buffer, double mean, double stdDev, uint64_t seed);
+    COLOR_API void ApplyPerlinNoiseCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed);
+    COLOR_API void ApplySimplexNoiseCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed);
+    COLOR_API void ApplyFractalBrownianMotionCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed);
+    COLOR_API void ApplyVoronoiDiagramCanvas(Canvas* buffer, int numberOfPoints, double falloff, double strength, uint64_t seed);
     COLOR_API void PlasmaEffectCanvas(Canvas* buffer, double frequency, double phase);
-    COLOR_API void DiamondSquareEffectCanvas(Canvas* buffer, double roughness, double waterLevel, double levelsPerStop);
+    COLOR_API void DiamondSquareEffectCanvas(Canvas* buffer, double roughness, double waterLevel, double levelsPerStop, uint64_t seed);
     COLOR_API void PosterizeCanvas(Canvas* buffer, int levels);
     #pragma endregion
 
@@ -103,22 +120,52 @@ extern "C"
     COLOR_API Color* AverageCanvas(Canvas* buffer);
     COLOR_API Canvas* CopyCanvasRegion(Canvas* buffer, int x, int y, int w, int h);
     COLOR_API Canvas* CopyCanvas(Canvas* buffer);
+    COLOR_API Canvas* CreateCanvasView(Canvas* buffer, int x, int y, int w, int h);
 
-    COLOR_API int CanvasFind(Canvas* buffer, Color* color);
-    COLOR_API int CanvasFindLast(Canvas* buffer, Color* color);
+    COLOR_API int64_t CanvasFind(Canvas* buffer, Color* color);
+    COLOR_API int64_t CanvasFindLast(Canvas* buffer, Color* color);
     COLOR_API size_t CanvasCountUniqueColors(Canvas* buffer);
     COLOR_API void CanvasForEach(Canvas* buffer, void (*func)(Color*));
-    COLOR_API void CanvasSwap(Canvas* buffer, int index1, int index2);
+    COLOR_API void CanvasSwap(Canvas* buffer, int64_t index1, int64_t index2);
     COLOR_API Canvas* CanvasFilter(Canvas* buffer, bool (*predicate)(Color*));
-    COLOR_API int CanvasCount(Canvas* buffer, Color* color);
-    COLOR_API void CanvasShuffle(Canvas* buffer);
+    COLOR_API int64_t CanvasCount(Canvas* buffer, Color* color);
+    COLOR_API void CanvasShuffle(Canvas* buffer, uint64_t seed);
     COLOR_API void CanvasClear(Canvas* buffer);
     COLOR_API void CanvasSort(Canvas* buffer, int (*compare)(Color*, Color*));
     COLOR_API void CanvasAppendRight(Canvas* buffer, Canvas* other);
     COLOR_API void CanvasAppendBottom(Canvas* buffer, Canvas* other);
     COLOR_API void MapColorsInBuffer(Canvas* buffer, int x, int y, int width, int height, void* mapFunction);
-    COLOR_API int* CanvasFindAll(Canvas* buffer, Color* color, int* count);
+    COLOR_API int64_t* CanvasFindAll(Canvas* buffer, Color* color, int64_t* count);
+    COLOR_API void FreeCanvasIndices(int64_t* indices);
     COLOR_API void CanvasApplyMatrix(Canvas* buffer, ColorMatrix* matrix);
+    COLOR_API void CanvasBeginMatrixBatch(Canvas* buffer);
+    COLOR_API void CanvasEndMatrixBatch(Canvas* buffer);
+    COLOR_API void CanvasFlushMatrixBatch(Canvas* buffer);
+    COLOR_API void CanvasSetPrecision(Canvas* buffer, int precision);
+    COLOR_API int GetCanvasPrecision(Canvas* buffer);
+    COLOR_API float* GetCanvasFloatPixels(Canvas* buffer);
+    COLOR_API void CanvasSetAlphaMode(Canvas* buffer, int mode);
+    COLOR_API int GetCanvasAlphaMode(Canvas* buffer);
     COLOR_API void DrawCanvas(Canvas* buffer, HWND hwnd, int x, int y);
+    COLOR_API void CanvasToSpace(Canvas* buffer, int space, float* out);
+    COLOR_API void CanvasFromSpace(Canvas* buffer, int space, const float* values);
+    #pragma endregion
+
+    #pragma region Threading
+    COLOR_API void SetCanvasThreadCount(int count);
+    COLOR_API int GetCanvasThreadCount();
+    COLOR_API void ShutdownCanvasThreads();
+    #pragma endregion
+
+    #pragma region Jobs
+    COLOR_API Jobs::Job* CreateCanvasJob(Canvas* buffer);
+    COLOR_API void CanvasJobAdd(Jobs::Job* job, const char* operation, const double* args, int argCount);
+    COLOR_API void StartCanvasJob(Jobs::Job* job);
+    COLOR_API void CancelCanvasJob(Jobs::Job* job);
+    COLOR_API int WaitCanvasJob(Jobs::Job* job, int timeoutMs);
+    COLOR_API int GetCanvasJobState(Jobs::Job* job);
+    COLOR_API double GetCanvasJobProgress(Jobs::Job* job);
+    COLOR_API const char* GetCanvasJobError(Jobs::Job* job);
+    COLOR_API void DeleteCanvasJob(Jobs::Job* job);
     #pragma endregion
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Color.hpp"
+#include "../ColorSpaces.hpp"
 
 extern "C"
 {
@@ -242,6 +243,8 @@ extern "C"
     COLOR_API Color* ColorFromOKLCH(double l, double c, double h, int alpha);
     COLOR_API void ColorToACEScg(Color* color, double* r, double* g, double* b, int* a);
     COLOR_API Color* ColorFromACEScg(double r, double g, double b, int a);
+    COLOR_API void ColorsToSpace(const unsigned int* colors, int count, int space, float* out);
+    COLOR_API void ColorsFromSpace(const float* values, int count, int space, unsigned int* colors);
     #pragma endregion
 
     #pragma region Color manipulation
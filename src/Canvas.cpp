@@ -1,481 +1,1732 @@
 #define NOMINMAX
 
 #include "../include/Canvas.hpp"
+#include "../include/FFT.hpp"
+#include "../include/Kernels.hpp"
+#include "../include/Random.hpp"
+#include "../include/Scheduler.hpp"
+#include "../include/TransferFunction.hpp"
 
-#include <unordered_set>
 #include <stdexcept>
 #include <algorithm>
-#include <random>
-#include <ctime>
 #include <cmath>
+#include <cstring>
 #include <array>
+#include <limits>
 
 namespace KTLib
 {
-    #pragma region Constructors
-    Canvas::Canvas(int width, int height, Color col) : m_width(width), m_height(height)
+    namespace
+    {
+        enum ChannelShift { BlueShift = 0, GreenShift = 8, RedShift = 16, AlphaShift = 24 };
+
+        inline int GetChannel(uint32_t pixel, int shift) { return (pixel >> shift) & 0xFF; }
+        inline uint32_t SetChannel(uint32_t pixel, int shift, int value) { return (pixel & ~(0xFFu << shift)) | (static_cast<uint32_t>(value) << shift); }
+        inline uint32_t PackARGB(int r, int g, int b, int a) { return (static_cast<uint32_t>(a) << 24) | (r << 16) | (g << 8) | b; }
+
+        // Splits `count` pixels into chunks the kernels can stream through and runs them in parallel
+        template<typename Func>
+        void ForEachChunk(size_t count, Func func)
+        {
+            Scheduler::ForEachRange(count, 16384, func);
+        }
+
+        inline uint32_t SwapRedBlue(uint32_t pixel) { return (pixel & 0xFF00FF00) | ((pixel >> 16) & 0xFF) | ((pixel & 0xFF) << 16); }
+
+        // Span functions for Canvas::ForEachSpan that hand each run straight to a kernel
+        auto MatrixSpans(const ColorMatrix& matrix)
+        {
+            return [coefficients = Kernels::MatrixCoefficients(matrix)](uint32_t* pixels, size_t count, size_t) { Kernels::ApplyMatrix(pixels, count, coefficients); };
+        }
+
+        auto ComponentSpans(Kernels::ComponentShift component, double amount)
+        {
+            return [=](uint32_t* pixels, size_t count, size_t) { Kernels::ShiftComponent(pixels, count, component, amount); };
+        }
+
+        // 64-bit channel totals, a whole 4K canvas of white overflows 32 bits
+        struct ChannelSums
+        {
+            uint64_t r = 0, g = 0, b = 0, a = 0, count = 0;
+
+            ChannelSums& operator+=(const ChannelSums& other)
+            {
+                r += other.r; g += other.g; b += other.b; a += other.a; count += other.count;
+                return *this;
+            }
+
+            uint32_t Average() const
+            {
+                return PackARGB(static_cast<int>(r / count), static_cast<int>(g / count), static_cast<int>(b / count), static_cast<int>(a / count));
+            }
+        };
+
+        // Sums the pixels in [x0, x1) x [y0, y1) on the calling thread, rows are `stride` pixels apart
+        ChannelSums SumRegion(const uint32_t* pixels, ptrdiff_t stride, int x0, int y0, int x1, int y1)
+        {
+            ChannelSums sums;
+            for (int y = y0; y < y1; ++y)
+            {
+                const uint32_t* row = pixels + y * stride;
+                for (int x = x0; x < x1; ++x)
+                {
+                    sums.r += GetChannel(row[x], RedShift);
+                    sums.g += GetChannel(row[x], GreenShift);
+                    sums.b += GetChannel(row[x], BlueShift);
+                    sums.a += GetChannel(row[x], AlphaShift);
+                }
+            }
+            sums.count = static_cast<uint64_t>(x1 - x0) * (y1 - y0);
+            return sums;
+        }
+
+        // A canvas file is this header followed by width * height top-down ARGB32 pixels
+        constexpr char CanvasFileMagic[4] = {'K', 'T', 'C', 'V'};
+        constexpr uint32_t CanvasFileVersion = 1;
+
+        struct CanvasFileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            int32_t width;
+            int32_t height;
+            uint8_t reserved[48]; // Pads the header to a cache line so the pixels start aligned
+        };
+        static_assert(sizeof(CanvasFileHeader) == 64, "Canvas file header must stay 64 bytes");
+
+        // Bytes in one packed row, in 64 bits so a huge width (say from a file header) cannot wrap past a check
+        inline int64_t PackedRowBytes(int width) { return static_cast<int64_t>(width) * static_cast<int64_t>(sizeof(uint32_t)); }
+
+        // The last `size` rows of a strip a filter has read, for vertical passes that write their output over
+        // rows they still need: Keep(y) copies row y in before it is overwritten, Kept(y) finds it again
+        template<typename T>
+        class RowRing
+        {
+            public:
+                template<typename Source>
+                RowRing(int size, size_t length, Source&& source) : m_size(size), m_length(length), m_rows(static_cast<size_t>(size) * length), m_source(std::forward<Source>(source)) { }
+
+                const T* Keep(int y) { return std::copy_n(m_source(y), m_length, Slot(y)) - m_length; }
+                const T* Kept(int y) const { return m_rows.data() + static_cast<size_t>(y % m_size) * m_length; }
+
+            private:
+                T* Slot(int y) { return m_rows.data() + static_cast<size_t>(y % m_size) * m_length; }
+
+                int m_size;
+                size_t m_length;
+                std::vector<T> m_rows;
+                std::function<const T*(int)> m_source;
+        };
+
+        // Above this sigma GaussianBlur switches from its direct kernel to the recursive filter
+        constexpr double RecursiveGaussianSigma = 3.0;
+
+        // Rough nanoseconds per channel multiply-add of the direct float paths and per n log2 n of one 2D real
+        // transform, measured on one core. Only their ratio matters, it puts the switch near 11 x 11 at 512 x 512
+        constexpr double DirectTapCost = 1.3;
+        constexpr double TransformCost = 3.3;
+
+        // Direct convolution grows with the taps, the FFT with the transform size. The FFT pays for the
+        // kernel's spectrum and a forward and inverse transform per channel
+        bool UseFrequencyDomain(const ConvolutionKernel& kernel, int width, int height, int channels)
+        {
+            const double pixels = static_cast<double>(width) * height;
+            const double taps = kernel.IsSeparable() ? kernel.GetWidth() + kernel.GetHeight() : static_cast<double>(kernel.GetWidth()) * kernel.GetHeight();
+            const double direct = DirectTapCost * pixels * 4 * taps;
+
+            const double size = static_cast<double>(FFT::GoodSize(static_cast<size_t>(width) + kernel.GetWidth() - 1)) * FFT::GoodSize(static_cast<size_t>(height) + kernel.GetHeight() - 1);
+            const double transform = TransformCost * (2 * channels + 1) * size * std::log2(size);
+            return transform < direct;
+        }
+    }
+
+    #pragma region Storage
+    template<typename Func>
+    void Canvas::ForEachSpan(Func&& func) const
+    {
+        if (IsContiguous())
+        {
+            ForEachChunk(PixelCount(), [&](size_t begin, size_t count) { func(m_data + begin, count, begin); });
+            return;
+        }
+
+        Scheduler::For(m_height, [&](size_t y) { func(Row(static_cast<int>(y)), static_cast<size_t>(m_width), y * m_width); });
+    }
+
+    template<typename Func>
+    void Canvas::MapPixels(Func&& func)
+    {
+        ForEachSpan([&](uint32_t* pixels, size_t count, size_t)
+        {
+            for (uint32_t* px = pixels; px != pixels + count; ++px) *px = func(*px);
+        });
+    }
+
+    std::vector<uint32_t> Canvas::Packed() const
+    {
+        std::vector<uint32_t> packed(PixelCount());
+        ForEachSpan([&](const uint32_t* pixels, size_t count, size_t index) { std::copy_n(pixels, count, packed.data() + index); });
+        return packed;
+    }
+
+    void Canvas::Unpack(const uint32_t* packed)
+    {
+        ForEachSpan([&](uint32_t* pixels, size_t count, size_t index) { std::copy_n(packed + index, count, pixels); });
+    }
+
+    void Canvas::RequireNoViews(const char* operation) const
+    {
+        if (m_views > 0)
+            throw std::logic_error(std::string(operation) + " cannot replace the pixels of a canvas while views of it exist");
+    }
+
+    void Canvas::RequireResizable(const char* operation) const
+    {
+        RequireNoViews(operation);
+        if (m_wrapped)
+            throw std::logic_error(std::string(operation) + " changes the canvas size, which a canvas over external memory cannot do");
+    }
+
+    ptrdiff_t Canvas::PaddedStride(int width)
+    {
+        constexpr ptrdiff_t pixelsPerLine = RowAlignment / sizeof(uint32_t);
+        return (static_cast<ptrdiff_t>(width) + pixelsPerLine - 1) / pixelsPerLine * pixelsPerLine;
+    }
+
+    Canvas::PixelBuffer Canvas::AllocatePixels(int width, int height, uint32_t fill)
+    {
+        return PixelBuffer(static_cast<size_t>(PaddedStride(width)) * height, fill);
+    }
+
+    // `pixels` has to come from AllocatePixels(width, height)
+    void Canvas::ReplacePixels(PixelBuffer&& pixels, int width, int height)
+    {
+        m_pixels = std::make_shared<PixelBuffer>(std::move(pixels));
+        m_data = m_pixels->data();
+        m_stride = PaddedStride(width);
+        m_width = width;
+        m_height = height;
+        m_floatsStale = m_precision == PixelPrecision::Float32;
+        m_bytesStale = false;
+    }
+
+    void Canvas::Detach()
+    {
+        // The float plane shares the same way. Stale floats are rebuilt before anything reads them, so a
+        // shared stale buffer is just dropped
+        if (m_floats)
+        {
+            if (m_floats.use_count() == 1)
+                std::atomic_thread_fence(std::memory_order_acquire);
+            else
+                m_floats = m_floatsStale ? nullptr : std::make_shared<FloatBuffer>(*m_floats);
+        }
+
+        if (!m_pixels) return;
+
+        // A copy that just detached on another thread released the old buffer after it finished reading it
+        if (m_pixels.use_count() == 1)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return;
+        }
+
+        m_pixels = std::make_shared<PixelBuffer>(*m_pixels);
+        m_data = m_pixels->data();
+    }
+
+    void Canvas::PrepareWrite()
     {
-        m_colors.resize(width * height, col);
+        // The floats get rebuilt from the bytes after this, so shared ones are dropped rather than copied.
+        // Shared floats never have a matrix pending or bytes waiting on them
+        if (m_floats && m_floats.use_count() > 1)
+        {
+            m_floats.reset();
+            m_floatsStale = true;
+        }
+
+        Detach();
+        FlushMatrixBatch();
+        if (m_precision == PixelPrecision::Float32) m_floatsStale = true;
     }
 
-    Canvas::Canvas(unsigned int* buffer, int width, int height) : m_width(width), m_height(height)
+    void Canvas::FlushFloats() const
     {
-        m_colors.resize(width * height);
-        for (int i = 0; i < width * height; ++i)
+        if (m_floatsStale)
         {
-            m_colors[i] = Color(buffer[i]);
+            m_floatsStale = false;
+
+            // A const read can get here on a copy that still shares the old floats, leave those to the copy
+            if (!m_floats || m_floats.use_count() > 1)
+                m_floats = std::make_shared<FloatBuffer>(PixelCount() * 4);
+            else
+                m_floats->resize(PixelCount() * 4);
+            ForEachSpan([&](const uint32_t* pixels, size_t count, size_t index) { Kernels::ExpandPixels(pixels, count, m_floats->data() + index * 4); });
         }
+
+        if (m_hasPendingMatrix)
+        {
+            m_hasPendingMatrix = false;
+            ApplyMatrixToFloats(m_pendingMatrix);
+            m_bytesStale = true;
+        }
+    }
+
+    void Canvas::PrepareFloatWrite()
+    {
+        Detach();
+        FlushFloats();
+        m_bytesStale = true;
+    }
+
+    void Canvas::ApplyMatrixToFloats(const ColorMatrix& matrix) const
+    {
+        ForEachChunk(PixelCount(), [&](size_t begin, size_t count) { Kernels::ApplyMatrix(m_floats->data() + begin * 4, count, matrix); });
     }
 
-    Canvas::Canvas(Color** colors, int width, int height) : m_width(width), m_height(height)
+    template<typename Func>
+    bool Canvas::MapFloats(Func&& func)
     {
-        m_colors.reserve(width * height);
-        for (int i = 0; i < width * height; ++i)
+        if (m_precision != PixelPrecision::Float32) return false;
+
+        PrepareFloatWrite();
+        ForEachChunk(PixelCount(), [&](size_t begin, size_t count)
+        {
+            for (float* px = m_floats->data() + begin * 4; px != m_floats->data() + (begin + count) * 4; px += 4) func(px);
+        });
+        return true;
+    }
+
+    // Hands wrapped memory back in the format it came in, with any pending matrix applied
+    void Canvas::ReleaseWrapped()
+    {
+        if (!m_wrapped) return;
+
+        FlushMatrixBatch();
+        if (m_format == PixelFormat::ABGR32)
         {
-            m_colors.push_back(*colors[i]);
+            m_data = m_wrappedData;
+            m_width = m_wrappedWidth;
+            m_height = m_wrappedHeight;
+            MapPixels(SwapRedBlue);
         }
+
+        if (m_parent)
+        {
+            --m_parent->m_views;
+            m_parent = nullptr;
+        }
+
+        m_wrapped = false;
+        m_format = PixelFormat::ARGB32;
+        m_file.reset();
+        m_data = m_wrappedData = nullptr;
+        m_stride = 0;
+        m_width = m_wrappedWidth = 0;
+        m_height = m_wrappedHeight = 0;
     }
 
-    Canvas::Canvas(const std::vector<std::vector<Color>>& colors) : m_width(colors.empty() ? 0 : colors[0].size()), m_height(colors.size())
+    void Canvas::SampleInto(uint32_t* destination, int width, int height, ptrdiff_t stride) const
     {
-        m_colors.reserve(m_width * m_height);
-        for (const auto& row : colors)
+        if (width == m_width && height == m_height)
         {
-            m_colors.insert(m_colors.end(), row.begin(), row.end());
+            Scheduler::For(height, [&](size_t y) { std::copy_n(Row(static_cast<int>(y)), width, destination + static_cast<ptrdiff_t>(y) * stride); });
+            return;
         }
+
+        Scheduler::ForEachPixel(width, height, [&](int x, int y, size_t)
+        {
+            // In 64 bits, the products pass INT_MAX once a side is past about 46000 pixels
+            const int sourceX = static_cast<int>(static_cast<int64_t>(x) * m_width / width);
+            const int sourceY = static_cast<int>(static_cast<int64_t>(y) * m_height / height);
+            destination[y * stride + x] = Pixel(sourceX, sourceY);
+        });
+    }
+    #pragma endregion
+
+    #pragma region Constructors
+    Canvas::Canvas(int width, int height, Color col)
+    {
+        ReplacePixels(AllocatePixels(width, height, col.argb), width, height);
+    }
+
+    Canvas::Canvas(unsigned int* buffer, int width, int height)
+    {
+        ReplacePixels(AllocatePixels(width, height), width, height);
+        Unpack(buffer);
+    }
+
+    Canvas::Canvas(Color** colors, int width, int height)
+    {
+        ReplacePixels(AllocatePixels(width, height), width, height);
+        ForEachSpan([&](uint32_t* pixels, size_t count, size_t index)
+        {
+            for (size_t i = 0; i < count; ++i) pixels[i] = colors[index + i]->argb;
+        });
     }
 
-    Canvas::Canvas(const Gradient& gradient, int width, int height) : m_width(width), m_height(height)
+    Canvas::Canvas(const std::vector<std::vector<Color>>& colors)
     {
-        m_colors.resize(width * height);
+        const int width = colors.empty() ? 0 : colors[0].size();
+        const int height = colors.size();
 
+        ReplacePixels(AllocatePixels(width, height), width, height);
+        for (int y = 0; y < height; ++y)
+        {
+            uint32_t* row = Row(y);
+            for (int x = 0; x < width; ++x) row[x] = colors[y][x].argb;
+        }
+    }
+
+    Canvas::Canvas(const Gradient& gradient, int width, int height) : Canvas(width, height)
+    {
         const float centerX = width / 2.0f;
         const float centerY = height / 2.0f;
         const float maxRadius = std::max(centerX, centerY);
 
-        #pragma omp parallel for
-        for (int i = 0; i < width * height; ++i)
+        Scheduler::ForEachPixel(width, height, [&](int x, int y, size_t)
         {
-            const int x = i % width;
-            const int y = i / width;
             const float position = gradient.CalculatePosition(x, y, centerX, centerY, maxRadius);
-            m_colors[i] = gradient.GetColorAt(position);
+            Pixel(x, y) = gradient.GetColorAt(position).argb;
+        });
+    }
+
+    Canvas::Canvas(const Canvas& other) : m_matrixBatching(other.m_matrixBatching), m_precision(other.m_precision), m_alphaMode(other.m_alphaMode)
+    {
+        // Flushing can rewrite both planes of `other`, so its float state is only taken afterwards. Both
+        // planes are shared and copied on the first write
+        other.FlushMatrixBatch();
+        m_floats = other.m_floats;
+        m_floatsStale = other.m_floatsStale;
+        m_bytesStale = other.m_bytesStale;
+
+        // Views write straight into their parent's buffer, so a canvas that has some cannot share it
+        if (other.m_pixels && other.m_views == 0)
+        {
+            m_pixels = other.m_pixels;
+            m_data = other.m_data;
+            m_stride = other.m_stride;
+            m_width = other.m_width;
+            m_height = other.m_height;
+            return;
         }
+
+        ReplacePixels(AllocatePixels(other.m_width, other.m_height), other.m_width, other.m_height);
+        Scheduler::For(m_height, [&](size_t y) { std::copy_n(other.Row(static_cast<int>(y)), m_width, Row(static_cast<int>(y))); });
+        m_floatsStale = other.m_floatsStale;
+        m_bytesStale = other.m_bytesStale;
+    }
+
+    // View counts belong to the object the views point at, so they stay behind on moves
+    Canvas::Canvas(Canvas&& other) noexcept
+        : m_pixels(std::move(other.m_pixels)), m_data(other.m_data), m_stride(other.m_stride), m_width(other.m_width), m_height(other.m_height),
+          m_wrapped(other.m_wrapped), m_format(other.m_format), m_file(std::move(other.m_file)), m_wrappedData(other.m_wrappedData),
+          m_wrappedWidth(other.m_wrappedWidth), m_wrappedHeight(other.m_wrappedHeight), m_parent(other.m_parent), m_matrixBatching(other.m_matrixBatching),
+          m_hasPendingMatrix(other.m_hasPendingMatrix), m_pendingMatrix(other.m_pendingMatrix), m_precision(other.m_precision),
+          m_floats(std::move(other.m_floats)), m_floatsStale(other.m_floatsStale), m_bytesStale(other.m_bytesStale), m_alphaMode(other.m_alphaMode)
+    {
+        other.m_data = other.m_wrappedData = nullptr;
+        other.m_stride = other.m_width = other.m_height = other.m_wrappedWidth = other.m_wrappedHeight = 0;
+        other.m_wrapped = false;
+        other.m_parent = nullptr;
+        other.m_hasPendingMatrix = false;
+        other.m_precision = PixelPrecision::UInt8;
+        other.m_floatsStale = other.m_bytesStale = false;
+        other.m_alphaMode = AlphaMode::Straight;
+    }
+
+    // The old contents end up in `other`, whose destructor releases them. Views would be left pointing
+    // into freed storage, and the view count stays with the object either way
+    Canvas& Canvas::operator=(Canvas other)
+    {
+        RequireNoViews("operator=");
+        other.RequireNoViews("operator=");
+
+        std::swap(m_pixels, other.m_pixels);
+        std::swap(m_data, other.m_data);
+        std::swap(m_stride, other.m_stride);
+        std::swap(m_width, other.m_width);
+        std::swap(m_height, other.m_height);
+        std::swap(m_wrapped, other.m_wrapped);
+        std::swap(m_format, other.m_format);
+        std::swap(m_file, other.m_file);
+        std::swap(m_wrappedData, other.m_wrappedData);
+        std::swap(m_wrappedWidth, other.m_wrappedWidth);
+        std::swap(m_wrappedHeight, other.m_wrappedHeight);
+        std::swap(m_parent, other.m_parent);
+        std::swap(m_matrixBatching, other.m_matrixBatching);
+        std::swap(m_hasPendingMatrix, other.m_hasPendingMatrix);
+        std::swap(m_pendingMatrix, other.m_pendingMatrix);
+        std::swap(m_precision, other.m_precision);
+        std::swap(m_floats, other.m_floats);
+        std::swap(m_floatsStale, other.m_floatsStale);
+        std::swap(m_bytesStale, other.m_bytesStale);
+        std::swap(m_alphaMode, other.m_alphaMode);
+        return *this;
+    }
+
+    Canvas::~Canvas()
+    {
+        ReleaseWrapped();
+    }
+
+    Canvas* Canvas::Wrap(void* pixels, int width, int height, int stride, PixelFormat format)
+    {
+        if (!pixels)
+            throw std::invalid_argument("Pixel memory cannot be null");
+        if (width <= 0 || height <= 0)
+            throw std::invalid_argument("Wrapped canvas dimensions must be positive");
+        const int64_t rowBytes = std::abs(static_cast<int64_t>(stride));
+        if (rowBytes % static_cast<int64_t>(sizeof(uint32_t)) != 0 || rowBytes < PackedRowBytes(width))
+            throw std::invalid_argument("Stride must be a multiple of 4 bytes and cover a whole row");
+        if (format != PixelFormat::ARGB32 && format != PixelFormat::ABGR32)
+            throw std::invalid_argument("Unsupported pixel format");
+
+        Canvas* canvas = new Canvas();
+        canvas->m_data = static_cast<uint32_t*>(pixels);
+        canvas->m_stride = stride / static_cast<int>(sizeof(uint32_t));
+        canvas->m_width = width;
+        canvas->m_height = height;
+        canvas->m_wrapped = true;
+        canvas->m_format = format;
+        canvas->m_wrappedData = canvas->m_data;
+        canvas->m_wrappedWidth = width;
+        canvas->m_wrappedHeight = height;
+
+        if (format == PixelFormat::ABGR32) canvas->MapPixels(SwapRedBlue);
+
+        return canvas;
+    }
+
+    Canvas::Canvas(const Canvas& parent, int x, int y, int width, int height)
+    {
+        if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > parent.m_width || y + height > parent.m_height)
+            throw std::out_of_range("View rectangle is out of bounds");
+
+        parent.FlushMatrixBatch();
+
+        m_data = &parent.Pixel(x, y);
+        m_stride = parent.m_stride;
+        m_width = width;
+        m_height = height;
+        m_wrapped = true;
+        m_parent = parent.m_parent ? parent.m_parent : &parent;
+        m_alphaMode = m_parent->m_alphaMode;
+        ++m_parent->m_views;
+    }
+
+    Canvas* Canvas::View(int x, int y, int width, int height)
+    {
+        // A view writes 8-bit pixels its parent would not know to rebuild its floats from
+        if (m_precision == PixelPrecision::Float32)
+            throw std::logic_error("Views of a Float32 canvas are not supported");
+
+        Detach();
+        return new Canvas(*this, x, y, width, height);
+    }
+
+    Canvas* Canvas::WrapDIBSection(HBITMAP hBitmap)
+    {
+        DIBSECTION dib;
+        if (GetObject(hBitmap, sizeof(DIBSECTION), &dib) != sizeof(DIBSECTION) || !dib.dsBm.bmBits)
+            throw std::invalid_argument("Bitmap is not a DIB section");
+        if (dib.dsBm.bmBitsPixel != 32)
+            throw std::invalid_argument("Only 32 bpp DIB sections can be wrapped");
+
+        // bmBits is the bottom row of a bottom-up DIB, so start at the top and walk backwards
+        const int width = dib.dsBm.bmWidth;
+        const int height = dib.dsBm.bmHeight;
+        const int stride = dib.dsBm.bmWidthBytes;
+        BYTE* bits = static_cast<BYTE*>(dib.dsBm.bmBits);
+
+        if (dib.dsBmih.biHeight > 0)
+            return Wrap(bits + static_cast<ptrdiff_t>(height - 1) * stride, width, height, -stride);
+
+        return Wrap(bits, width, height, stride);
+    }
+
+    Canvas* Canvas::CreateMapped(const std::string& path, int width, int height, Color col)
+    {
+        if (width <= 0 || height <= 0)
+            throw std::invalid_argument("Mapped canvas dimensions must be positive");
+
+        const int64_t stride = PackedRowBytes(width);
+        if (stride > std::numeric_limits<int>::max())
+            throw std::invalid_argument("Mapped canvas rows cannot exceed 2 GB");
+
+        auto file = MappedFile::Create(path, sizeof(CanvasFileHeader) + static_cast<uint64_t>(stride) * height);
+
+        CanvasFileHeader* header = reinterpret_cast<CanvasFileHeader*>(file->GetData());
+        std::memcpy(header->magic, CanvasFileMagic, sizeof(header->magic));
+        header->version = CanvasFileVersion;
+        header->width = width;
+        header->height = height;
+
+        Canvas* canvas = Wrap(file->GetData() + sizeof(CanvasFileHeader), width, height, static_cast<int>(stride));
+        canvas->m_file = std::move(file);
+
+        // A new file is already zero filled, only touch every page when the fill is something else
+        if (col.argb != 0) canvas->MapPixels([=](uint32_t) { return col.argb; });
+        return canvas;
+    }
+
+    Canvas* Canvas::OpenMapped(const std::string& path, bool writable)
+    {
+        auto file = MappedFile::Open(path, writable);
+
+        const CanvasFileHeader* header = reinterpret_cast<const CanvasFileHeader*>(file->GetData());
+        if (file->GetSize() < sizeof(CanvasFileHeader) || std::memcmp(header->magic, CanvasFileMagic, sizeof(header->magic)) != 0)
+            throw std::runtime_error("Not a canvas file: " + path);
+        if (header->version != CanvasFileVersion)
+            throw std::runtime_error("Unsupported canvas file version: " + path);
+        if (header->width <= 0 || header->height <= 0)
+            throw std::runtime_error("Canvas file has invalid dimensions: " + path);
+
+        // The header is untrusted, check the row size and the whole pixel block against the mapping before
+        // anything reads through it
+        const int64_t stride = PackedRowBytes(header->width);
+        if (stride > std::numeric_limits<int>::max())
+            throw std::runtime_error("Canvas file rows are too wide: " + path);
+        if (file->GetSize() - sizeof(CanvasFileHeader) < static_cast<uint64_t>(stride) * static_cast<uint64_t>(header->height))
+            throw std::runtime_error("Canvas file is truncated: " + path);
+
+        Canvas* canvas = Wrap(file->GetData() + sizeof(CanvasFileHeader), header->width, header->height, static_cast<int>(stride));
+        canvas->m_file = std::move(file);
+        return canvas;
+    }
+
+    void Canvas::FlushMapped() const
+    {
+        if (!m_file) return;
+
+        FlushMatrixBatch();
+        m_file->Flush();
     }
     #pragma endregion
 
     #pragma region Canvas Functions
-    Color& Canvas::Get(int x, int y)                   { return m_colors[y * m_width + x]; }
-    const Color& Canvas::Get(int x, int y) const       { return m_colors[y * m_width + x]; }
-    void Canvas::Set(int x, int y, const Color& color) { m_colors[y * m_width + x] = color; }
-
-    Color Canvas::GetAt(int index) const              { return m_colors[index]; }
-    void Canvas::SetAt(int index, const Color& color) { m_colors[index] = color; }
-
-    void Canvas::GetXY(int index, int& x, int& y) const   { y = index / m_width, x = index % m_width; }
-    void Canvas::GetIndex(int x, int y, int& index) const { index = y * m_width + x; }
-
-    void Canvas::ShiftRed(int amount)   { for (auto& color : m_colors) color.SetRed(std::clamp(color.GetRed() + amount, 0, 255)); }
-    void Canvas::ShiftGreen(int amount) { for (auto& color : m_colors) color.SetGreen(std::clamp(color.GetGreen() + amount, 0, 255)); }
-    void Canvas::ShiftBlue(int amount)  { for (auto& color : m_colors) color.SetBlue(std::clamp(color.GetBlue() + amount, 0, 255)); }
-    void Canvas::ShiftAlpha(int amount) { for (auto& color : m_colors) color.SetAlpha(std::clamp(color.GetAlpha() + amount, 0, 255)); }
-
-    void Canvas::SetRed(int value)   { for (auto& color : m_colors) color.SetRed(std::clamp(value, 0, 255)); }
-    void Canvas::SetGreen(int value) { for (auto& color : m_colors) color.SetGreen(std::clamp(value, 0, 255)); }
-    void Canvas::SetBlue(int value)  { for (auto& color : m_colors) color.SetBlue(std::clamp(value, 0, 255)); }
-    void Canvas::SetAlpha(int value) { for (auto& color : m_colors) color.SetAlpha(std::clamp(value, 0, 255)); }
-    void Canvas::ApplyMatrix(const ColorMatrix& matrix) { std::transform(m_colors.begin(), m_colors.end(), m_colors.begin(), [&matrix](const Color& color) { return color * matrix; }); }
+    Color Canvas::Get(int x, int y) const              { FlushMatrixBatch(); return Color(Pixel(x, y)); }
+    void Canvas::Set(int x, int y, const Color& color) { PrepareWrite(); Pixel(x, y) = color.argb; }
+
+    Color Canvas::GetAt(int64_t index) const              { FlushMatrixBatch(); return Color(PixelAt(index)); }
+    void Canvas::SetAt(int64_t index, const Color& color) { PrepareWrite(); PixelAt(index) = color.argb; }
+
+    void Canvas::GetXY(int64_t index, int& x, int& y) const   { y = static_cast<int>(index / m_width), x = static_cast<int>(index % m_width); }
+    void Canvas::GetIndex(int x, int y, int64_t& index) const { index = static_cast<int64_t>(y) * m_width + x; }
+
+    // Float32 canvases shift without clamping, so shifting back restores the original
+    void Canvas::ShiftRed(int amount)
+    {
+        if (MapFloats([=](float* px) { px[0] += amount / 255.0f; })) return;
+        PrepareWrite();
+        MapPixels([=](uint32_t px) { return SetChannel(px, RedShift, std::clamp(GetChannel(px, RedShift) + amount, 0, 255)); });
+    }
+
+    void Canvas::ShiftGreen(int amount)
+    {
+        if (MapFloats([=](float* px) { px[1] += amount / 255.0f; })) return;
+        PrepareWrite();
+        MapPixels([=](uint32_t px) { return SetChannel(px, GreenShift, std::clamp(GetChannel(px, GreenShift) + amount, 0, 255)); });
+    }
+
+    void Canvas::ShiftBlue(int amount)
+    {
+        if (MapFloats([=](float* px) { px[2] += amount / 255.0f; })) return;
+        PrepareWrite();
+        MapPixels([=](uint32_t px) { return SetChannel(px, BlueShift, std::clamp(GetChannel(px, BlueShift) + amount, 0, 255)); });
+    }
+
+    void Canvas::ShiftAlpha(int amount)
+    {
+        if (MapFloats([=](float* px) { px[3] += amount / 255.0f; })) return;
+        PrepareWrite();
+        MapPixels([=](uint32_t px) { return SetChannel(px, AlphaShift, std::clamp(GetChannel(px, AlphaShift) + amount, 0, 255)); });
+    }
+
+    void Canvas::SetRed(int value)
+    {
+        if (MapFloats([=](float* px) { px[0] = std::clamp(value, 0, 255) / 255.0f; })) return;
+        PrepareWrite();
+        MapPixels([=](uint32_t px) { return SetChannel(px, RedShift, std::clamp(value, 0, 255)); });
+    }
+
+    void Canvas::SetGreen(int value)
+    {
+        if (MapFloats([=](float* px) { px[1] = std::clamp(value, 0, 255) / 255.0f; })) return;
+        PrepareWrite();
+        MapPixels([=](uint32_t px) { return SetChannel(px, GreenShift, std::clamp(value, 0, 255)); });
+    }
+
+    void Canvas::SetBlue(int value)
+    {
+        if (MapFloats([=](float* px) { px[2] = std::clamp(value, 0, 255) / 255.0f; })) return;
+        PrepareWrite();
+        MapPixels([=](uint32_t px) { return SetChannel(px, BlueShift, std::clamp(value, 0, 255)); });
+    }
+
+    void Canvas::SetAlpha(int value)
+    {
+        if (MapFloats([=](float* px) { px[3] = std::clamp(value, 0, 255) / 255.0f; })) return;
+        PrepareWrite();
+        MapPixels([=](uint32_t px) { return SetChannel(px, AlphaShift, std::clamp(value, 0, 255)); });
+    }
+
+    void Canvas::ApplyMatrix(const ColorMatrix& matrix)
+    {
+        // Also when only queueing, a canvas with a pending matrix never shares its pixels
+        Detach();
+
+        if (m_matrixBatching)
+        {
+            m_pendingMatrix = m_hasPendingMatrix ? m_pendingMatrix.Then(matrix) : matrix;
+            m_hasPendingMatrix = true;
+            return;
+        }
+
+        if (m_precision == PixelPrecision::Float32)
+        {
+            PrepareFloatWrite();
+            ApplyMatrixToFloats(matrix);
+            return;
+        }
+
+        // A view's parent may still have matrices queued from before this one
+        PrepareWrite();
+        ForEachSpan(MatrixSpans(matrix));
+    }
+
+    void Canvas::SetPrecision(PixelPrecision precision)
+    {
+        if (precision == m_precision) return;
+        if (precision != PixelPrecision::UInt8 && precision != PixelPrecision::Float32)
+            throw std::invalid_argument("Unsupported pixel precision");
+
+        FlushMatrixBatch();
+
+        if (precision == PixelPrecision::Float32)
+        {
+            RequireNoViews("SetPrecision");
+            if (m_wrapped)
+                throw std::logic_error("SetPrecision needs a canvas that owns its pixels");
+
+            m_floatsStale = true; // Expanded the first time a float filter runs
+        }
+        else
+        {
+            m_floats.reset();
+            m_floatsStale = false;
+        }
+        m_precision = precision;
+    }
+
+    void Canvas::SetAlphaMode(AlphaMode mode)
+    {
+        if (mode == m_alphaMode) return;
+        if (mode != AlphaMode::Straight && mode != AlphaMode::Premultiplied)
+            throw std::invalid_argument("Unsupported alpha mode");
+
+        // Views and their parent read the same pixels, they have to agree on what those mean
+        RequireNoViews("SetAlphaMode");
+        if (m_parent)
+            throw std::logic_error("SetAlphaMode cannot change the alpha mode of a view");
+
+        PrepareWrite();
+        if (mode == AlphaMode::Premultiplied)
+            ForEachSpan([](uint32_t* pixels, size_t count, size_t) { Kernels::Premultiply(pixels, count); });
+        else
+            ForEachSpan([](uint32_t* pixels, size_t count, size_t) { Kernels::Unpremultiply(pixels, count); });
+
+        m_alphaMode = mode;
+    }
+
+    float* Canvas::GetFloatPixels()
+    {
+        if (m_precision != PixelPrecision::Float32) return nullptr;
+
+        // The caller may write, so the 8-bit pixels get rebuilt the next time they are read
+        PrepareFloatWrite();
+        return m_floats->data();
+    }
+
+    const float* Canvas::GetFloatPixels() const
+    {
+        if (m_precision != PixelPrecision::Float32) return nullptr;
+
+        FlushFloats();
+        return m_floats->data();
+    }
+
+    // A view's queue would sit outside its parent's, and filters the parent ran later would land before it
+    void Canvas::BeginMatrixBatch()
+    {
+        if (m_parent)
+            throw std::logic_error("BeginMatrixBatch cannot batch on a view");
+
+        m_matrixBatching = true;
+    }
+
+    void Canvas::EndMatrixBatch()
+    {
+        FlushMatrixBatch();
+        m_matrixBatching = false;
+    }
+
+    void Canvas::FlushMatrixBatch() const
+    {
+        // A view reads through to its parent, which has to be up to date first
+        if (m_parent) m_parent->FlushMatrixBatch();
+
+        // Float32 canvases apply the matrix to the floats and round the 8-bit pixels from those
+        if (m_precision == PixelPrecision::Float32)
+        {
+            if (m_hasPendingMatrix) FlushFloats();
+            if (!m_bytesStale) return;
+
+            m_bytesStale = false;
+            ForEachSpan([&](uint32_t* pixels, size_t count, size_t index) { Kernels::QuantizePixels(m_floats->data() + index * 4, count, pixels); });
+            return;
+        }
+
+        if (!m_hasPendingMatrix) return;
+
+        // Logically const: the pending matrix is part of the canvas state, flushing only materialises it
+        m_hasPendingMatrix = false;
+        ForEachSpan(MatrixSpans(m_pendingMatrix));
+    }
+    #pragma endregion
+
+    #pragma region Transfer Functions
+    std::vector<float> Canvas::ToLinear(TransferCurve curve) const
+    {
+        FlushMatrixBatch();
+
+        std::vector<float> linear(PixelCount() * 4);
+        ForEachSpan([&](const uint32_t* pixels, size_t count, size_t index) { Transfer::DecodePixels(curve, pixels, count, linear.data() + index * 4); });
+        return linear;
+    }
+
+    void Canvas::FromLinear(const float* linear, TransferCurve curve)
+    {
+        if (!linear)
+            throw std::invalid_argument("Linear buffer cannot be null");
+
+        Detach();
+        m_hasPendingMatrix = false;
+        m_bytesStale = false;
+        m_floatsStale = m_precision == PixelPrecision::Float32;
+        ForEachSpan([&](uint32_t* pixels, size_t count, size_t index) { Transfer::EncodePixels(curve, linear + index * 4, count, pixels); });
+    }
+
+    std::vector<float> Canvas::ToSpace(ColorSpace space) const
+    {
+        std::vector<float> values(PixelCount() * 4);
+        ToSpace(space, values.data());
+        return values;
+    }
+
+    void Canvas::ToSpace(ColorSpace space, float* values) const
+    {
+        FlushMatrixBatch();
+        ForEachSpan([&](const uint32_t* pixels, size_t count, size_t index) { ColorSpaces::FromPixels(space, pixels, count, values + index * 4); });
+    }
+
+    void Canvas::FromSpace(const float* values, ColorSpace space)
+    {
+        if (!values)
+            throw std::invalid_argument("Value buffer cannot be null");
+
+        Detach();
+        m_hasPendingMatrix = false;
+        m_bytesStale = false;
+        m_floatsStale = m_precision == PixelPrecision::Float32;
+        ForEachSpan([&](uint32_t* pixels, size_t count, size_t index) { ColorSpaces::ToPixels(space, values + index * 4, count, pixels); });
+    }
     #pragma endregion
 
     #pragma region Color Modification Functions
-    void Canvas::Invert()                         { for (auto& color : m_colors) color.Invert(); }
-    void Canvas::ShiftHue(double degrees)         { for (auto& color : m_colors) color.ShiftHue(degrees); }
-    void Canvas::Grayscale()                      { for (auto& color : m_colors) color.Grayscale(); }
-    void Canvas::Sepia(double factor)             { for (auto& color : m_colors) color.Sepia(factor); }
-    void Canvas::CrossProcess(double factor)      { for (auto& color : m_colors) color.CrossProcess(factor); }
-    void Canvas::Moonlight(double factor)         { for (auto& color : m_colors) color.Moonlight(factor); }
-    void Canvas::VintageFilm(double factor)       { for (auto& color : m_colors) color.VintageFilm(factor); }
-    void Canvas::Technicolor(double factor)       { for (auto& color : m_colors) color.Technicolor(factor); }
-    void Canvas::Polaroid(double factor)          { for (auto& color : m_colors) color.Polaroid(factor); }
-    void Canvas::Complement()                     { for (auto& color : m_colors) color.Complement(); }
-    void Canvas::ShiftSaturation(double amount)   { for (auto& color : m_colors) color.ShiftSaturation(amount); }
-    void Canvas::ShiftLightness(double amount)    { for (auto& color : m_colors) color.ShiftLightness(amount); }
-    void Canvas::ShiftValue(double amount)        { for (auto& color : m_colors) color.ShiftValue(amount); }
-    void Canvas::ShiftIntensity(double amount)    { for (auto& color : m_colors) color.ShiftIntensity(amount); }
-    void Canvas::ShiftWhiteLevel(double amount)   { for (auto& color : m_colors) color.ShiftWhiteLevel(amount); }
-    void Canvas::ShiftBlackLevel(double amount)   { for (auto& color : m_colors) color.ShiftBlackLevel(amount); }
-    void Canvas::ShiftContrast(double amount)     { for (auto& color : m_colors) color.ShiftContrast(amount); }
+    void Canvas::Invert()
+    {
+        if (MapFloats([](float* px) { px[0] = 1.0f - px[0]; px[1] = 1.0f - px[1]; px[2] = 1.0f - px[2]; })) return;
+        PrepareWrite();
+        MapPixels([](uint32_t px) { Color color(px); color.Invert(); return color.argb; });
+    }
+
+    void Canvas::ShiftHue(double degrees)         { PrepareWrite(); ForEachSpan(ComponentSpans(Kernels::ComponentShift::Hue, degrees)); }
+    void Canvas::Grayscale()                      { ApplyMatrix(ColorMatrix::Grayscale()); }
+    void Canvas::Sepia(double factor)             { ApplyMatrix(ColorMatrix::Sepia(factor)); }
+    void Canvas::CrossProcess(double factor)      { ApplyMatrix(ColorMatrix::CrossProcess(factor)); }
+    void Canvas::Moonlight(double factor)         { ApplyMatrix(ColorMatrix::Moonlight(factor)); }
+    void Canvas::VintageFilm(double factor)       { ApplyMatrix(ColorMatrix::VintageFilm(factor)); }
+    void Canvas::Technicolor(double factor)       { ApplyMatrix(ColorMatrix::Technicolor(factor)); }
+    void Canvas::Polaroid(double factor)          { ApplyMatrix(ColorMatrix::Polaroid(factor)); }
+    void Canvas::Complement()                     { PrepareWrite(); MapPixels([](uint32_t px) { Color color(px); color.Complement(); return color.argb; }); }
+    void Canvas::ShiftSaturation(double amount)   { PrepareWrite(); ForEachSpan(ComponentSpans(Kernels::ComponentShift::Saturation, amount)); }
+    void Canvas::ShiftLightness(double amount)    { PrepareWrite(); ForEachSpan(ComponentSpans(Kernels::ComponentShift::Lightness, amount)); }
+    void Canvas::ShiftValue(double amount)        { PrepareWrite(); ForEachSpan(ComponentSpans(Kernels::ComponentShift::Value, amount)); }
+    void Canvas::ShiftIntensity(double amount)    { PrepareWrite(); ForEachSpan(ComponentSpans(Kernels::ComponentShift::Intensity, amount)); }
+    void Canvas::ShiftWhiteLevel(double amount)   { ApplyMatrix(ColorMatrix::WhiteLevel(amount)); }
+    void Canvas::ShiftBlackLevel(double amount)   { ApplyMatrix(ColorMatrix::BlackLevel(amount)); }
+    void Canvas::ShiftContrast(double amount)     { ApplyMatrix(ColorMatrix::Contrast(amount)); }
+
+    void Canvas::Pixelate(int pixelSize)
+    {
+        PrepareWrite();
+
+        if (pixelSize <= 1) return;
+
+        int numPixelsX = (m_width + pixelSize - 1) / pixelSize;
+        int numPixelsY = (m_height + pixelSize - 1) / pixelSize;
+
+        Scheduler::For(static_cast<size_t>(numPixelsX) * numPixelsY, [&](size_t i)
+        {
+            int blockX = static_cast<int>(i % numPixelsX) * pixelSize;
+            int blockY = static_cast<int>(i / numPixelsX) * pixelSize;
+            int endX = std::min(blockX + pixelSize, m_width);
+            int endY = std::min(blockY + pixelSize, m_height);
+
+            const uint32_t average = SumRegion(m_data, m_stride, blockX, blockY, endX, endY).Average();
+
+            for (int y = blockY; y < endY; ++y)
+            {
+                std::fill(Row(y) + blockX, Row(y) + endX, average);
+            }
+        });
+    }
+
+    void Canvas::Blur(int radius, int passes)
+    {
+        PrepareWrite();
+
+        if (radius <= 0 || passes <= 0) return;
+
+        // Past the longer side the window already covers every row and column, and 2 * radius + 2 below
+        // would overflow for the largest radii
+        radius = std::min(radius, std::max(m_width, m_height));
+
+        const size_t stripWidth = 256;
+
+        // A row leaves the vertical window 2 * radius + 1 rows after it joined, by which time it has been
+        // overwritten, so each strip keeps the rows in its window in a ring
+        const int window = std::min(2 * radius + 2, m_height);
+
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            // Horizontal pass in place through a row of scratch per task
+            Scheduler::ForEachRange(m_height, 16, [&](size_t begin, size_t length)
+            {
+                std::vector<uint32_t> blurred(m_width);
+                for (size_t y = begin; y < begin + length; ++y)
+                {
+                    Kernels::BoxBlurRow(Row(static_cast<int>(y)), blurred.data(), m_width, radius);
+                    std::copy(blurred.begin(), blurred.end(), Row(static_cast<int>(y)));
+                }
+            });
+
+            // Vertical pass, a strip of columns at a time so every row step reads one contiguous run. Each
+            // step lands on a new page, wide strips give it enough cache lines to fetch at once, and the
+            // strip's running sums still fit in L1
+            Scheduler::ForEachRange(m_width, stripWidth, [&](size_t begin, size_t length)
+            {
+                alignas(RowAlignment) int32_t sums[stripWidth * 4] = {};
+                RowRing<uint32_t> ring(window, length, [&](int y) { return Row(y) + begin; });
+
+                for (int y = 0; y < std::min(radius, m_height); ++y) Kernels::SlideColumns(sums, ring.Keep(y), nullptr, length);
+
+                for (int y = 0; y < m_height; ++y)
+                {
+                    Kernels::SlideColumns(sums, y < m_height - radius ? ring.Keep(y + radius) : nullptr, y > radius ? ring.Kept(y - radius - 1) : nullptr, length);
+
+                    const int count = std::min(y, radius) + 1 + std::min(m_height - 1 - y, radius);
+                    Kernels::AverageColumns(sums, length, count, Row(y) + begin);
+                }
+            });
+        }
+    }
+
+    void Canvas::GaussianBlur(double sigma)
+    {
+        if (sigma <= 0) return;
+
+        if (sigma > RecursiveGaussianSigma)
+        {
+            RecursiveGaussianBlur(sigma);
+            return;
+        }
+
+        int radius = static_cast<int>(ceil(3 * sigma));
+        std::vector<double> kernel(2 * radius + 1);
+        double sum = 0.0;
+
+        // Generate 1D Gaussian kernel
+        for (int i = -radius; i <= radius; ++i)
+        {
+            kernel[i + radius] = exp(-(i * i) / (2 * sigma * sigma));
+            sum += kernel[i + radius];
+        }
+
+        // Normalize kernel
+        for (auto& k : kernel)
+            k /= sum;
+
+        // Same two passes over the packed float pixels, with no rounding in between or at the end
+        if (m_precision == PixelPrecision::Float32)
+        {
+            PrepareFloatWrite();
+
+            const size_t rowLength = static_cast<size_t>(m_width) * 4;
+            float* values = m_floats->data();
+
+            Scheduler::ForEachRange(m_height, 16, [&](size_t begin, size_t length)
+            {
+                std::vector<float> blurred(rowLength);
+                for (size_t y = begin; y < begin + length; ++y)
+                {
+                    float* row = values + y * rowLength;
+                    for (int x = 0; x < m_width; ++x)
+                    {
+                        double total[4] = {};
+                        for (int j = -radius; j <= radius; ++j)
+                        {
+                            const float* px = row + std::clamp(x + j, 0, m_width - 1) * 4;
+                            for (int c = 0; c < 4; ++c) total[c] += px[c] * kernel[j + radius];
+                        }
+                        for (int c = 0; c < 4; ++c) blurred[x * 4 + c] = static_cast<float>(total[c]);
+                    }
+                    std::copy(blurred.begin(), blurred.end(), row);
+                }
+            });
+
+            Scheduler::ForEachRange(m_width, Scheduler::TileWidth, [&](size_t begin, size_t width)
+            {
+                const size_t length = width * 4;
+                RowRing<float> ring(std::min(2 * radius + 1, m_height), length, [&](int y) { return values + y * rowLength + begin * 4; });
+                std::vector<double> sums(length);
+
+                for (int y = 0; y < std::min(radius, m_height); ++y) ring.Keep(y);
+                for (int y = 0; y < m_height; ++y)
+                {
+                    if (y + radius < m_height) ring.Keep(y + radius);
+
+                    std::fill(sums.begin(), sums.end(), 0.0);
+                    for (int j = -radius; j <= radius; ++j)
+                    {
+                        const float* src = ring.Kept(std::clamp(y + j, 0, m_height - 1));
+                        for (size_t k = 0; k < length; ++k) sums[k] += src[k] * kernel[j + radius];
+                    }
+
+                    float* dest = values + y * rowLength + begin * 4;
+                    for (size_t k = 0; k < length; ++k) dest[k] = static_cast<float>(sums[k]);
+                }
+            });
+            return;
+        }
+
+        PrepareWrite();
+
+        // Horizontal pass in place through a row of scratch per task
+        Scheduler::ForEachRange(m_height, 16, [&](size_t begin, size_t length)
+        {
+            std::vector<uint32_t> blurred(m_width);
+            for (size_t y = begin; y < begin + length; ++y)
+            {
+                const uint32_t* row = Row(static_cast<int>(y));
+                for (int x = 0; x < m_width; ++x)
+                {
+                    double r = 0, g = 0, b = 0, a = 0;
+                    for (int j = -radius; j <= radius; ++j)
+                    {
+                        const Color pixel(row[std::clamp(x + j, 0, m_width - 1)]);
+                        double weight = kernel[j + radius];
+                        r += pixel.r * weight;
+                        g += pixel.g * weight;
+                        b += pixel.b * weight;
+                        a += pixel.a * weight;
+                    }
+                    blurred[x] = PackARGB(
+                        std::clamp(static_cast<int>(r), 0, 255),
+                        std::clamp(static_cast<int>(g), 0, 255),
+                        std::clamp(static_cast<int>(b), 0, 255),
+                        std::clamp(static_cast<int>(a), 0, 255)
+                    );
+                }
+                std::copy(blurred.begin(), blurred.end(), Row(static_cast<int>(y)));
+            }
+        });
+
+        // Vertical pass in place down strips of columns, a whole strip row is accumulated per tap so rows are
+        // read contiguously. Rows above the current one are already overwritten, so the strip keeps the
+        // 2 * radius + 1 rows of its window in a ring
+        Scheduler::ForEachRange(m_width, Scheduler::TileWidth, [&](size_t begin, size_t width)
+        {
+            RowRing<uint32_t> ring(std::min(2 * radius + 1, m_height), width, [&](int y) { return Row(y) + begin; });
+            std::vector<double> sums(width * 4);
+
+            for (int y = 0; y < std::min(radius, m_height); ++y) ring.Keep(y);
+            for (int y = 0; y < m_height; ++y)
+            {
+                if (y + radius < m_height) ring.Keep(y + radius);
+
+                std::fill(sums.begin(), sums.end(), 0.0);
+                for (int j = -radius; j <= radius; ++j)
+                {
+                    const uint32_t* src = ring.Kept(std::clamp(y + j, 0, m_height - 1));
+                    double weight = kernel[j + radius];
+                    double* sum = sums.data();
+
+                    for (size_t x = 0; x < width; ++x, sum += 4)
+                    {
+                        const Color pixel(src[x]);
+                        sum[0] += pixel.r * weight;
+                        sum[1] += pixel.g * weight;
+                        sum[2] += pixel.b * weight;
+                        sum[3] += pixel.a * weight;
+                    }
+                }
+
+                uint32_t* dest = Row(y) + begin;
+                const double* sum = sums.data();
+                for (size_t x = 0; x < width; ++x, sum += 4)
+                {
+                    dest[x] = PackARGB(
+                        std::clamp(static_cast<int>(sum[0]), 0, 255),
+                        std::clamp(static_cast<int>(sum[1]), 0, 255),
+                        std::clamp(static_cast<int>(sum[2]), 0, 255),
+                        std::clamp(static_cast<int>(sum[3]), 0, 255)
+                    );
+                }
+            }
+        });
+    }
+
+    void Canvas::GaussianBlurRadius(int radius)
+    {
+        GaussianBlur(radius / 3.0);
+    }
+
+    void Canvas::RecursiveGaussianBlur(double sigma)
+    {
+        const Kernels::GaussianCoefficients coefficients(sigma);
+        const size_t rowLength = static_cast<size_t>(m_width) * 4;
+
+        // The kernel runs across contiguous floats, so the vertical pass hands it strips of columns as they
+        // are and the horizontal pass copies blocks of rows into x-major order first
+        const size_t blockRows = 16;
+        const size_t stripWidth = 128;
+
+        if (m_precision == PixelPrecision::Float32)
+        {
+            PrepareFloatWrite();
+            float* values = m_floats->data();
+
+            Scheduler::ForEachRange(m_height, blockRows, [&](size_t begin, size_t length)
+            {
+                std::vector<float> block(length * rowLength);
+                for (size_t r = 0; r < length; ++r)
+                {
+                    const float* row = values + (begin + r) * rowLength;
+                    for (int x = 0; x < m_width; ++x) std::copy_n(row + x * 4, 4, block.data() + (x * length + r) * 4);
+                }
+
+                Kernels::RecursiveGaussian(block.data(), length * 4, m_width, length * 4, coefficients);
+
+                for (size_t r = 0; r < length; ++r)
+                {
+                    float* row = values + (begin + r) * rowLength;
+                    for (int x = 0; x < m_width; ++x) std::copy_n(block.data() + (x * length + r) * 4, 4, row + x * 4);
+                }
+            });
+            Scheduler::ForEachRange(m_width, stripWidth, [&](size_t begin, size_t length)
+            {
+                Kernels::RecursiveGaussian(values + begin * 4, length * 4, m_height, rowLength, coefficients);
+            });
+            return;
+        }
+
+        PrepareWrite();
+
+        // 8-bit pixels are expanded a block or strip at a time and rounded back into place between the passes
+
+        Scheduler::ForEachRange(m_height, blockRows, [&](size_t begin, size_t length)
+        {
+            std::vector<float> block(length * rowLength);
+            std::vector<uint32_t> pixels(length);
+            for (int x = 0; x < m_width; ++x)
+            {
+                for (size_t r = 0; r < length; ++r) pixels[r] = Pixel(x, static_cast<int>(begin + r));
+                Kernels::ExpandPixels(pixels.data(), length, block.data() + x * length * 4);
+            }
+
+            Kernels::RecursiveGaussian(block.data(), length * 4, m_width, length * 4, coefficients);
+
+            for (int x = 0; x < m_width; ++x)
+            {
+                Kernels::QuantizePixels(block.data() + x * length * 4, length, pixels.data());
+                for (size_t r = 0; r < length; ++r) Pixel(x, static_cast<int>(begin + r)) = pixels[r];
+            }
+        });
+
+        Scheduler::ForEachRange(m_width, stripWidth, [&](size_t begin, size_t length)
+        {
+            const size_t stripLength = length * 4;
+            std::vector<float> strip(static_cast<size_t>(m_height) * stripLength);
+            for (int y = 0; y < m_height; ++y) Kernels::ExpandPixels(Row(y) + begin, length, strip.data() + y * stripLength);
+
+            Kernels::RecursiveGaussian(strip.data(), stripLength, m_height, stripLength, coefficients);
+            for (int y = 0; y < m_height; ++y) Kernels::QuantizePixels(strip.data() + y * stripLength, length, Row(y) + begin);
+        });
+    }
 
-    void Canvas::Pixelate(int pixelSize)
+    // Correlation is convolution with the kernel turned around, which in a cyclic transform puts tap (i, j) at
+    // (-i, -j). The transform covers the image plus the kernel's reach past every edge, so nothing the output
+    // reads wraps
+    void Canvas::SpectralConvolve(const ConvolutionKernel& kernel, int channels)
     {
-        if (pixelSize <= 1) return;
+        const int kernelWidth = kernel.GetWidth();
+        const int kernelHeight = kernel.GetHeight();
+        const int anchorX = kernelWidth / 2;
+        const int anchorY = kernelHeight / 2;
+        const size_t paddedWidth = static_cast<size_t>(m_width) + kernelWidth - 1;
+        const size_t paddedHeight = static_cast<size_t>(m_height) + kernelHeight - 1;
+        const size_t transformWidth = FFT::GoodSize(paddedWidth);
+        const size_t transformHeight = FFT::GoodSize(paddedHeight);
+
+        std::vector<double> image(transformWidth * transformHeight, 0.0);
+        for (int j = 0; j < kernelHeight; ++j)
+        {
+            for (int i = 0; i < kernelWidth; ++i)
+            {
+                image[((transformHeight - j) % transformHeight) * transformWidth + (transformWidth - i) % transformWidth] = kernel.GetWeights()[static_cast<size_t>(j) * kernelWidth + i];
+            }
+        }
 
-        int numPixelsX = (m_width + pixelSize - 1) / pixelSize;
-        int numPixelsY = (m_height + pixelSize - 1) / pixelSize;
+        FFT::Spectrum response(transformWidth, transformHeight);
+        response.Forward(image.data(), transformWidth);
 
-        #pragma omp parallel for
-        for (int i = 0; i < numPixelsX * numPixelsY; ++i)
+        FFT::Spectrum spectrum(transformWidth, transformHeight);
+        const double bias = kernel.GetBias();
+        for (int channel = 0; channel < channels; ++channel)
         {
-            int blockX = (i % numPixelsX) * pixelSize;
-            int blockY = (i / numPixelsX) * pixelSize;
+            const int shift = channel * 8;
+            FillChannel(image.data(), transformWidth, transformHeight, anchorX, anchorY, kernelWidth - 1 - anchorX, kernelHeight - 1 - anchorY, shift);
 
-            Color avgColor = CalculateAverageColor(blockX, blockY, pixelSize, pixelSize);
+            spectrum.Forward(image.data(), transformWidth);
+            spectrum.Multiply(response);
+            spectrum.Inverse(image.data(), transformWidth);
 
-            int endX = std::min(blockX + pixelSize, m_width);
-            int endY = std::min(blockY + pixelSize, m_height);
-
-            for (int j = blockY * m_width + blockX; j < endY * m_width; j += m_width)
+            Scheduler::For(m_height, [&](size_t y)
             {
-                for (int k = 0; k < endX - blockX; ++k)
-                {
-                    m_colors[j + k] = avgColor;
-                }
-            }
+                const double* values = image.data() + y * transformWidth;
+                uint32_t* row = Row(static_cast<int>(y));
+                for (int x = 0; x < m_width; ++x) row[x] = SetChannel(row[x], shift, static_cast<int>(std::floor(std::clamp(values[x] + bias, 0.0, 255.0) + 0.5)));
+            });
         }
     }
 
-    void Canvas::Blur(int radius)
+    void Canvas::FillChannel(double* image, size_t transformWidth, size_t transformHeight, int left, int top, int right, int bottom, int shift) const
     {
-        if (radius <= 0) return;
+        const size_t paddedWidth = static_cast<size_t>(m_width) + left + right;
+        const size_t paddedHeight = static_cast<size_t>(m_height) + top + bottom;
 
-        std::vector<Color> tempBuffer(m_width * m_height);
+        Scheduler::For(transformHeight, [&](size_t y)
+        {
+            double* row = image + y * transformWidth;
+            size_t x = 0;
+            if (y < paddedHeight)
+            {
+                const uint32_t* source = Row(std::clamp(static_cast<int>(y) - top, 0, m_height - 1));
+                for (; x < paddedWidth; ++x) row[x] = GetChannel(source[std::clamp(static_cast<int>(x) - left, 0, m_width - 1)], shift);
+            }
+            std::fill(row + x, row + transformWidth, 0.0);
+        });
+    }
 
-        // Horizontal pass
-        #pragma omp parallel for
-        for (int y = 0; y < m_height; ++y)
+    void Canvas::Convolve(const ConvolutionKernel& kernel, ConvolveAlpha alpha)
+    {
+        if (alpha != ConvolveAlpha::Convolve && alpha != ConvolveAlpha::Keep && alpha != ConvolveAlpha::Opaque)
+            throw std::invalid_argument("Unsupported convolution alpha mode");
+
+        PrepareWrite();
+        if (m_width == 0 || m_height == 0) return;
+
+        const int kernelWidth = kernel.GetWidth();
+        const int kernelHeight = kernel.GetHeight();
+        const int anchorX = kernelWidth / 2;
+        const int anchorY = kernelHeight / 2;
+        const int above = anchorY;
+        const int below = kernelHeight - 1 - anchorY;
+        const size_t width = static_cast<size_t>(m_width);
+
+        // `center` is the source row under the output row, for the alpha it keeps
+        const bool premultiplied = m_alphaMode == AlphaMode::Premultiplied;
+        auto finishRow = [&](uint32_t* row, const uint32_t* center)
         {
-            int sum[4] = {0, 0, 0, 0};
-            for (int x = 0; x < radius; ++x)
+            if (alpha == ConvolveAlpha::Opaque)
             {
-                Color pixel = m_colors[y * m_width + x];
-                sum[0] += pixel.GetRed();
-                sum[1] += pixel.GetGreen();
-                sum[2] += pixel.GetBlue();
-                sum[3] += pixel.GetAlpha();
+                for (size_t x = 0; x < width; ++x) row[x] |= 0xFF000000;
+            }
+            else if (alpha == ConvolveAlpha::Keep)
+            {
+                for (size_t x = 0; x < width; ++x) row[x] = (row[x] & 0x00FFFFFF) | (center[x] & 0xFF000000);
             }
 
-            for (int x = 0; x < m_width; ++x)
+            // Premultiplied colour can't be brighter than its alpha
+            if (premultiplied && alpha != ConvolveAlpha::Opaque)
             {
-                if (x > radius)
+                for (size_t x = 0; x < width; ++x)
                 {
-                    Color removePixel = m_colors[y * m_width + x - radius - 1];
-                    sum[0] -= removePixel.GetRed();
-                    sum[1] -= removePixel.GetGreen();
-                    sum[2] -= removePixel.GetBlue();
-                    sum[3] -= removePixel.GetAlpha();
+                    const uint32_t a = row[x] >> 24;
+                    row[x] = (a << 24) | (std::min((row[x] >> 16) & 0xFF, a) << 16) | (std::min((row[x] >> 8) & 0xFF, a) << 8) | std::min(row[x] & 0xFF, a);
                 }
-                if (x + radius < m_width)
+            }
+        };
+
+        // The spectral path leaves alpha alone unless it convolves it, so the row is its own centre
+        const int channels = alpha == ConvolveAlpha::Convolve ? 4 : 3;
+        if (!kernel.IsFixedPoint() && UseFrequencyDomain(kernel, m_width, m_height, channels))
+        {
+            SpectralConvolve(kernel, channels);
+            Scheduler::For(m_height, [&](size_t y) { finishRow(Row(static_cast<int>(y)), Row(static_cast<int>(y))); });
+            return;
+        }
+
+        // Zero weights are dropped, a cross or a diagonal pair only reads the pixels it uses
+        std::vector<Kernels::FixedTap> taps;
+        int shift = 0;
+        int32_t offset = 0;
+        if (kernel.IsFixedPoint())
+        {
+            const std::vector<int16_t>& fixed = kernel.GetFixedWeights();
+            for (int ky = 0; ky < kernelHeight; ++ky)
+            {
+                for (int kx = 0; kx < kernelWidth; ++kx)
                 {
-                    Color addPixel = m_colors[y * m_width + x + radius];
-                    sum[0] += addPixel.GetRed();
-                    sum[1] += addPixel.GetGreen();
-                    sum[2] += addPixel.GetBlue();
-                    sum[3] += addPixel.GetAlpha();
+                    const int16_t weight = fixed[static_cast<size_t>(ky) * kernelWidth + kx];
+                    if (weight != 0) taps.push_back({ky, kx, weight});
                 }
-                int count = std::min(x + radius + 1, m_width) - std::max(x - radius, 0);
-                tempBuffer[y * m_width + x] = Color(sum[0] / count, sum[1] / count, sum[2] / count, sum[3] / count);
             }
+
+            shift = kernel.GetFixedShift();
+            offset = static_cast<int32_t>(std::lround(std::ldexp(static_cast<double>(kernel.GetBias()), shift))) + (shift > 0 ? 1 << (shift - 1) : 0);
         }
 
-        // Vertical pass
-        #pragma omp parallel for
-        for (int x = 0; x < m_width; ++x)
+        // Bands of rows are filtered in place, each through its own ring of kernelHeight padded rows: a row
+        // joins the ring before the band overwrites it. The rows a band reads past its own edges belong to
+        // the neighbouring bands, which may overwrite them first, so those few are copied out up front.
+        // Extra memory is a few rows per band instead of a copy of the image
+        const size_t bandCount = std::min<size_t>(m_height, static_cast<size_t>(std::max(1, Scheduler::GetThreadCount())) * 2);
+        const int bandRows = static_cast<int>((m_height + bandCount - 1) / bandCount);
+        auto bandBegin = [&](size_t band) { return std::min(m_height, static_cast<int>(band) * bandRows); };
+
+        std::vector<std::vector<uint32_t>> halos(bandCount);
+        Scheduler::For(bandCount, [&](size_t band)
+        {
+            const int begin = bandBegin(band), end = bandBegin(band + 1);
+            const int first = std::max(0, begin - above), last = std::min(m_height, end + below);
+            std::vector<uint32_t>& halo = halos[band];
+            halo.resize(static_cast<size_t>((begin - first) + (last - end)) * width);
+
+            uint32_t* dest = halo.data();
+            for (int y = first; y < begin; ++y, dest += width) std::copy_n(Row(y), width, dest);
+            for (int y = end; y < last; ++y, dest += width) std::copy_n(Row(y), width, dest);
+        });
+
+        const size_t paddedWidth = width + kernelWidth - 1;
+        const size_t rowLength = width * 4;
+        const bool separable = !kernel.IsFixedPoint() && kernel.IsSeparable();
+
+        Scheduler::For(bandCount, [&](size_t band)
         {
-            int sum[4] = {0, 0, 0, 0};
-            for (int y = 0; y < radius; ++y)
+            const int begin = bandBegin(band), end = bandBegin(band + 1);
+            if (begin == end) return;
+
+            const int first = std::max(0, begin - above);
+            auto source = [&](int y) -> const uint32_t*
             {
-                Color pixel = tempBuffer[y * m_width + x];
-                sum[0] += pixel.GetRed();
-                sum[1] += pixel.GetGreen();
-                sum[2] += pixel.GetBlue();
-                sum[3] += pixel.GetAlpha();
-            }
+                if (y < begin) return halos[band].data() + static_cast<size_t>(y - first) * width;
+                if (y >= end) return halos[band].data() + static_cast<size_t>((begin - first) + (y - end)) * width;
+                return Row(y);
+            };
+
+            // Slot p % kernelHeight holds padded row p, which is source row p - above with the edges repeated.
+            // Separable kernels keep each row's horizontal pass alongside it
+            std::vector<uint32_t> ring(kernelHeight * paddedWidth);
+            std::vector<float> horizontal(separable ? kernelHeight * rowLength : 0);
+            std::vector<float> acc(kernel.IsFixedPoint() ? 0 : rowLength);
+            std::vector<const uint32_t*> rows(kernelHeight);
+
+            auto enter = [&](int p)
+            {
+                const size_t slot = static_cast<size_t>(p % kernelHeight);
+                const uint32_t* row = source(std::clamp(p - above, 0, m_height - 1));
+                uint32_t* dest = ring.data() + slot * paddedWidth;
+                std::fill_n(dest, anchorX, row[0]);
+                std::copy_n(row, width, dest + anchorX);
+                std::fill_n(dest + anchorX + width, kernelWidth - 1 - anchorX, row[width - 1]);
+
+                if (separable)
+                {
+                    float* values = horizontal.data() + slot * rowLength;
+                    std::fill_n(values, rowLength, 0.0f);
+                    Kernels::AccumulateTaps(dest, kernel.GetRowFactor().data(), kernelWidth, width, values);
+                }
+            };
 
-            for (int y = 0; y < m_height; ++y)
+            for (int p = begin; p < begin + kernelHeight - 1; ++p) enter(p);
+
+            for (int y = begin; y < end; ++y)
             {
-                if (y > radius)
+                enter(y + kernelHeight - 1);
+                for (int ky = 0; ky < kernelHeight; ++ky) rows[ky] = ring.data() + static_cast<size_t>((y + ky) % kernelHeight) * paddedWidth;
+
+                uint32_t* out = Row(y);
+                if (kernel.IsFixedPoint())
+                {
+                    Kernels::ConvolveFixed(rows.data(), taps.data(), taps.size(), shift, offset, width, out);
+                }
+                else if (separable)
                 {
-                    Color removePixel = tempBuffer[(y - radius - 1) * m_width + x];
-                    sum[0] -= removePixel.GetRed();
-                    sum[1] -= removePixel.GetGreen();
-                    sum[2] -= removePixel.GetBlue();
-                    sum[3] -= removePixel.GetAlpha();
+                    std::fill(acc.begin(), acc.end(), 0.0f);
+                    for (int ky = 0; ky < kernelHeight; ++ky)
+                    {
+                        const float w = kernel.GetColumnFactor()[ky];
+                        const float* values = horizontal.data() + static_cast<size_t>((y + ky) % kernelHeight) * rowLength;
+                        for (size_t i = 0; i < rowLength; ++i) acc[i] += w * values[i];
+                    }
+                    Kernels::PackChannels(acc.data(), width, kernel.GetBias(), out);
                 }
-                if (y + radius < m_height)
+                else
                 {
-                    Color addPixel = tempBuffer[(y + radius) * m_width + x];
-                    sum[0] += addPixel.GetRed();
-                    sum[1] += addPixel.GetGreen();
-                    sum[2] += addPixel.GetBlue();
-                    sum[3] += addPixel.GetAlpha();
+                    std::fill(acc.begin(), acc.end(), 0.0f);
+                    for (int ky = 0; ky < kernelHeight; ++ky)
+                    {
+                        Kernels::AccumulateTaps(rows[ky], kernel.GetWeights().data() + static_cast<size_t>(ky) * kernelWidth, kernelWidth, width, acc.data());
+                    }
+                    Kernels::PackChannels(acc.data(), width, kernel.GetBias(), out);
                 }
-                int count = std::min(y + radius + 1, m_height) - std::max(y - radius, 0);
-                m_colors[y * m_width + x] = Color(sum[0] / count, sum[1] / count, sum[2] / count, sum[3] / count);
+
+                finishRow(out, rows[above] + anchorX);
             }
-        }
+        });
     }
 
-    void Canvas::GaussianBlur(double sigma)
+    void Canvas::Sharpen(float amount)
     {
-        int radius = static_cast<int>(ceil(3 * sigma));
-        std::vector<double> kernel(2 * radius + 1);
-        double sum = 0.0;
-
-        // Generate 1D Gaussian kernel
-        for (int i = -radius; i <= radius; ++i)
-        {
-            kernel[i + radius] = exp(-(i * i) / (2 * sigma * sigma));
-            sum += kernel[i + radius];
-        }
+        if (amount <= 0) return;
 
-        // Normalize kernel
-        for (auto& k : kernel)
-            k /= sum;
+        const float a = amount;
+        Convolve(ConvolutionKernel(3, 3, {0, -a, 0, -a, 4 * a + 1, -a, 0, -a, 0}), ConvolveAlpha::Keep);
+    }
 
-        std::vector<Color> tempBuffer(m_width * m_height);
+    void Canvas::LowPass(double cutoff) { FrequencyFilter(cutoff, false); }
+    void Canvas::HighPass(double cutoff) { FrequencyFilter(cutoff, true); }
 
-        // Horizontal pass
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
+    void Canvas::FrequencyFilter(double cutoff, bool highPass)
+    {
+        if (!std::isfinite(cutoff) || cutoff <= 0.0)
+            throw std::invalid_argument("Cutoff must be a positive frequency");
+
+        PrepareWrite();
+        if (m_width == 0 || m_height == 0) return;
+
+        // The response's spatial twin is a Gaussian with sigma 1 / (2 pi cutoff). Three of those of repeated
+        // edges keep the cyclic transform from bleeding one side of the image into the other
+        const int margin = std::min(static_cast<int>(std::ceil(3.0 / (2.0 * CONST_PI * cutoff))), std::max(m_width, m_height));
+        const size_t paddedWidth = static_cast<size_t>(m_width) + 2 * margin;
+        const size_t paddedHeight = static_cast<size_t>(m_height) + 2 * margin;
+        const size_t transformWidth = FFT::GoodSize(paddedWidth);
+        const size_t transformHeight = FFT::GoodSize(paddedHeight);
+
+        FFT::Spectrum spectrum(transformWidth, transformHeight);
+        std::vector<double> response(spectrum.GetBins() * transformHeight);
+        Scheduler::For(transformHeight, [&](size_t ky)
         {
-            int x = i % m_width;
-            int y = i / m_width;
-
-            double r = 0, g = 0, b = 0, a = 0;
-            for (int j = -radius; j <= radius; ++j)
+            const double fy = (ky <= transformHeight / 2 ? static_cast<double>(ky) : static_cast<double>(ky) - transformHeight) / transformHeight;
+            for (size_t kx = 0; kx < spectrum.GetBins(); ++kx)
             {
-                int sx = std::clamp(x + j, 0, m_width - 1);
-                const Color& pixel = m_colors[y * m_width + sx];
-                double weight = kernel[j + radius];
-                r += pixel.r * weight;
-                g += pixel.g * weight;
-                b += pixel.b * weight;
-                a += pixel.a * weight;
+                const double fx = static_cast<double>(kx) / transformWidth;
+                const double gain = std::exp(-(fx * fx + fy * fy) / (2.0 * cutoff * cutoff));
+                response[ky * spectrum.GetBins() + kx] = highPass ? 1.0 - gain : gain;
             }
-            tempBuffer[i] = Color(
-                std::clamp(static_cast<int>(r), 0, 255),
-                std::clamp(static_cast<int>(g), 0, 255),
-                std::clamp(static_cast<int>(b), 0, 255),
-                std::clamp(static_cast<int>(a), 0, 255)
-            );
-        }
+        });
 
-        // Vertical pass
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
+        // High-pass detail sits around mid grey, like Emboss
+        const double bias = highPass ? 128.0 : 0.0;
+        const bool premultiplied = m_alphaMode == AlphaMode::Premultiplied;
+        std::vector<double> image(transformWidth * transformHeight);
+        for (int channel = 0; channel < 3; ++channel)
         {
-            int x = i % m_width;
-            int y = i / m_width;
+            const int shift = channel * 8;
+            FillChannel(image.data(), transformWidth, transformHeight, margin, margin, margin, margin, shift);
 
-            double r = 0, g = 0, b = 0, a = 0;
-            for (int j = -radius; j <= radius; ++j)
+            spectrum.Forward(image.data(), transformWidth);
+            Scheduler::For(transformHeight, [&](size_t ky)
             {
-                int sy = std::clamp(y + j, 0, m_height - 1);
-                const Color& pixel = tempBuffer[sy * m_width + x];
-                double weight = kernel[j + radius];
-                r += pixel.r * weight;
-                g += pixel.g * weight;
-                b += pixel.b * weight;
-                a += pixel.a * weight;
-            }
-            m_colors[i] = Color(
-                std::clamp(static_cast<int>(r), 0, 255),
-                std::clamp(static_cast<int>(g), 0, 255),
-                std::clamp(static_cast<int>(b), 0, 255),
-                std::clamp(static_cast<int>(a), 0, 255)
-            );
+                FFT::Complex* bins = spectrum.Row(ky);
+                const double* gains = response.data() + ky * spectrum.GetBins();
+                for (size_t kx = 0; kx < spectrum.GetBins(); ++kx) bins[kx] *= gains[kx];
+            });
+            spectrum.Inverse(image.data(), transformWidth);
+
+            Scheduler::For(m_height, [&](size_t y)
+            {
+                const double* values = image.data() + (y + margin) * transformWidth + margin;
+                uint32_t* row = Row(static_cast<int>(y));
+                for (int x = 0; x < m_width; ++x)
+                {
+                    const double limit = premultiplied ? static_cast<double>(row[x] >> 24) : 255.0;
+                    row[x] = SetChannel(row[x], shift, static_cast<int>(std::floor(std::clamp(values[x] + bias, 0.0, limit) + 0.5)));
+                }
+            });
         }
     }
 
-    void Canvas::Sharpen(float amount)
+    PhaseCorrelation Canvas::PhaseCorrelate(const Canvas& other) const
     {
-        if (amount <= 0) return;
+        if (other.m_width != m_width || other.m_height != m_height)
+            throw std::invalid_argument("PhaseCorrelate needs canvases of the same size");
+        if (m_width == 0 || m_height == 0) return {0.0, 0.0, 0.0};
+
+        FlushMatrixBatch();
+        other.FlushMatrixBatch();
 
-        std::vector<Color> newColors(m_width * m_height);
+        const size_t transformWidth = FFT::GoodSize(m_width);
+        const size_t transformHeight = FFT::GoodSize(m_height);
+        std::vector<double> image(transformWidth * transformHeight);
 
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
+        // Luma less its mean, under a Hann window so the image borders don't line up with each other instead
+        auto transform = [&](const Canvas& canvas, FFT::Spectrum& spectrum)
         {
-            int x = i % m_width;
-            int y = i / m_width;
+            std::fill(image.begin(), image.end(), 0.0);
+            std::vector<double> rowSums(m_height);
+            Scheduler::For(m_height, [&](size_t y)
+            {
+                const uint32_t* row = canvas.Row(static_cast<int>(y));
+                double* values = image.data() + y * transformWidth;
+                double sum = 0.0;
+                for (int x = 0; x < m_width; ++x)
+                {
+                    values[x] = 0.299 * GetChannel(row[x], 16) + 0.587 * GetChannel(row[x], 8) + 0.114 * GetChannel(row[x], 0);
+                    sum += values[x];
+                }
+                rowSums[y] = sum;
+            });
+
+            double mean = 0.0;
+            for (double sum : rowSums) mean += sum;
+            mean /= static_cast<double>(m_width) * m_height;
+
+            auto hann = [](int i, int count) { return count > 1 ? 0.5 - 0.5 * std::cos(2.0 * CONST_PI * i / (count - 1)) : 1.0; };
+            Scheduler::For(m_height, [&](size_t y)
+            {
+                double* values = image.data() + y * transformWidth;
+                const double wy = hann(static_cast<int>(y), m_height);
+                for (int x = 0; x < m_width; ++x) values[x] = (values[x] - mean) * wy * hann(x, m_width);
+            });
 
-            Color center = m_colors[i];
-            Color left = (x > 0) ? m_colors[i - 1] : center;
-            Color right = (x < m_width - 1) ? m_colors[i + 1] : center;
-            Color top = (y > 0) ? m_colors[i - m_width] : center;
-            Color bottom = (y < m_height - 1) ? m_colors[i + m_width] : center;
+            spectrum.Forward(image.data(), transformWidth);
+        };
+
+        FFT::Spectrum first(transformWidth, transformHeight);
+        FFT::Spectrum second(transformWidth, transformHeight);
+        transform(*this, first);
+        transform(other, second);
+
+        // Normalising the cross-power spectrum leaves only the phase difference, which transforms back to a
+        // spike at the offset
+        Scheduler::For(transformHeight, [&](size_t ky)
+        {
+            FFT::Complex* a = first.Row(ky);
+            const FFT::Complex* b = second.Row(ky);
+            for (size_t kx = 0; kx < first.GetBins(); ++kx)
+            {
+                const FFT::Complex cross = std::conj(a[kx]) * b[kx];
+                const double magnitude = std::abs(cross);
+                a[kx] = magnitude > 1e-12 ? cross / magnitude : FFT::Complex();
+            }
+        });
+        first.Inverse(image.data(), transformWidth);
 
-            Color sharpened = center * (4 * amount + 1) - (left + right + top + bottom) * amount;
-            newColors[i] = sharpened;
+        size_t peak = 0;
+        for (size_t i = 1; i < image.size(); ++i)
+        {
+            if (image[i] > image[peak]) peak = i;
         }
 
-        m_colors = std::move(newColors);
+        const size_t px = peak % transformWidth;
+        const size_t py = peak / transformWidth;
+        auto at = [&](size_t x, size_t y) { return image[(y % transformHeight) * transformWidth + x % transformWidth]; };
+
+        // A parabola through the peak and its neighbours places it between pixels
+        auto refine = [](double before, double centre, double after)
+        {
+            const double curvature = before - 2.0 * centre + after;
+            return curvature < 0.0 ? 0.5 * (before - after) / curvature : 0.0;
+        };
+
+        double dx = static_cast<double>(px) + refine(at(px + transformWidth - 1, py), image[peak], at(px + 1, py));
+        double dy = static_cast<double>(py) + refine(at(px, py + transformHeight - 1), image[peak], at(px, py + 1));
+        if (dx > transformWidth / 2.0) dx -= static_cast<double>(transformWidth);
+        if (dy > transformHeight / 2.0) dy -= static_cast<double>(transformHeight);
+
+        return {dx, dy, image[peak]};
     }
 
     void Canvas::Flip(bool horizontal)
     {
+        PrepareWrite();
+
         if (horizontal)
         {
-            #pragma omp parallel for
-            for (int i = 0; i < m_height * m_width / 2; ++i)
+            Scheduler::For(m_height, [&](size_t y)
             {
-                int y = i / (m_width / 2);
-                int x = i % (m_width / 2);
-                std::swap(m_colors[y * m_width + x], m_colors[y * m_width + (m_width - 1 - x)]);
-            }
+                uint32_t* row = Row(static_cast<int>(y));
+                std::reverse(row, row + m_width);
+            });
         }
         else // vertical flip
         {
-            #pragma omp parallel for
-            for (int i = 0; i < m_width * m_height / 2; ++i)
+            Scheduler::For(m_height / 2, [&](size_t row)
             {
-                int x = i % m_width;
-                int y = i / m_width;
-                std::swap(m_colors[y * m_width + x], m_colors[(m_height - 1 - y) * m_width + x]);
-            }
+                const int y = static_cast<int>(row);
+                std::swap_ranges(Row(y), Row(y) + m_width, Row(m_height - 1 - y));
+            });
         }
     }
 
     void Canvas::Crop(int x, int y, int width, int height)
     {
+        FlushMatrixBatch();
+
         if (x < 0 || y < 0 || x + width > m_width || y + height > m_height)
         {
             throw std::out_of_range("Crop dimensions are out of bounds");
         }
 
-        std::vector<Color> newColors;
-        newColors.reserve(width * height);
-
-        #pragma omp parallel for
-        for (int i = 0; i < width * height; ++i)
+        // Wrapped memory stays where it is, the canvas just looks at less of it
+        if (m_wrapped)
         {
-            int newX = i % width;
-            int newY = i / width;
-            newColors.push_back(m_colors[(y + newY) * m_width + (x + newX)]);
+            m_data = &Pixel(x, y);
+            m_width = width;
+            m_height = height;
+            return;
         }
 
-        m_colors = std::move(newColors);
-        m_width = width;
-        m_height = height;
+        RequireNoViews("Crop");
+
+        PixelBuffer newPixels = AllocatePixels(width, height);
+        const ptrdiff_t stride = PaddedStride(width);
+
+        Scheduler::For(height, [&](size_t row)
+        {
+            std::copy_n(Row(y + static_cast<int>(row)) + x, width, newPixels.begin() + row * stride);
+        });
+
+        ReplacePixels(std::move(newPixels), width, height);
     }
 
     void Canvas::AdjustContrast(double factor)
     {
-        #pragma omp parallel for
-        for (auto& color : m_colors)
-        {
-            int r = static_cast<int>((color.GetRed() - 128) * factor + 128);
-            int g = static_cast<int>((color.GetGreen() - 128) * factor + 128);
-            int b = static_cast<int>((color.GetBlue() - 128) * factor + 128);
-            color = Color(std::clamp(r, 0, 255), std::clamp(g, 0, 255), std::clamp(b, 0, 255), color.GetAlpha());
-        }
+        // (c - 128) * factor + 128, expressed on 0-1 channels so it can join a matrix batch
+        double offset = 128.0 * (1.0 - factor) / 255.0;
+
+        ApplyMatrix({{
+            {factor, 0     , 0     , 0, offset},
+            {0     , factor, 0     , 0, offset},
+            {0     , 0     , factor, 0, offset},
+            {0     , 0     , 0     , 1, 0     },
+            {0     , 0     , 0     , 0, 1     }
+        }});
     }
 
     void Canvas::AdjustColorBalance(double redFactor, double greenFactor, double blueFactor)
     {
-        #pragma omp parallel for
-        for (auto& color : m_colors)
-        {
-            int r = static_cast<int>(color.GetRed() * redFactor);
-            int g = static_cast<int>(color.GetGreen() * greenFactor);
-            int b = static_cast<int>(color.GetBlue() * blueFactor);
-            color = Color(std::clamp(r, 0, 255), std::clamp(g, 0, 255), std::clamp(b, 0, 255), color.GetAlpha());
-        }
+        ApplyMatrix({{
+            {redFactor, 0          , 0         , 0, 0},
+            {0        , greenFactor, 0         , 0, 0},
+            {0        , 0          , blueFactor, 0, 0},
+            {0        , 0          , 0         , 1, 0},
+            {0        , 0          , 0         , 0, 1}
+        }});
     }
 
     void Canvas::OverlayImage(const Canvas& overlay, int x, int y, double opacity)
     {
-        #pragma omp parallel for
-        for (int i = 0; i < overlay.GetWidth() * overlay.GetHeight(); ++i)
+        PrepareWrite();
+        overlay.FlushMatrixBatch();
+
+        if (m_alphaMode == AlphaMode::Premultiplied)
+        {
+            // Only the rows and columns that land on this canvas
+            const int left = std::max(x, 0), top = std::max(y, 0);
+            const int right = std::min(x + overlay.GetWidth(), m_width), bottom = std::min(y + overlay.GetHeight(), m_height);
+            if (left >= right || top >= bottom) return;
+
+            const size_t count = static_cast<size_t>(right - left);
+            const uint32_t alpha = static_cast<uint32_t>(std::lround(std::clamp(opacity, 0.0, 1.0) * 255.0));
+            const bool straight = overlay.m_alphaMode == AlphaMode::Straight;
+
+            // Blocks of rows so a straight overlay needs one scratch row per block rather than per row
+            Scheduler::ForEachRange(static_cast<size_t>(bottom - top), 16, [&](size_t begin, size_t length)
+            {
+                std::vector<uint32_t> row(straight ? count : 0);
+                for (size_t r = begin; r < begin + length; ++r)
+                {
+                    const int destY = top + static_cast<int>(r);
+                    const uint32_t* source = overlay.Row(destY - y) + (left - x);
+                    if (straight)
+                    {
+                        std::copy_n(source, count, row.data());
+                        Kernels::Premultiply(row.data(), count);
+                        source = row.data();
+                    }
+                    Kernels::CompositeOver(Row(destY) + left, source, count, alpha);
+                }
+            });
+            return;
+        }
+
+        // A premultiplied overlay is unpremultiplied pixel by pixel so this path blends the same colours
+        const bool premultiplied = overlay.m_alphaMode == AlphaMode::Premultiplied;
+
+        Scheduler::ForEachPixel(overlay.GetWidth(), overlay.GetHeight(), [&](int dx, int dy, size_t)
         {
-            int dx = i % overlay.GetWidth();
-            int dy = i / overlay.GetWidth();
             int destX = x + dx;
             int destY = y + dy;
 
             if (destX >= 0 && destX < m_width && destY >= 0 && destY < m_height)
             {
-                const Color& overlayColor = overlay.GetAt(i);
+                uint32_t overlayPixel = overlay.Pixel(dx, dy);
+                if (premultiplied) Kernels::Unpremultiply(&overlayPixel, 1);
+
+                const Color overlayColor(overlayPixel);
                 if (overlayColor.GetAlpha() > 0) // Only blend non-transparent pixels
                 {
                     double alpha = (overlayColor.GetAlpha() / 255.0) * opacity;
-                    Color& baseColor = m_colors[destY * m_width + destX];
-                    baseColor = Color::Mix(baseColor, overlayColor, alpha);
+                    uint32_t& basePixel = Pixel(destX, destY);
+                    basePixel = Color::Mix(Color(basePixel), overlayColor, alpha).argb;
                 }
             }
-        }
+        });
     }
 
     void Canvas::Emboss()
     {
-        Canvas temp = *this;
-
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
-        {
-            int x = i % m_width;
-            int y = i / m_width;
-
-            if (x == 0 || y == 0 || x == m_width - 1 || y == m_height - 1)
-            {
-                m_colors[i] = Color(128, 128, 128);
-                continue;
-            }
-
-            Color topLeft = temp.Get(x - 1, y - 1);
-            Color bottomRight = temp.Get(x + 1, y + 1);
-
-            int r = std::clamp(bottomRight.GetRed() - topLeft.GetRed() + 128, 0, 255);
-            int g = std::clamp(bottomRight.GetGreen() - topLeft.GetGreen() + 128, 0, 255);
-            int b = std::clamp(bottomRight.GetBlue() - topLeft.GetBlue() + 128, 0, 255);
-
-            m_colors[i] = Color(r, g, b);
-        }
+        Convolve(ConvolutionKernel(3, 3, {-1, 0, 0, 0, 0, 0, 0, 0, 1}, 128.0f), ConvolveAlpha::Opaque);
     }
 
     void Canvas::EdgeDetect()
     {
-        Canvas temp = *this;
-        int kernel[3][3] = {{-1, -1, -1}, {-1, 8, -1}, {-1, -1, -1}};
-
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
-        {
-            int x = i % m_width;
-            int y = i / m_width;
-
-            if (x == 0 || y == 0 || x == m_width - 1 || y == m_height - 1)
-            {
-                m_colors[i] = Color(0, 0, 0);
-                continue;
-            }
-
-            int r = 0, g = 0, b = 0;
-            for (int k = 0; k < 9; ++k)
-            {
-                int kx = k % 3 - 1;
-                int ky = k / 3 - 1;
-                Color neighborColor = temp.Get(x + kx, y + ky);
-                r += neighborColor.GetRed() * kernel[ky+1][kx+1];
-                g += neighborColor.GetGreen() * kernel[ky+1][kx+1];
-                b += neighborColor.GetBlue() * kernel[ky+1][kx+1];
-            }
-
-            m_colors[i] = Color(std::clamp(r, 0, 255), std::clamp(g, 0, 255), std::clamp(b, 0, 255));
-        }
+        Convolve(ConvolutionKernel(3, 3, {-1, -1, -1, -1, 8, -1, -1, -1, -1}), ConvolveAlpha::Opaque);
     }
 
     void Canvas::Vignette(double strength, double radius)
     {
+        PrepareWrite();
+
         int centerX = m_width / 2;
         int centerY = m_height / 2;
-        int size = m_width * m_height;
-
-        #pragma omp parallel for
-        for (int i = 0; i < size; ++i)
+        Scheduler::ForEachPixel(m_width, m_height, [&](int x, int y, size_t)
         {
-            int x = i % m_width;
-            int y = i / m_width;
             double dx = (x - centerX) / static_cast<double>(centerX);
             double dy = (y - centerY) / static_cast<double>(centerY);
             double distance = std::sqrt(dx * dx + dy * dy);
@@ -483,47 +1734,57 @@ namespace KTLib
             double falloff = 1.0 - std::pow(std::min(distance / radius, 1.0), 2.0);
             double vignette = 1.0 - strength * (1.0 - falloff);
 
-            m_colors[i].ShiftValue(-100 * (1.0 - vignette));
-            m_colors[i].ShiftSaturation(-50 * (1.0 - vignette));
-        }
+            uint32_t& px = Pixel(x, y);
+            Color color(px);
+            color.ShiftValue(-100 * (1.0 - vignette));
+            color.ShiftSaturation(-50 * (1.0 - vignette));
+            px = color.argb;
+        });
     }
 
-    void Canvas::TwoColorNoise(double density, const Color& colorOne, const Color& colorTwo)
+    void Canvas::TwoColorNoise(double density, const Color& colorOne, const Color& colorTwo, uint64_t seed)
     {
-        std::mt19937 gen(static_cast<unsigned int>(std::time(nullptr)));
-        std::uniform_real_distribution<> dis(0.0, 1.0);
+        PrepareWrite();
 
-        int totalPixels = m_width * m_height;
+        seed = Random::ResolveSeed(seed);
 
-        #pragma omp parallel for
-        for (int i = 0; i < totalPixels; ++i)
-            if (dis(gen) < density)
-                m_colors[i] = (dis(gen) < 0.5) ? colorTwo : colorOne;
+        // One block per pixel: the first half decides whether it is hit, the second which color it gets
+        ForEachSpan([&](uint32_t* pixels, size_t count, size_t index)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                Random::Block block = Random::Philox(seed, index + i);
+                if (Random::Detail::ToUnit(block[0], block[1]) < density)
+                    pixels[i] = (Random::Detail::ToUnit(block[2], block[3]) < 0.5) ? colorTwo.argb : colorOne.argb;
+            }
+        });
     }
 
-    void Canvas::GaussianNoise(double mean, double stdDev)
+    void Canvas::GaussianNoise(double mean, double stdDev, uint64_t seed)
     {
-        std::random_device rd{};
-        std::mt19937 gen{rd()};
-        std::normal_distribution<> d{mean, stdDev};
+        PrepareWrite();
 
-        #pragma omp parallel for
-        for (auto& color : m_colors)
+        seed = Random::ResolveSeed(seed);
+
+        ForEachSpan([&](uint32_t* pixels, size_t count, size_t index)
         {
-            int noise = static_cast<int>(d(gen));
-            color += noise;
-        }
+            for (size_t i = 0; i < count; ++i)
+            {
+                int noise = static_cast<int>(mean + stdDev * Random::Normal(seed, index + i));
+                pixels[i] = (Color(pixels[i]) + noise).argb;
+            }
+        });
     }
 
-    void Canvas::PerlinNoise(double frequency, double amplitude, int octaves, double persistence, double lacunarity)
+    void Canvas::PerlinNoise(double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed)
     {
-        int seed = std::random_device{}();
-        std::mt19937 gen(seed);
-        std::uniform_int_distribution<> dis(0, 255);
+        PrepareWrite();
+
+        Random::Stream gen(Random::ResolveSeed(seed));
 
         std::vector<int> p(512);
         for (int i = 0; i < 256; ++i) p[i] = i;
-        std::shuffle(p.begin(), p.begin() + 256, gen);
+        gen.Shuffle(p.begin(), p.begin() + 256);
         for (int i = 0; i < 256; ++i) p[256 + i] = p[i];
 
         auto fade = [](double t) { return t * t * t * (t * (t * 6 - 15) + 10); };
@@ -545,12 +1806,8 @@ namespace KTLib
                            lerp(u, grad(p[AB], x, y - 1, 0), grad(p[BB], x - 1, y - 1, 0)));
         };
 
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
+        Scheduler::ForEachPixel(m_width, m_height, [&](int x, int y, size_t)
         {
-            int x = i % m_width;
-            int y = i / m_width;
-
             double total = 0;
             double freq = frequency;
             double amp = amplitude;
@@ -568,22 +1825,23 @@ namespace KTLib
             total = (total + 1) / 2;  // Normalize to 0-1
             int noiseColor = static_cast<int>(total * 255);
 
-            Color& color = m_colors[i];
-            color.r = std::clamp(color.r + noiseColor, 0, 255);
-            color.g = std::clamp(color.g + noiseColor, 0, 255);
-            color.b = std::clamp(color.b + noiseColor, 0, 255);
-        }
+            uint32_t& px = Pixel(x, y);
+            px = PackARGB(std::clamp(GetChannel(px, RedShift) + noiseColor, 0, 255),
+                          std::clamp(GetChannel(px, GreenShift) + noiseColor, 0, 255),
+                          std::clamp(GetChannel(px, BlueShift) + noiseColor, 0, 255),
+                          GetChannel(px, AlphaShift));
+        });
     }
 
-    void Canvas::SimplexNoise(double frequency, double amplitude, int octaves, double persistence, double lacunarity)
+    void Canvas::SimplexNoise(double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed)
     {
-        int seed = std::random_device{}();
-        std::mt19937 gen(seed);
-        std::uniform_int_distribution<> dis(0, 255);
+        PrepareWrite();
+
+        Random::Stream gen(Random::ResolveSeed(seed));
 
         std::vector<int> perm(512);
         for (int i = 0; i < 256; i++) perm[i] = i;
-        std::shuffle(perm.begin(), perm.begin() + 256, gen);
+        gen.Shuffle(perm.begin(), perm.begin() + 256);
         for (int i = 0; i < 256; i++) perm[i + 256] = perm[i];
 
         auto dot = [](const std::array<double, 3>& g, double x, double y) {
@@ -649,12 +1907,8 @@ namespace KTLib
             return 70.0 * (n0 + n1 + n2);
         };
 
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
+        Scheduler::ForEachPixel(m_width, m_height, [&](int x, int y, size_t)
         {
-            int x = i % m_width;
-            int y = i / m_width;
-
             double total = 0;
             double freq = frequency;
             double amp = amplitude;
@@ -672,22 +1926,23 @@ namespace KTLib
             total = (total + 1) / 2;  // Normalize to 0-1
             int noiseColor = static_cast<int>(total * 255);
 
-            Color& color = m_colors[i];
-            color.r = std::clamp(color.r + noiseColor, 0, 255);
-            color.g = std::clamp(color.g + noiseColor, 0, 255);
-            color.b = std::clamp(color.b + noiseColor, 0, 255);
-        }
+            uint32_t& px = Pixel(x, y);
+            px = PackARGB(std::clamp(GetChannel(px, RedShift) + noiseColor, 0, 255),
+                          std::clamp(GetChannel(px, GreenShift) + noiseColor, 0, 255),
+                          std::clamp(GetChannel(px, BlueShift) + noiseColor, 0, 255),
+                          GetChannel(px, AlphaShift));
+        });
     }
 
-    void Canvas::FractalBrownianMotion(double frequency, double amplitude, int octaves, double persistence, double lacunarity)
+    void Canvas::FractalBrownianMotion(double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed)
     {
-        int seed = std::random_device{}();
-        std::mt19937 gen(seed);
-        std::uniform_int_distribution<> dis(0, 255);
+        PrepareWrite();
+
+        Random::Stream gen(Random::ResolveSeed(seed));
 
         std::vector<int> p(512);
         for (int i = 0; i < 256; ++i) p[i] = i;
-        std::shuffle(p.begin(), p.begin() + 256, gen);
+        gen.Shuffle(p.begin(), p.begin() + 256);
         for (int i = 0; i < 256; ++i) p[256 + i] = p[i];
 
         auto fade = [](double t) { return t * t * t * (t * (t * 6 - 15) + 10); };
@@ -709,12 +1964,8 @@ namespace KTLib
                            lerp(u, grad(p[AB], x, y - 1, 0), grad(p[BB], x - 1, y - 1, 0)));
         };
 
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
+        Scheduler::ForEachPixel(m_width, m_height, [&](int x, int y, size_t)
         {
-            int x = i % m_width;
-            int y = i / m_width;
-
             double total = 0.0;
             double freq = frequency;
             double amp = amplitude;
@@ -735,29 +1986,25 @@ namespace KTLib
 
             // Apply to color buffer
             int noiseColor = static_cast<int>(total * 255);
-            m_colors[i] &= noiseColor;
-        }
+            Pixel(x, y) = (Color(Pixel(x, y)) & noiseColor).argb;
+        });
     }
 
-    void Canvas::Voronoi(int numPoints, double falloff, double strength)
+    void Canvas::Voronoi(int numPoints, double falloff, double strength, uint64_t seed)
     {
-        int seed = std::random_device{}();
-        std::mt19937 gen(seed);
-        std::uniform_real_distribution<> dis(0.0, 1.0);
+        PrepareWrite();
+
+        Random::Stream gen(Random::ResolveSeed(seed));
 
         std::vector<std::pair<double, double>> points(numPoints);
         for (auto& point : points)
         {
-            point.first = dis(gen);
-            point.second = dis(gen);
+            point.first = gen.Uniform();
+            point.second = gen.Uniform();
         }
 
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
+        Scheduler::ForEachPixel(m_width, m_height, [&](int x, int y, size_t)
         {
-            int x = i % m_width;
-            int y = i / m_width;
-
             double px = static_cast<double>(x) / m_width;
             double py = static_cast<double>(y) / m_height;
 
@@ -771,23 +2018,21 @@ namespace KTLib
             }
 
             double value = (std::pow(minDist, falloff) * strength) * 255;
-            m_colors[i] &= value;
-        }
+            Pixel(x, y) = (Color(Pixel(x, y)) & value).argb;
+        });
     }
 
     void Canvas::Plasma(double frequency, double phase)
     {
+        PrepareWrite();
+
         auto plasma = [](double x, double y, double freq, double phase) {
             return std::sin(x * freq + phase) + std::sin(y * freq + phase) +
                    std::sin((x + y) * freq + phase) + std::sin(std::sqrt(x * x + y * y) * freq + phase);
         };
 
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
+        Scheduler::ForEachPixel(m_width, m_height, [&](int x, int y, size_t)
         {
-            int x = i % m_width;
-            int y = i / m_width;
-
             double nx = x / static_cast<double>(m_width) - 0.5;
             double ny = y / static_cast<double>(m_height) - 0.5;
 
@@ -798,15 +2043,17 @@ namespace KTLib
             int g = static_cast<int>(std::sin(value * CONST_PI * 2 + 2 * CONST_PI / 3) * 127 + 128);
             int b = static_cast<int>(std::sin(value * CONST_PI * 2 + 4 * CONST_PI / 3) * 127 + 128);
 
-            m_colors[i] &= Color(r, g, b);
-        }
+            Pixel(x, y) = (Color(Pixel(x, y)) & Color(r, g, b)).argb;
+        });
     }
 
-    void Canvas::DiamondSquare(double roughness, double waterLevel, double levelsPerStop)
+    void Canvas::DiamondSquare(double roughness, double waterLevel, double levelsPerStop, uint64_t seed)
     {
-        int seed = std::random_device{}();
-        std::mt19937 gen(seed);
-        std::uniform_real_distribution<> dis(-1.0, 1.0);
+        PrepareWrite();
+
+        // Every grid point is written by exactly one step, so its offset can be drawn from its own index
+        seed = Random::ResolveSeed(seed);
+        auto dis = [seed](size_t index) { return Random::Uniform(seed, index) * 2.0 - 1.0; };
 
         int size = std::max(m_width, m_height);
         int power = static_cast<int>(std::ceil(std::log2(size - 1)));
@@ -815,7 +2062,7 @@ namespace KTLib
         std::vector<std::vector<double>> heightmap(size, std::vector<double>(size, 0.0));
 
         // Initialize corners
-        heightmap[0][0] = heightmap[0][size-1] = heightmap[size-1][0] = heightmap[size-1][size-1] = std::max(waterLevel, dis(gen));
+        heightmap[0][0] = heightmap[0][size-1] = heightmap[size-1][0] = heightmap[size-1][size-1] = std::max(waterLevel, dis(0));
 
         for (int step = size - 1; step > 1; step /= 2)
         {
@@ -823,22 +2070,22 @@ namespace KTLib
             double scaleFactor = 1.0 - (static_cast<double>(size - step) / size);
 
             // Diamond step
-            #pragma omp parallel for
-            for (int y = halfStep; y < size; y += step)
+            Scheduler::For((size - halfStep + step - 1) / step, [&](size_t row)
             {
+                const int y = halfStep + static_cast<int>(row) * step;
                 for (int x = halfStep; x < size; x += step)
                 {
                     double avg = (heightmap[y-halfStep][x-halfStep] + heightmap[y-halfStep][x+halfStep] +
                                   heightmap[y+halfStep][x-halfStep] + heightmap[y+halfStep][x+halfStep]) / 4.0;
-                    double randomOffset = dis(gen) * roughness * step / size * scaleFactor;
+                    double randomOffset = dis(static_cast<size_t>(y) * size + x) * roughness * step / size * scaleFactor;
                     heightmap[y][x] = std::max(waterLevel, avg + randomOffset);
                 }
-            }
+            });
 
             // Square step
-            #pragma omp parallel for
-            for (int y = 0; y < size; y += halfStep)
+            Scheduler::For((size + halfStep - 1) / halfStep, [&](size_t row)
             {
+                const int y = static_cast<int>(row) * halfStep;
                 for (int x = (y + halfStep) % step; x < size; x += step)
                 {
                     double avg = 0.0;
@@ -850,10 +2097,10 @@ namespace KTLib
                     if (x + halfStep < size) { avg += heightmap[y][x+halfStep]; count++; }
 
                     avg /= count;
-                    double randomOffset = dis(gen) * roughness * step / size * scaleFactor;
+                    double randomOffset = dis(static_cast<size_t>(y) * size + x) * roughness * step / size * scaleFactor;
                     heightmap[y][x] = std::max(waterLevel, avg + randomOffset);
                 }
-            }
+            });
 
             roughness *= 0.5;
         }
@@ -922,119 +2169,102 @@ namespace KTLib
         };
 
         // Map heightmap to Canvas
-        #pragma omp parallel for
-        for (int i = 0; i < m_width * m_height; ++i)
+        Scheduler::ForEachPixel(m_width, m_height, [&](int x, int y, size_t)
         {
-            int x = i % m_width;
-            int y = i / m_width;
-            double height = heightmap[y * size / m_height][x * size / m_width];
-            m_colors[i] = mapToColor(height);
-        }
+            double height = heightmap[static_cast<int64_t>(y) * size / m_height][static_cast<int64_t>(x) * size / m_width];
+            Pixel(x, y) = mapToColor(height).argb;
+        });
     }
 
     void Canvas::Posterize(int levels)
     {
+        PrepareWrite();
+
         levels = std::clamp(levels, 2, 256);
         double factor = 255.0 / (levels - 1);
 
-        #pragma omp parallel for
-        for (auto& color : m_colors)
+        auto quantize = [factor](int channel) { return static_cast<int>(std::min(255.0, std::round(std::round(channel / factor) * factor))); };
+
+        MapPixels([&](uint32_t px)
         {
-            color.r = static_cast<int>(std::min(255.0, std::round(std::round(color.r / factor) * factor)));
-            color.g = static_cast<int>(std::min(255.0, std::round(std::round(color.g / factor) * factor)));
-            color.b = static_cast<int>(std::min(255.0, std::round(std::round(color.b / factor) * factor)));
-        }
+            return PackARGB(quantize(GetChannel(px, RedShift)), quantize(GetChannel(px, GreenShift)), quantize(GetChannel(px, BlueShift)), GetChannel(px, AlphaShift));
+        });
     }
     #pragma endregion
 
     #pragma region Utility
     Color Canvas::CalculateAverageColor(int startX, int startY, int pixelWidth, int pixelHeight)
     {
+        FlushMatrixBatch();
+
         if (pixelWidth == 0) pixelWidth = m_width;
         if (pixelHeight == 0) pixelHeight = m_height;
 
-        int totalR = 0, totalG = 0, totalB = 0, totalA = 0;
-        int count = 0;
-        int endX = std::min(startX + pixelWidth, m_width);
-        int endY = std::min(startY + pixelHeight, m_height);
+        const int beginX = std::max(startX, 0);
+        const int beginY = std::max(startY, 0);
+        const int endX = std::min(startX + pixelWidth, m_width);
+        const int endY = std::min(startY + pixelHeight, m_height);
 
-        #pragma omp parallel for
-        for (int i = 0; i < pixelWidth * pixelHeight; ++i)
-        {
-            int x = startX + (i % pixelWidth);
-            int y = startY + (i / pixelWidth);
+        if (beginX >= endX || beginY >= endY)
+            throw std::out_of_range("Average region does not overlap the canvas");
 
-            if (x < endX && y < endY)
+        // Each tile sums its own pixels and the partials are added up in tile order afterwards
+        ChannelSums total = Scheduler::ReduceTiles(endX - beginX, endY - beginY, ChannelSums{},
+            [&](const Scheduler::Tile& tile)
             {
-                Color pixel = Get(x, y);
-                totalR += pixel.GetRed();
-                totalG += pixel.GetGreen();
-                totalB += pixel.GetBlue();
-                totalA += pixel.GetAlpha();
-                ++count;
-            }
-        }
+                int x = beginX + tile.x, y = beginY + tile.y;
+                return SumRegion(m_data, m_stride, x, y, x + tile.width, y + tile.height);
+            },
+            [](ChannelSums a, const ChannelSums& b) { return a += b; });
 
-        return Color(
-            totalR / count,
-            totalG / count,
-            totalB / count,
-            totalA / count
-        );
+        return Color(total.Average());
     }
 
     void Canvas::MapColors(int x, int y, int width, int height, unsigned int (*mapFunction)(int, int, unsigned int))
     {
+        PrepareWrite();
+
         int xmin = std::max(0, x);
         int ymin = std::max(0, y);
         int xmax = std::min(m_width - 1, x + width - 1);
         int ymax = std::min(m_height - 1, y + height - 1);
 
-        int xRange = xmax - xmin + 1;
-        int yRange = ymax - ymin + 1;
-
-        for (int i = 0; i < xRange * yRange; ++i)
+        for (int row = ymin; row <= ymax; ++row)
         {
-            int x = i % xRange + xmin;
-            int y = i / xRange + ymin;
-            int index = y * m_width + x;
-            unsigned int color = m_colors[index].ToInt(0);
-            m_colors[index] = Color(mapFunction(x, y, color));
+            uint32_t* pixels = Row(row);
+            for (int column = xmin; column <= xmax; ++column)
+            {
+                pixels[column] = mapFunction(column, row, pixels[column]);
+            }
         }
     }
 
     void Canvas::ForEach(const std::function<void(const Color&)>& func) const
     {
-        for (const auto& color : m_colors)
+        FlushMatrixBatch();
+
+        for (int y = 0; y < m_height; ++y)
         {
-            func(color);
+            for (const uint32_t* px = Row(y); px != Row(y) + m_width; ++px) func(Color(*px));
         }
     }
 
     Canvas* Canvas::CopyRegion(int xmin, int ymin, int width, int height) const
     {
-        Canvas* subBuffer = new Canvas(width, height);
-
-        #pragma omp parallel for
-        for (int i = 0; i < width * height; ++i)
-        {
-            int x = i % width;
-            int y = i / width;
-            subBuffer->m_colors[i] = m_colors[(y + ymin) * m_width + (x + xmin)];
-        }
-
-        return subBuffer;
+        const Canvas region(*this, xmin, ymin, width, height);
+        return new Canvas(region);
     }
 
     Canvas* Canvas::Copy() const
     {
-        Canvas* newBuffer = new Canvas(m_width, m_height);
-        newBuffer->m_colors = m_colors;
-        return newBuffer;
+        return new Canvas(*this);
     }
 
     void Canvas::Rotate(double angle)
     {
+        RequireResizable("Rotate");
+        FlushMatrixBatch();
+
         double radians = -(angle * CONST_PI / 180.0);
         double cos_angle = cos(radians);
         double sin_angle = sin(radians);
@@ -1042,19 +2272,16 @@ namespace KTLib
         int newWidth = static_cast<int>(std::abs(m_width * cos_angle) + std::abs(m_height * sin_angle));
         int newHeight = static_cast<int>(std::abs(m_width * sin_angle) + std::abs(m_height * cos_angle));
 
-        std::vector<Color> newColors(newWidth * newHeight, Color(0, 0, 0, 0));
+        PixelBuffer newPixels = AllocatePixels(newWidth, newHeight);
+        const ptrdiff_t stride = PaddedStride(newWidth);
 
         int centerX = m_width / 2;
         int centerY = m_height / 2;
         int newCenterX = newWidth / 2;
         int newCenterY = newHeight / 2;
 
-        #pragma omp parallel for
-        for (int i = 0; i < newWidth * newHeight; ++i)
+        Scheduler::ForEachPixel(newWidth, newHeight, Scheduler::SquareTileSize, Scheduler::SquareTileSize, [&](int x, int y, size_t)
         {
-            int x = i % newWidth;
-            int y = i / newWidth;
-
             int translatedX = x - newCenterX;
             int translatedY = y - newCenterY;
 
@@ -1062,16 +2289,17 @@ namespace KTLib
             int originalY = static_cast<int>(translatedX * sin_angle + translatedY * cos_angle + centerY);
 
             if (originalX >= 0 && originalX < m_width && originalY >= 0 && originalY < m_height)
-                newColors[i] = m_colors[originalY * m_width + originalX];
-        }
+                newPixels[y * stride + x] = Pixel(originalX, originalY);
+        });
 
-        m_colors = std::move(newColors);
-        m_width = newWidth;
-        m_height = newHeight;
+        ReplacePixels(std::move(newPixels), newWidth, newHeight);
     }
 
     void Canvas::Resize(int newWidth, int newHeight, int resizeImage = 1, Color fillColor = Color::Black())
     {
+        RequireResizable("Resize");
+        FlushMatrixBatch();
+
         resizeImage = (resizeImage != 0) ? true : false;
 
         // Calculate dimensions preserving aspect ratio if only one dimension provided
@@ -1090,19 +2318,16 @@ namespace KTLib
             return;
         }
 
-        std::vector<Color> newColors(newWidth * newHeight, fillColor);
+        PixelBuffer newPixels = AllocatePixels(newWidth, newHeight, fillColor.argb);
+        const ptrdiff_t stride = PaddedStride(newWidth);
 
         if (resizeImage)
         {
             float xRatio = static_cast<float>(m_width - 1) / (newWidth - 1);
             float yRatio = static_cast<float>(m_height - 1) / (newHeight - 1);
 
-            #pragma omp parallel for
-            for (int i = 0; i < newWidth * newHeight; ++i)
+            Scheduler::ForEachPixel(newWidth, newHeight, [&](int x, int y, size_t)
             {
-                int x = i % newWidth;
-                int y = i / newWidth;
-
                 float gx = x * xRatio;
                 float gy = y * yRatio;
                 int gxi = static_cast<int>(gx);
@@ -1110,10 +2335,10 @@ namespace KTLib
                 float dx = gx - gxi;
                 float dy = gy - gyi;
 
-                Color c00 = Get(gxi, gyi);
-                Color c10 = Get(std::min(gxi + 1, m_width - 1), gyi);
-                Color c01 = Get(gxi, std::min(gyi + 1, m_height - 1));
-                Color c11 = Get(std::min(gxi + 1, m_width - 1), std::min(gyi + 1, m_height - 1));
+                Color c00(Pixel(gxi, gyi));
+                Color c10(Pixel(std::min(gxi + 1, m_width - 1), gyi));
+                Color c01(Pixel(gxi, std::min(gyi + 1, m_height - 1)));
+                Color c11(Pixel(std::min(gxi + 1, m_width - 1), std::min(gyi + 1, m_height - 1)));
 
                 Color interpolated =
                     c00 * ((1 - dx) * (1 - dy)) +
@@ -1121,26 +2346,21 @@ namespace KTLib
                     c01 * ((1 - dx) * dy) +
                     c11 * (dx * dy);
 
-                newColors[i] = interpolated;
-            }
+                newPixels[y * stride + x] = interpolated.argb;
+            });
         }
         else
         {
             int copyWidth = std::min(m_width, newWidth);
             int copyHeight = std::min(m_height, newHeight);
 
-            #pragma omp parallel for
-            for (int y = 0; y < copyHeight; ++y)
+            Scheduler::For(copyHeight, [&](size_t y)
             {
-                std::copy(m_colors.begin() + y * m_width,
-                          m_colors.begin() + y * m_width + copyWidth,
-                          newColors.begin() + y * newWidth);
-            }
+                std::copy_n(Row(static_cast<int>(y)), copyWidth, newPixels.begin() + y * stride);
+            });
         }
 
-        m_colors = std::move(newColors);
-        m_width = newWidth;
-        m_height = newHeight;
+        ReplacePixels(std::move(newPixels), newWidth, newHeight);
     }
 
     void Canvas::Scale(double scale)
@@ -1152,34 +2372,53 @@ namespace KTLib
 
     size_t Canvas::CountUniqueColors() const
     {
-        std::unordered_set<Color> uniqueColors;
-        uniqueColors.reserve(m_colors.size());
+        FlushMatrixBatch();
 
-        for (const auto& color : m_colors) uniqueColors.insert(color);
+        std::vector<uint32_t> sorted = Packed();
+        std::sort(sorted.begin(), sorted.end());
 
-        return uniqueColors.size();
+        return std::unique(sorted.begin(), sorted.end()) - sorted.begin();
     }
 
-    int Canvas::Find(const Color& color) const
+    int64_t Canvas::Find(const Color& color) const
     {
-        auto it = std::find(m_colors.begin(), m_colors.end(), color);
-        return (it != m_colors.end()) ? std::distance(m_colors.begin(), it) : -1;
+        FlushMatrixBatch();
+
+        for (int y = 0; y < m_height; ++y)
+        {
+            const uint32_t* row = Row(y);
+            const uint32_t* it = std::find(row, row + m_width, color.argb);
+            if (it != row + m_width) return static_cast<int64_t>(y) * m_width + (it - row);
+        }
+        return -1;
     }
 
-    int Canvas::FindLast(const Color& color) const
+    int64_t Canvas::FindLast(const Color& color) const
     {
-        auto it = std::find(m_colors.rbegin(), m_colors.rend(), color);
-        return (it != m_colors.rend()) ? m_colors.size() - 1 - std::distance(m_colors.rbegin(), it) : -1;
+        FlushMatrixBatch();
+
+        for (int y = m_height - 1; y >= 0; --y)
+        {
+            const uint32_t* row = Row(y);
+            for (int x = m_width - 1; x >= 0; --x)
+            {
+                if (row[x] == color.argb) return static_cast<int64_t>(y) * m_width + x;
+            }
+        }
+        return -1;
     }
 
-    std::vector<int> Canvas::FindAll(const Color& color) const
+    std::vector<int64_t> Canvas::FindAll(const Color& color) const
     {
-        std::vector<int> indices;
-        for (size_t i = 0; i < m_colors.size(); ++i)
+        FlushMatrixBatch();
+
+        std::vector<int64_t> indices;
+        for (int y = 0; y < m_height; ++y)
         {
-            if (m_colors[i] == color)
+            const uint32_t* row = Row(y);
+            for (int x = 0; x < m_width; ++x)
             {
-                indices.push_back(static_cast<int>(i));
+                if (row[x] == color.argb) indices.push_back(static_cast<int64_t>(y) * m_width + x);
             }
         }
         return indices;
@@ -1187,89 +2426,136 @@ namespace KTLib
 
     void Canvas::Swap(size_t index1, size_t index2)
     {
-        if (index1 < m_colors.size() && index2 < m_colors.size())
+        PrepareWrite();
+
+        if (index1 < PixelCount() && index2 < PixelCount())
         {
-            std::swap(m_colors[index1], m_colors[index2]);
+            std::swap(PixelAt(index1), PixelAt(index2));
         }
     }
 
     Canvas Canvas::Filter(const std::function<bool(const Color&)>& predicate) const
     {
+        FlushMatrixBatch();
+
+        // Matches are packed from the top left, the rest stays at the default fill
         Canvas result(m_width, m_height);
-        std::copy_if(m_colors.begin(), m_colors.end(), result.m_colors.begin(), predicate);
+        std::vector<uint32_t> matches = result.Packed();
+        auto out = matches.begin();
+        for (int y = 0; y < m_height; ++y)
+        {
+            out = std::copy_if(Row(y), Row(y) + m_width, out, [&predicate](uint32_t px) { return predicate(Color(px)); });
+        }
+        result.Unpack(matches.data());
         return result;
     }
 
-    int Canvas::Count(const Color& color) const
+    size_t Canvas::Count(const Color& color) const
     {
-        return std::count(m_colors.begin(), m_colors.end(), color);
+        FlushMatrixBatch();
+
+        size_t count = 0;
+        for (int y = 0; y < m_height; ++y)
+        {
+            count += std::count(Row(y), Row(y) + m_width, color.argb);
+        }
+        return count;
     }
 
-    void Canvas::Shuffle()
+    void Canvas::Shuffle(uint64_t seed)
     {
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(m_colors.begin(), m_colors.end(), g);
+        PrepareWrite();
+
+        Random::Stream gen(Random::ResolveSeed(seed));
+        if (IsContiguous())
+        {
+            gen.Shuffle(m_data, m_data + PixelCount());
+            return;
+        }
+
+        std::vector<uint32_t> packed = Packed();
+        gen.Shuffle(packed.begin(), packed.end());
+        Unpack(packed.data());
     }
 
     void Canvas::Clear()
     {
-        m_colors.clear();
-        m_width = 0;
-        m_height = 0;
+        RequireNoViews("Clear");
+        ReleaseWrapped();
+        m_hasPendingMatrix = false;
+        ReplacePixels({}, 0, 0);
     }
 
     void Canvas::Sort(const std::function<bool(const Color&, const Color&)>& compare)
     {
-        std::sort(m_colors.begin(), m_colors.end(), compare);
+        PrepareWrite();
+
+        auto less = [&compare](uint32_t a, uint32_t b) { return compare(Color(a), Color(b)); };
+        if (IsContiguous())
+        {
+            std::sort(m_data, m_data + PixelCount(), less);
+            return;
+        }
+
+        std::vector<uint32_t> packed = Packed();
+        std::sort(packed.begin(), packed.end(), less);
+        Unpack(packed.data());
     }
 
     void Canvas::AppendRight(const Canvas& other)
     {
+        RequireResizable("AppendRight");
+        FlushMatrixBatch();
+        other.FlushMatrixBatch();
+
         int newWidth = m_width + other.m_width;
         int newHeight = std::max(m_height, other.m_height);
-        std::vector<Color> newColors(newWidth * newHeight, Color(0, 0, 0, 0)); // Initialize with transparent pixels
+        PixelBuffer newPixels = AllocatePixels(newWidth, newHeight); // Initialize with transparent pixels
+        const ptrdiff_t stride = PaddedStride(newWidth);
 
         for (int y = 0; y < newHeight; ++y)
         {
             if (y < m_height)
             {
-                std::copy(m_colors.begin() + y * m_width, m_colors.begin() + (y + 1) * m_width, newColors.begin() + y * newWidth);
+                std::copy_n(Row(y), m_width, newPixels.begin() + y * stride);
             }
             if (y < other.m_height)
             {
-                std::copy(other.m_colors.begin() + y * other.m_width, other.m_colors.begin() + (y + 1) * other.m_width, newColors.begin() + y * newWidth + m_width);
+                std::copy_n(other.Row(y), other.m_width, newPixels.begin() + y * stride + m_width);
             }
         }
 
-        m_colors = std::move(newColors);
-        m_width = newWidth;
-        m_height = newHeight;
+        ReplacePixels(std::move(newPixels), newWidth, newHeight);
     }
 
     void Canvas::AppendBottom(const Canvas& other)
     {
+        RequireResizable("AppendBottom");
+        FlushMatrixBatch();
+        other.FlushMatrixBatch();
+
         int newWidth = std::max(m_width, other.m_width);
         int newHeight = m_height + other.m_height;
-        std::vector<Color> newColors(newWidth * newHeight, Color(0, 0, 0, 0)); // Initialize with transparent pixels
+        PixelBuffer newPixels = AllocatePixels(newWidth, newHeight); // Initialize with transparent pixels
+        const ptrdiff_t stride = PaddedStride(newWidth);
 
         for (int y = 0; y < m_height; ++y)
         {
-            std::copy(m_colors.begin() + y * m_width, m_colors.begin() + (y + 1) * m_width, newColors.begin() + y * newWidth);
+            std::copy_n(Row(y), m_width, newPixels.begin() + y * stride);
         }
 
         for (int y = 0; y < other.m_height; ++y)
         {
-            std::copy(other.m_colors.begin() + y * other.m_width, other.m_colors.begin() + (y + 1) * other.m_width, newColors.begin() + (m_height + y) * newWidth);
+            std::copy_n(other.Row(y), other.m_width, newPixels.begin() + (m_height + y) * stride);
         }
 
-        m_colors = std::move(newColors);
-        m_width = newWidth;
-        m_height = newHeight;
+        ReplacePixels(std::move(newPixels), newWidth, newHeight);
     }
 
     HBITMAP Canvas::ToHBITMAP(int targetWidth, int targetHeight) const
     {
+        FlushMatrixBatch();
+
         targetWidth = (targetWidth <= 0) ? m_width : targetWidth;
         targetHeight = (targetHeight <= 0) ? m_height : targetHeight;
 
@@ -1284,27 +2570,13 @@ namespace KTLib
         bmi.bmiHeader.biBitCount = 32;
         bmi.bmiHeader.biCompression = BI_RGB;
 
+        // A top-down 32 bpp DIB has the same layout as a packed canvas, so the pixels go straight into its bits
         void* pBits;
         HBITMAP hBitmap = CreateDIBSection(hdc, &bmi, DIB_RGB_COLORS, &pBits, NULL, 0);
         HBITMAP oldBitmap = (HBITMAP)SelectObject(memDC, hBitmap);
 
-        std::vector<BYTE> buffer(targetWidth * targetHeight * 4);
-
-        for (int i = 0; i < targetWidth * targetHeight; ++i)
-        {
-            int x = i % targetWidth;
-            int y = i / targetWidth;
-            int srcX = x * m_width / targetWidth;
-            int srcY = y * m_height / targetHeight;
-            const Color& color = Get(srcX, srcY);
-            int index = i * 4;
-            buffer[index] = color.GetBlue();
-            buffer[index + 1] = color.GetGreen();
-            buffer[index + 2] = color.GetRed();
-            buffer[index + 3] = color.GetAlpha();
-        }
-
-        SetDIBits(hdc, hBitmap, 0, targetHeight, buffer.data(), &bmi, DIB_RGB_COLORS);
+        SampleInto(static_cast<uint32_t*>(pBits), targetWidth, targetHeight, targetWidth);
+        GdiFlush();
 
         SelectObject(memDC, oldBitmap);
         DeleteDC(memDC);
@@ -1336,19 +2608,17 @@ namespace KTLib
         bmi.bmiHeader.biBitCount = 32;
         bmi.bmiHeader.biCompression = BI_RGB;
 
-        std::vector<BYTE> buffer(sourceWidth * sourceHeight * 4);
-        GetDIBits(memDC, hBitmap, 0, sourceHeight, buffer.data(), &bmi, DIB_RGB_COLORS);
-
-        Canvas* canvas = new Canvas(width, height);
+        // DIB rows are packed and canvas rows are padded, so the bits go through a staging buffer
+        std::vector<uint32_t> bits(static_cast<size_t>(sourceWidth) * sourceHeight);
+        GetDIBits(memDC, hBitmap, 0, sourceHeight, bits.data(), &bmi, DIB_RGB_COLORS);
+        Canvas* canvas = new Canvas(bits.data(), sourceWidth, sourceHeight);
 
-        for (int i = 0; i < width * height; ++i)
+        if (width != sourceWidth || height != sourceHeight)
         {
-            int x = i % width;
-            int y = i / width;
-            int srcX = x * sourceWidth / width;
-            int srcY = y * sourceHeight / height;
-            int index = (srcY * sourceWidth + srcX) * 4;
-            canvas->m_colors[i] = Color(buffer[index + 2], buffer[index + 1], buffer[index], buffer[index + 3]);
+            Canvas* scaled = new Canvas(width, height);
+            canvas->SampleInto(scaled->m_data, width, height, scaled->m_stride);
+            delete canvas;
+            canvas = scaled;
         }
 
         SelectObject(memDC, oldBitmap);
@@ -1360,6 +2630,8 @@ namespace KTLib
 
     HDC Canvas::ToHDC(int width, int height) const
     {
+        FlushMatrixBatch();
+
         width = (width <= 0) ? m_width : width;
         height = (height <= 0) ? m_height : height;
 
@@ -1377,21 +2649,7 @@ namespace KTLib
         HBITMAP hBitmap = CreateDIBSection(hdc, &bmi, DIB_RGB_COLORS, &pBits, NULL, 0);
         SelectObject(hdc, hBitmap);
 
-        BYTE* pixels = (BYTE*)pBits;
-        for (int i = 0; i < width * height; ++i)
-        {
-            int x = i % width;
-            int y = i / width;
-            int srcX = x * m_width / width;
-            int srcY = y * m_height / height;
-            const Color& color = Get(srcX, srcY);
-
-            int index = i * 4;
-            pixels[index] = color.GetBlue();
-            pixels[index + 1] = color.GetGreen();
-            pixels[index + 2] = color.GetRed();
-            pixels[index + 3] = color.GetAlpha();
-        }
+        SampleInto(static_cast<uint32_t*>(pBits), width, height, width);
 
         return hdc;
     }
@@ -1415,22 +2673,12 @@ namespace KTLib
         bi.biBitCount = 32;
         bi.biCompression = BI_RGB;
 
-        BYTE* bits = new BYTE[width * height * 4];
-        GetDIBits(memDC, hBitmap, 0, height, bits, (BITMAPINFO*)&bi, DIB_RGB_COLORS);
-
-        Canvas* buffer = new Canvas(width, height);
-        #pragma omp parallel for
-        for (int i = 0; i < width * height; ++i) {
-            int index = i * 4;
-            buffer->SetAt(i, Color(
-                bits[index + 2],
-                bits[index + 1],
-                bits[index],
-                255
-            ));
-        }
+        // Screen bits carry no alpha, the canvas is made opaque after copying them in
+        std::vector<uint32_t> bits(static_cast<size_t>(width) * height);
+        GetDIBits(memDC, hBitmap, 0, height, bits.data(), (BITMAPINFO*)&bi, DIB_RGB_COLORS);
+        Canvas* buffer = new Canvas(bits.data(), width, height);
+        buffer->SetAlpha(255);
 
-        delete[] bits;
         SelectObject(memDC, oldBitmap);
         DeleteObject(hBitmap);
         DeleteDC(memDC);
@@ -1440,6 +2688,8 @@ namespace KTLib
 
     HICON Canvas::ToHICON(int width, int height) const
     {
+        FlushMatrixBatch();
+
         width = (width <= 0) ? m_width : width;
         height = (height <= 0) ? m_height : height;
 
@@ -1459,26 +2709,12 @@ namespace KTLib
         void* pBits;
         HDC hdc = GetDC(NULL);
         HBITMAP hColor = CreateDIBSection(hdc, (BITMAPINFO*)&bi, DIB_RGB_COLORS, &pBits, NULL, 0);
-        BYTE* pixels = (BYTE*)pBits;
 
         // Create mask bitmap (monochrome)
         HBITMAP hMask = CreateBitmap(width, height, 1, 1, NULL);
 
         // Fill color bitmap with our image data
-        for (int i = 0; i < width * height; ++i)
-        {
-            int x = i % width;
-            int y = i / width;
-            int srcX = x * m_width / width;
-            int srcY = y * m_height / height;
-            const Color& color = Get(srcX, srcY);
-
-            int index = i * 4;
-            pixels[index] = color.GetBlue();
-            pixels[index + 1] = color.GetGreen();
-            pixels[index + 2] = color.GetRed();
-            pixels[index + 3] = color.GetAlpha();
-        }
+        SampleInto(static_cast<uint32_t*>(pBits), width, height, width);
 
         ICONINFO ii = {};
         ii.fIcon = TRUE;
@@ -1522,19 +2758,8 @@ namespace KTLib
 
         DrawIconEx(memDC, 0, 0, hIcon, width, height, 0, NULL, DI_NORMAL);
 
-        BYTE* pixels = (BYTE*)pBits;
-        Canvas* buffer = new Canvas(width, height);
-
-        for (int i = 0; i < width * height; ++i)
-        {
-            int index = i * 4;
-            buffer->SetAt(i, Color(
-                pixels[index + 2],  // Red
-                pixels[index + 1],  // Green
-                pixels[index],      // Blue
-                pixels[index + 3]   // Alpha
-            ));
-        }
+        GdiFlush();
+        Canvas* buffer = new Canvas(static_cast<unsigned int*>(pBits), width, height);
 
         DeleteObject(hBitmap);
         DeleteDC(memDC);
@@ -1547,6 +2772,8 @@ namespace KTLib
 
     HCURSOR Canvas::ToHCURSOR(int width, int height) const
     {
+        FlushMatrixBatch();
+
         width = (width <= 0) ? m_width : width;
         height = (height <= 0) ? m_height : height;
 
@@ -1565,24 +2792,10 @@ namespace KTLib
         void* pBits;
         HDC hdc = GetDC(NULL);
         HBITMAP hColor = CreateDIBSection(hdc, (BITMAPINFO*)&bi, DIB_RGB_COLORS, &pBits, NULL, 0);
-        BYTE* pixels = (BYTE*)pBits;
 
         HBITMAP hMask = CreateBitmap(width, height, 1, 1, NULL);
 
-        for (int i = 0; i < width * height; ++i)
-        {
-            int x = i % width;
-            int y = i / width;
-            int srcX = x * m_width / width;
-            int srcY = y * m_height / height;
-            const Color& color = Get(srcX, srcY);
-
-            int index = i * 4;
-            pixels[index] = color.GetBlue();
-            pixels[index + 1] = color.GetGreen();
-            pixels[index + 2] = color.GetRed();
-            pixels[index + 3] = color.GetAlpha();
-        }
+        SampleInto(static_cast<uint32_t*>(pBits), width, height, width);
 
         ICONINFO ii = {};
         ii.fIcon = FALSE;
@@ -1628,19 +2841,8 @@ namespace KTLib
 
         DrawIconEx(memDC, 0, 0, hCursor, width, height, 0, NULL, DI_NORMAL);
 
-        BYTE* pixels = (BYTE*)pBits;
-        Canvas* buffer = new Canvas(width, height);
-
-        for (int i = 0; i < width * height; ++i)
-        {
-            int index = i * 4;
-            buffer->SetAt(i, Color(
-                pixels[index + 2],  // Red
-                pixels[index + 1],  // Green
-                pixels[index],      // Blue
-                pixels[index + 3]   // Alpha
-            ));
-        }
+        GdiFlush();
+        Canvas* buffer = new Canvas(static_cast<unsigned int*>(pBits), width, height);
 
         DeleteObject(hBitmap);
         DeleteDC(memDC);
@@ -1681,23 +2883,11 @@ namespace KTLib
         bi.biBitCount = 32;
         bi.biCompression = BI_RGB;
 
-        BYTE* bits = new BYTE[width * height * 4];
-        GetDIBits(offsetDC, offsetBitmap, 0, height, bits, (BITMAPINFO*)&bi, DIB_RGB_COLORS);
-
-        Canvas* buffer = new Canvas(width, height);
-        #pragma omp parallel for
-        for (int i = 0; i < width * height; ++i)
-        {
-            int index = i * 4;
-            buffer->SetAt(i, Color(
-                bits[index + 2],
-                bits[index + 1],
-                bits[index],
-                255
-            ));
-        }
+        std::vector<uint32_t> bits(static_cast<size_t>(width) * height);
+        GetDIBits(offsetDC, offsetBitmap, 0, height, bits.data(), (BITMAPINFO*)&bi, DIB_RGB_COLORS);
+        Canvas* buffer = new Canvas(bits.data(), width, height);
+        buffer->SetAlpha(255);
 
-        delete[] bits;
         SelectObject(offsetDC, oldOffsetBitmap);
         SelectObject(memDC, oldBitmap);
         DeleteObject(offsetBitmap);
@@ -1,10 +1,11 @@
 #include "../include/Color.hpp"
+#include "../include/Random.hpp"
+#include "../include/TransferFunction.hpp"
 
 #include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <iomanip>
-#include <random>
 
 namespace KTLib
 {
@@ -288,20 +289,16 @@ namespace KTLib
     // Linear sRGB Functions
     void Color::ToLinearSRGB(double& outR, double& outG, double& outB) const
     {
-        this->Normalize(outR, outG, outB);
-        auto linear_sRGB = [](double c) { return (c <= 0.04045) ? (c / 12.92) : std::pow((c + 0.055) / 1.055, 2.4); };
-
-        outR = linear_sRGB(outR);
-        outG = linear_sRGB(outG);
-        outB = linear_sRGB(outB);
+        outR = Transfer::Decode8(TransferCurve::sRGB, r);
+        outG = Transfer::Decode8(TransferCurve::sRGB, g);
+        outB = Transfer::Decode8(TransferCurve::sRGB, b);
     }
 
     Color Color::FromLinearSRGB(double r, double g, double b, int a)
     {
-        auto gammaCorrect = [](double c) { return (c > 0.0031308) ? (1.055 * std::pow(c, 1.0 / 2.4) - 0.055) : (12.92 * c); };
-        r = gammaCorrect(r);
-        g = gammaCorrect(g);
-        b = gammaCorrect(b);
+        r = Transfer::Encode(TransferCurve::sRGB, r);
+        g = Transfer::Encode(TransferCurve::sRGB, g);
+        b = Transfer::Encode(TransferCurve::sRGB, b);
 
         return Color(
             std::clamp(r * 255.0, 0.0, 255.0),
@@ -323,29 +320,17 @@ namespace KTLib
         outB =  0.00000000000000000 * outR +  0.00000000000000000 * outG +  1.21196754563894520 * outB;
 
         // Apply ProPhoto RGB transfer function
-        auto prophoto_tf = [](double v)
-        {
-            const double Et = 1.0 / 512.0;
-            return (v < Et) ? v * 16.0 : std::pow(v, 1.0 / 1.8);
-        };
-
-        outR = prophoto_tf(outR);
-        outG = prophoto_tf(outG);
-        outB = prophoto_tf(outB);
+        outR = Transfer::Encode(TransferCurve::ProPhoto, outR);
+        outG = Transfer::Encode(TransferCurve::ProPhoto, outG);
+        outB = Transfer::Encode(TransferCurve::ProPhoto, outB);
     }
 
     Color Color::FromProPhotoRGB(double r, double g, double b, int a)
     {
         // Apply inverse ProPhoto RGB transfer function
-        auto inverse_prophoto_tf = [](double v)
-        {
-            const double Et = 1.0 / 512.0;
-            return (v < Et * 16.0) ? v / 16.0 : std::pow(v, 1.8);
-        };
-
-        r = inverse_prophoto_tf(r);
-        g = inverse_prophoto_tf(g);
-        b = inverse_prophoto_tf(b);
+        r = Transfer::Decode(TransferCurve::ProPhoto, r);
+        g = Transfer::Decode(TransferCurve::ProPhoto, g);
+        b = Transfer::Decode(TransferCurve::ProPhoto, b);
 
         // Convert linear ProPhoto RGB to XYZ D50 (and scale by 100)
         double x = (0.79776664490064230 * r + 0.13518129740053308 * g + 0.03134773412839220 * b) * 100;
@@ -373,21 +358,17 @@ namespace KTLib
         outB = x * 0.01344 + y * -0.11836 + z * 1.01517;
 
         // Apply Adobe RGB gamma correction
-        auto gamma_AdobeRGB = [](double c) { return c <= 0.0 ? 0.0 : std::pow(c, 1.0 / 2.19921875); };
-
-        outR = gamma_AdobeRGB(outR);
-        outG = gamma_AdobeRGB(outG);
-        outB = gamma_AdobeRGB(outB);
+        outR = Transfer::Encode(TransferCurve::AdobeRGB, outR);
+        outG = Transfer::Encode(TransferCurve::AdobeRGB, outG);
+        outB = Transfer::Encode(TransferCurve::AdobeRGB, outB);
     }
 
     Color Color::FromAdobeRGB(double r, double g, double b, int a)
     {
         // Apply inverse Adobe RGB gamma correction
-        auto linear_AdobeRGB = [](double c) { return c <= 0.0 ? 0.0 : std::pow(c, 2.19921875); };
-
-        r = linear_AdobeRGB(r);
-        g = linear_AdobeRGB(g);
-        b = linear_AdobeRGB(b);
+        r = Transfer::Decode(TransferCurve::AdobeRGB, r);
+        g = Transfer::Decode(TransferCurve::AdobeRGB, g);
+        b = Transfer::Decode(TransferCurve::AdobeRGB, b);
 
         // Convert linear Adobe RGB to XYZ
         double x = (r * 0.57667 + g * 0.18556 + b * 0.18823) * 100;
@@ -527,10 +508,10 @@ namespace KTLib
             s = 0;
         }
 
-        double denominator = std::sqrt(nR*nR + nG*nG + nB*nB - nR*nG - nR*nB - nG*nB);
+        double denominator = std::sqrt(std::max(0.0, nR*nR + nG*nG + nB*nB - nR*nG - nR*nB - nG*nB));
         if (denominator != 0) {
             double numerator = nR - 0.5*nG - 0.5*nB;
-            h = std::acos(numerator / denominator) * 180.0 / CONST_PI;
+            h = std::acos(std::clamp(numerator / denominator, -1.0, 1.0)) * 180.0 / CONST_PI;
             if (nB > nG) {
                 h = 360.0 - h;
             }
@@ -1133,10 +1114,10 @@ namespace KTLib
 
     Color Color::FromLab(double l, double a, double b, int alpha)
     {
-        // D65 reference white point
-        const double xn = 0.95047;
-        const double yn = 1.00000;
-        const double zn = 1.08883;
+        // D65 reference white point, on the same 0-100 scale FromXYZ_D65 expects
+        const double xn = 95.047;
+        const double yn = 100.000;
+        const double zn = 108.883;
 
         auto f_inv = [](double t) {
             return t > 0.206893 ? t * t * t : (t - 16.0 / 116.0) / 7.787;
@@ -1554,23 +1535,17 @@ namespace KTLib
         outB = 0.0176398574453108 * x - 0.0427706133302187 * y + 0.9421031212179456 * z;
 
         // Apply Rec.2020 transfer function
-        auto gamma = [](double x) {
-            return x < 0.018053968510807 ? 4.5 * x : 1.09929682680944 * std::pow(x, 0.45) - 0.09929682680944;
-        };
-        outR = gamma(outR);
-        outG = gamma(outG);
-        outB = gamma(outB);
+        outR = Transfer::Encode(TransferCurve::Rec2020, outR);
+        outG = Transfer::Encode(TransferCurve::Rec2020, outG);
+        outB = Transfer::Encode(TransferCurve::Rec2020, outB);
     }
 
     Color Color::FromRec2020(double r, double g, double b, int a)
     {
         // Inverse Rec.2020 transfer function
-        auto invGamma = [](double x) {
-            return x < 0.08145 ? x / 4.5 : std::pow((x + 0.09929682680944) / 1.09929682680944, 1.0 / 0.45);
-        };
-        r = invGamma(r);
-        g = invGamma(g);
-        b = invGamma(b);
+        r = Transfer::Decode(TransferCurve::Rec2020, r);
+        g = Transfer::Decode(TransferCurve::Rec2020, g);
+        b = Transfer::Decode(TransferCurve::Rec2020, b);
 
         // Convert to XYZ
         double x = 0.6369580483012914 * r + 0.1446169035862083 * g + 0.1688809751641721 * b;
@@ -1592,23 +1567,17 @@ namespace KTLib
         outB = 0.0358458302437845 * x - 0.0761723892680418 * y + 0.9568845240076871 * z;
 
         // Apply Display P3 transfer function (same as sRGB)
-        auto gamma = [](double x) {
-            return x <= 0.0031308 ? 12.92 * x : 1.055 * std::pow(x, 1.0/2.4) - 0.055;
-        };
-        outR = gamma(outR);
-        outG = gamma(outG);
-        outB = gamma(outB);
+        outR = Transfer::Encode(TransferCurve::sRGB, outR);
+        outG = Transfer::Encode(TransferCurve::sRGB, outG);
+        outB = Transfer::Encode(TransferCurve::sRGB, outB);
     }
 
     Color Color::FromDisplayP3(double r, double g, double b, int a)
     {
         // Inverse Display P3 transfer function
-        auto invGamma = [](double x) {
-            return x <= 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4);
-        };
-        r = invGamma(r);
-        g = invGamma(g);
-        b = invGamma(b);
+        r = Transfer::Decode(TransferCurve::sRGB, r);
+        g = Transfer::Decode(TransferCurve::sRGB, g);
+        b = Transfer::Decode(TransferCurve::sRGB, b);
 
         // Convert to XYZ
         double x = 0.4865709486482162 * r + 0.2656676931690931 * g + 0.1982172852343625 * b;
@@ -1654,10 +1623,10 @@ namespace KTLib
         m_ = m_ * m_ * m_;
         s_ = s_ * s_ * s_;
 
-        // Convert to XYZ
-        double x = +4.0767416621 * l_ - 3.3077115913 * m_ + 0.2309699292 * s_;
-        double y = -1.2684380046 * l_ + 2.6097574011 * m_ - 0.3413193965 * s_;
-        double z = -0.0041960863 * l_ - 0.7034186147 * m_ + 1.7076147010 * s_;
+        // Convert to XYZ (inverse of the LMS matrix in ToOKLab)
+        double x =  1.2270138511 * l_ - 0.5577999807 * m_ + 0.2812561490 * s_;
+        double y = -0.0405801784 * l_ + 1.1122568696 * m_ - 0.0716766787 * s_;
+        double z = -0.0763812845 * l_ - 0.4214819784 * m_ + 1.5861632204 * s_;
 
         return FromXYZ_D65(x * 100, y * 100, z * 100, alpha);
     }
@@ -1871,151 +1840,16 @@ namespace KTLib
 
     void Color::Complement() { this->ShiftHue(180); }
 
-    void Color::ShiftWhiteLevel(double amount)
-    {
-        double w = std::clamp(amount / 100.0, -1.0, 1.0);
-
-        ColorMatrix whiteLevelMatrix = {{
-            {1, w, w, 0, 0},
-            {w, 1, w, 0, 0},
-            {w, w, 1, 0, 0},
-            {0, 0, 0, 1, 0},
-            {0, 0, 0, 0, 1}
-        }};
-
-        *this *= whiteLevelMatrix;
-    }
-
-    void Color::ShiftBlackLevel(double amount)
-    {
-        double b = 1.0 - std::clamp(amount / 100.0, -1.0, 1.0);
-
-        ColorMatrix blackLevelMatrix = {{
-            {b, 0, 0, 0, 0},
-            {0, b, 0, 0, 0},
-            {0, 0, b, 0, 0},
-            {0, 0, 0, 1, 0},
-            {0, 0, 0, 0, 1}
-        }};
-
-        *this *= blackLevelMatrix;
-    }
-
-    void Color::ShiftContrast(double amount)
-    {
-        amount = std::clamp(amount / 100, -1.0, 1.0);
-        double factor = 1.0 / (1.0 - amount) - 1.0;
-
-        ColorMatrix contrastMatrix = {{
-            {1.0 + factor, 0           , 0           , 0, 0},
-            {0           , 1.0 + factor, 0           , 0, 0},
-            {0           , 0           , 1.0 + factor, 0, 0},
-            {0           , 0           , 0           , 1, 0},
-            {0           , 0           , 0           , 0, 1}
-        }};
-
-        ColorMatrix offsetMatrix = {{
-            {0, 0, 0, 0, -factor/2},
-            {0, 0, 0, 0, -factor/2},
-            {0, 0, 0, 0, -factor/2},
-            {0, 0, 0, 1, 0        },
-            {0, 0, 0, 0, 1        }
-        }};
-
-        *this *= contrastMatrix;
-        *this += offsetMatrix;
-    }
-
-    void Color::Grayscale(double factor)
-    {
-        ColorMatrix grayscaleMatrix = {{
-            {0.299 * factor, 0.587 * factor, 0.114 * factor, 0, 0},
-            {0.299 * factor, 0.587 * factor, 0.114 * factor, 0, 0},
-            {0.299 * factor, 0.587 * factor, 0.114 * factor, 0, 0},
-            {0             , 0             , 0             , 1, 0},
-            {0             , 0             , 0             , 0, 1}
-        }};
-
-        *this *= grayscaleMatrix;
-    }
-
-    void Color::Sepia(double factor)
-    {
-        ColorMatrix sepiaMatrix = {{
-            {0.393 * factor, 0.769 * factor, 0.189 * factor, 0, 0},
-            {0.349 * factor, 0.686 * factor, 0.168 * factor, 0, 0},
-            {0.272 * factor, 0.534 * factor, 0.131 * factor, 0, 0},
-            {0             , 0             , 0             , 1, 0},
-            {0             , 0             , 0             , 0, 1}
-        }};
-
-        *this *= sepiaMatrix;
-    }
-
-    void Color::CrossProcess(double factor)
-    {
-        ColorMatrix crossProcessMatrix = {{
-            {1.0 * factor, 0.2 * factor,  0.1 * factor, 0, 0},
-            {0.0 * factor, 1.1 * factor, -0.1 * factor, 0, 0},
-            {0.1 * factor, 0.1 * factor,  1.0 * factor, 0, 0},
-            {0           , 0           ,  0           , 1, 0},
-            {0           , 0           ,  0           , 0, 1}
-        }};
-
-        *this *= crossProcessMatrix;
-    }
-
-    void Color::Moonlight(double factor)
-    {
-        ColorMatrix moonlightMatrix = {{
-            {0.7 * factor, 0.0 * factor, 0.3 * factor, 0, 0},
-            {0.0 * factor, 0.9 * factor, 0.1 * factor, 0, 0},
-            {0.2 * factor, 0.1 * factor, 1.1 * factor, 0, 0},
-            {0           , 0           , 0           , 1, 0},
-            {0           , 0           , 0           , 0, 1}
-        }};
-
-        *this *= moonlightMatrix;
-    }
-
-    void Color::VintageFilm(double factor)
-    {
-        ColorMatrix vintageMatrix = {{
-            {0.9 * factor, 0.1 * factor, 0.1 * factor, 0, 0},
-            {0.1 * factor, 0.9 * factor, 0.1 * factor, 0, 0},
-            {0.1 * factor, 0.2 * factor, 0.7 * factor, 0, 0},
-            {0           , 0           , 0           , 1, 0},
-            {0           , 0           , 0           , 0, 1}
-        }};
-
-        *this *= vintageMatrix;
-    }
-
-    void Color::Technicolor(double factor)
-    {
-        ColorMatrix technicolorMatrix = {{
-            { 1.6 * factor, -0.4 * factor, -0.2 * factor, 0, 0},
-            {-0.2 * factor,  1.4 * factor, -0.2 * factor, 0, 0},
-            {-0.2 * factor, -0.4 * factor,  1.6 * factor, 0, 0},
-            { 0           ,  0           ,  0           , 1, 0},
-            { 0           ,  0           ,  0           , 0, 1}
-        }};
-
-        *this *= technicolorMatrix;
-    }
-
-    void Color::Polaroid(double factor)
-    {
-        ColorMatrix polaroidMatrix = {{
-            { 1.438 * factor, -0.062 * factor, -0.062 * factor, 0, 0},
-            {-0.122 * factor,  1.378 * factor, -0.122 * factor, 0, 0},
-            {-0.016 * factor, -0.016 * factor,  1.483 * factor, 0, 0},
-            { 0             ,  0             ,  0             , 1, 0},
-            { 0             ,  0             ,  0             , 0, 1}
-        }};
-
-        *this *= polaroidMatrix;
-    }
+    void Color::ShiftWhiteLevel(double amount) { *this *= ColorMatrix::WhiteLevel(amount); }
+    void Color::ShiftBlackLevel(double amount) { *this *= ColorMatrix::BlackLevel(amount); }
+    void Color::ShiftContrast(double amount)   { *this *= ColorMatrix::Contrast(amount); }
+    void Color::Grayscale(double factor)       { *this *= ColorMatrix::Grayscale(factor); }
+    void Color::Sepia(double factor)           { *this *= ColorMatrix::Sepia(factor); }
+    void Color::CrossProcess(double factor)    { *this *= ColorMatrix::CrossProcess(factor); }
+    void Color::Moonlight(double factor)       { *this *= ColorMatrix::Moonlight(factor); }
+    void Color::VintageFilm(double factor)     { *this *= ColorMatrix::VintageFilm(factor); }
+    void Color::Technicolor(double factor)     { *this *= ColorMatrix::Technicolor(factor); }
+    void Color::Polaroid(double factor)        { *this *= ColorMatrix::Polaroid(factor); }
 
     // Mix, Average, Screen, Multiply, Overlay
     Color Color::Mix(const Color& color1, const Color& color2, double weight)
@@ -2103,12 +1937,9 @@ namespace KTLib
 
     double Color::GetLuminance() const
     {
+        // WCAG's 0.03928 threshold and sRGB's 0.04045 fall between the same two 8-bit codes
         double nR, nG, nB;
-        Normalize(nR, nG, nB);
-
-        nR = (nR <= 0.03928) ? nR / 12.92 : std::pow((nR + 0.055) / 1.055, 2.4);
-        nG = (nG <= 0.03928) ? nG / 12.92 : std::pow((nG + 0.055) / 1.055, 2.4);
-        nB = (nB <= 0.03928) ? nB / 12.92 : std::pow((nB + 0.055) / 1.055, 2.4);
+        ToLinearSRGB(nR, nG, nB);
 
         return 0.2126 * nR + 0.7152 * nG + 0.0722 * nB;
     }
@@ -2152,14 +1983,16 @@ namespace KTLib
 
     Color Color::Random(bool alpharand)
     {
-        static std::mt19937 gen(std::random_device{}());
-        static std::uniform_int_distribution<> dis(0, 255);
+        // Each call takes the next counter value, so concurrent callers never share generator state
+        static const uint64_t seed = Random::NewSeed();
+        static std::atomic<uint64_t> counter{0};
 
+        uint32_t bits = Random::Bits(seed, counter.fetch_add(1, std::memory_order_relaxed));
         return Color(
-            dis(gen),
-            dis(gen),
-            dis(gen),
-            alpharand ? dis(gen) : 255
+            (bits >> 16) & 0xFF,
+            (bits >> 8) & 0xFF,
+            bits & 0xFF,
+            alpharand ? (bits >> 24) : 255
         );
     }
 
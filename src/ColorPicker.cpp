@@ -4,7 +4,7 @@
 
 namespace KTLib
 {
-    ColorPicker::ColorPicker(const std::string& colorSpace, const std::string& format) : m_colorSpace(colorSpace), m_format(format)
+    ColorPicker::ColorPicker(const std::string& colorSpace, const std::string& format) : m_formatter(colorSpace, format)
     {
         Gdiplus::GdiplusStartupInput gdiplusStartupInput;
         Gdiplus::GdiplusStartup(&m_gdiplusToken, &gdiplusStartupInput, NULL);
@@ -179,7 +179,7 @@ namespace KTLib
     const char* ColorPicker::GetFormattedValue() const
     {
         static std::string value;
-        value = m_currentColor.ToString(m_colorSpace.c_str(), m_format);
+        value = m_formatter.Format(m_currentColor);
         return value.c_str();
     }
 
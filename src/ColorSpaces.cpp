@@ -0,0 +1,43 @@
+#include "../include/ColorSpaces.hpp"
+#include "../include/ColorPipeline.hpp"
+
+#include <stdexcept>
+
+namespace KTLib
+{
+    namespace ColorSpaces
+    {
+        namespace
+        {
+            // Maps the runtime enum onto the matching space tag, `func` is called with a default constructed tag
+            template<typename Func>
+            void Dispatch(ColorSpace space, Func&& func)
+            {
+                switch (space)
+                {
+                    case ColorSpace::LinearSRGB: func(LinearSRGB{}); return;
+                    case ColorSpace::XYZ_D65:    func(XYZ_D65{});    return;
+                    case ColorSpace::XYZ_D50:    func(XYZ_D50{});    return;
+                    case ColorSpace::Lab:        func(Lab{});        return;
+                    case ColorSpace::LCHab:      func(LCHab{});      return;
+                    case ColorSpace::OKLab:      func(OKLab{});      return;
+                    case ColorSpace::OKLCH:      func(OKLCH{});      return;
+                    case ColorSpace::HSL:        func(HSL{});        return;
+                    case ColorSpace::HSV:        func(HSV{});        return;
+                }
+
+                throw std::invalid_argument("Unknown color space");
+            }
+        }
+
+        void FromPixels(ColorSpace space, const uint32_t* pixels, size_t count, float* out)
+        {
+            Dispatch(space, [&](auto tag) { ConvertPixels<SRGB, decltype(tag)>(pixels, count, out); });
+        }
+
+        void ToPixels(ColorSpace space, const float* values, size_t count, uint32_t* pixels)
+        {
+            Dispatch(space, [&](auto tag) { ConvertPixels<decltype(tag), SRGB>(values, count, pixels); });
+        }
+    }
+}
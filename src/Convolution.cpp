@@ -0,0 +1,94 @@
+#include "../include/Convolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+namespace KTLib
+{
+    ConvolutionKernel::ConvolutionKernel(int width, int height, std::vector<float> weights, float bias)
+        : m_width(width), m_height(height), m_weights(std::move(weights)), m_bias(bias)
+    {
+        if (width <= 0 || height <= 0)
+            throw std::invalid_argument("Kernel dimensions must be positive");
+        if (m_weights.size() != static_cast<size_t>(width) * height)
+            throw std::invalid_argument("Kernel needs width * height weights");
+        for (float w : m_weights)
+        {
+            if (!std::isfinite(w))
+                throw std::invalid_argument("Kernel weights must be finite");
+        }
+        if (!std::isfinite(bias))
+            throw std::invalid_argument("Kernel bias must be finite");
+
+        FindFactors();
+        FindFixedPoint();
+    }
+
+    void ConvolutionKernel::FindFactors()
+    {
+        // A single row or column gains nothing from splitting
+        if (m_width == 1 || m_height == 1) return;
+
+        // Rank one means every row is a multiple of the row through the largest weight
+        size_t peak = 0;
+        for (size_t i = 1; i < m_weights.size(); ++i)
+        {
+            if (std::fabs(m_weights[i]) > std::fabs(m_weights[peak])) peak = i;
+        }
+
+        const float scale = m_weights[peak];
+        if (scale == 0.0f) return;
+
+        const int peakX = static_cast<int>(peak % m_width);
+        const int peakY = static_cast<int>(peak / m_width);
+        std::vector<float> row(m_weights.begin() + static_cast<ptrdiff_t>(peakY) * m_width, m_weights.begin() + static_cast<ptrdiff_t>(peakY + 1) * m_width);
+        std::vector<float> column(m_height);
+        for (int y = 0; y < m_height; ++y) column[y] = m_weights[static_cast<size_t>(y) * m_width + peakX] / scale;
+
+        const float tolerance = std::fabs(scale) * 1e-5f;
+        for (int y = 0; y < m_height; ++y)
+        {
+            for (int x = 0; x < m_width; ++x)
+            {
+                if (std::fabs(m_weights[static_cast<size_t>(y) * m_width + x] - column[y] * row[x]) > tolerance) return;
+            }
+        }
+
+        m_row = std::move(row);
+        m_column = std::move(column);
+    }
+
+    void ConvolutionKernel::FindFixedPoint()
+    {
+        if (m_weights.size() > static_cast<size_t>(MaxFixedPointTaps)) return;
+
+        // The largest shift where every weight fits int16 and no sum of 0-255 channels, bias and rounding
+        // can overflow the int32 accumulators
+        double largest = 0.0, total = std::fabs(m_bias) + 1.0;
+        for (float w : m_weights)
+        {
+            largest = std::max(largest, static_cast<double>(std::fabs(w)));
+            total += std::fabs(w) * 255.0;
+        }
+
+        int shift = 14;
+        while (shift >= 0 && (std::ldexp(largest, shift) > 32767.0 || std::ldexp(total, shift) >= 2147483647.0)) --shift;
+        if (shift < 0) return;
+
+        std::vector<int16_t> fixed(m_weights.size());
+        double error = 0.0;
+        for (size_t i = 0; i < m_weights.size(); ++i)
+        {
+            const double scaled = std::ldexp(static_cast<double>(m_weights[i]), shift);
+            fixed[i] = static_cast<int16_t>(std::lround(scaled));
+            error += std::fabs(scaled - fixed[i]) * 255.0;
+        }
+        if (std::ldexp(error, -shift) > FixedPointTolerance) return;
+
+        m_fixed = std::move(fixed);
+        m_fixedShift = shift;
+    }
+}
@@ -0,0 +1,283 @@
+#include "../include/FFT.hpp"
+#include "../include/Scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace KTLib
+{
+    namespace FFT
+    {
+        namespace
+        {
+            constexpr double Pi = 3.14159265358979323846;
+
+            // Columns gathered into contiguous buffers per task, so each one is transformed without striding
+            constexpr size_t ColumnBlock = 8;
+
+            // Multiplying by -i or +i only swaps and negates
+            inline Complex RotateQuarter(const Complex& v, bool inverse)
+            {
+                return inverse ? Complex(-v.imag(), v.real()) : Complex(v.imag(), -v.real());
+            }
+        }
+
+        size_t GoodSize(size_t n)
+        {
+            if (n <= 1) return 1;
+
+            for (size_t candidate = n; ; ++candidate)
+            {
+                size_t rest = candidate;
+                for (size_t factor : {2, 3, 5})
+                {
+                    while (rest % factor == 0) rest /= factor;
+                }
+                if (rest == 1) return candidate;
+            }
+        }
+
+        #pragma region Plan
+        Plan::Plan(size_t length) : m_length(length)
+        {
+            if (length == 0)
+                throw std::invalid_argument("FFT length must be positive");
+
+            // Radix 4 first, it does the most work per pass
+            std::vector<size_t> radices;
+            size_t rest = length;
+            while (rest % 4 == 0) { radices.push_back(4); rest /= 4; }
+            for (size_t factor = 2; rest > 1; ++factor)
+            {
+                while (rest % factor == 0) { radices.push_back(factor); rest /= factor; }
+            }
+
+            size_t span = 1;
+            for (size_t radix : radices)
+            {
+                Stage stage;
+                stage.radix = radix;
+                stage.span = span;
+                stage.twiddles.resize(span * (radix - 1));
+                for (size_t k = 0; k < span; ++k)
+                {
+                    for (size_t r = 1; r < radix; ++r)
+                    {
+                        stage.twiddles[k * (radix - 1) + r - 1] = std::polar(1.0, -2.0 * Pi * static_cast<double>(k * r) / static_cast<double>(span * radix));
+                    }
+                }
+
+                if (radix > 4)
+                {
+                    stage.roots.resize(radix);
+                    for (size_t q = 0; q < radix; ++q) stage.roots[q] = std::polar(1.0, -2.0 * Pi * static_cast<double>(q) / static_cast<double>(radix));
+                }
+
+                m_stages.push_back(std::move(stage));
+                span *= radix;
+            }
+        }
+
+        void Plan::Forward(Complex* data, Complex* scratch) const { Transform(data, scratch, false); }
+        void Plan::Inverse(Complex* data, Complex* scratch) const { Transform(data, scratch, true); }
+
+        // Stockham autosort: every stage reads one buffer and writes the other, each output already in the
+        // place the next stage wants it, so there is no bit-reversal pass
+        void Plan::Transform(Complex* data, Complex* scratch, bool inverse) const
+        {
+            const size_t n = m_length;
+            Complex* in = data;
+            Complex* out = scratch;
+            std::vector<Complex> values, results;
+
+            for (const Stage& stage : m_stages)
+            {
+                const size_t radix = stage.radix;
+                const size_t span = stage.span;
+                const size_t stride = n / radix;
+                values.resize(radix);
+                results.resize(radix);
+
+                for (size_t block = 0; block < stride; block += span)
+                {
+                    for (size_t k = 0; k < span; ++k)
+                    {
+                        const size_t j = block + k;
+                        const Complex* twiddles = stage.twiddles.data() + k * (radix - 1);
+                        Complex* v = values.data();
+
+                        v[0] = in[j];
+                        for (size_t r = 1; r < radix; ++r) v[r] = in[j + r * stride] * (inverse ? std::conj(twiddles[r - 1]) : twiddles[r - 1]);
+
+                        Complex* y = results.data();
+                        switch (radix)
+                        {
+                            case 2:
+                                y[0] = v[0] + v[1];
+                                y[1] = v[0] - v[1];
+                                break;
+                            case 3:
+                            {
+                                const Complex sum = v[1] + v[2];
+                                const Complex middle = v[0] - 0.5 * sum;
+                                const Complex turn = RotateQuarter((v[1] - v[2]) * (std::sqrt(3.0) / 2.0), inverse);
+                                y[0] = v[0] + sum;
+                                y[1] = middle + turn;
+                                y[2] = middle - turn;
+                                break;
+                            }
+                            case 4:
+                            {
+                                const Complex even0 = v[0] + v[2], even1 = v[0] - v[2];
+                                const Complex odd0 = v[1] + v[3], odd1 = RotateQuarter(v[1] - v[3], inverse);
+                                y[0] = even0 + odd0;
+                                y[1] = even1 + odd1;
+                                y[2] = even0 - odd0;
+                                y[3] = even1 - odd1;
+                                break;
+                            }
+                            default:
+                                for (size_t q = 0; q < radix; ++q)
+                                {
+                                    Complex sum = v[0];
+                                    for (size_t r = 1; r < radix; ++r)
+                                    {
+                                        const Complex& root = stage.roots[(q * r) % radix];
+                                        sum += v[r] * (inverse ? std::conj(root) : root);
+                                    }
+                                    y[q] = sum;
+                                }
+                                break;
+                        }
+
+                        Complex* dest = out + block * radix + k;
+                        for (size_t r = 0; r < radix; ++r) dest[r * span] = y[r];
+                    }
+                }
+
+                std::swap(in, out);
+            }
+
+            if (in != data) std::copy(in, in + n, data);
+            if (inverse)
+            {
+                const double scale = 1.0 / static_cast<double>(n);
+                for (size_t i = 0; i < n; ++i) data[i] *= scale;
+            }
+        }
+        #pragma endregion
+
+        #pragma region Spectrum
+        Spectrum::Spectrum(size_t width, size_t height)
+            : m_width(width), m_height(height), m_bins(width / 2 + 1), m_rowPlan(width), m_columnPlan(height), m_data(m_bins * height)
+        {
+        }
+
+        void Spectrum::Forward(const double* image, size_t stride)
+        {
+            // Z = FFT(a + ib) gives both real rows: A[k] = (Z[k] + conj(Z[-k])) / 2, B[k] = (Z[k] - conj(Z[-k])) / 2i
+            Scheduler::ForEachRange((m_height + 1) / 2, 8, [&](size_t begin, size_t length)
+            {
+                std::vector<Complex> row(m_width), scratch(m_width);
+                for (size_t pair = begin; pair < begin + length; ++pair)
+                {
+                    const size_t y = pair * 2;
+                    const bool second = y + 1 < m_height;
+                    const double* a = image + y * stride;
+                    const double* b = second ? a + stride : a;
+                    for (size_t x = 0; x < m_width; ++x) row[x] = Complex(a[x], second ? b[x] : 0.0);
+
+                    m_rowPlan.Forward(row.data(), scratch.data());
+
+                    Complex* first = Row(y);
+                    for (size_t kx = 0; kx < m_bins; ++kx)
+                    {
+                        const Complex z = row[kx];
+                        const Complex mirror = std::conj(row[(m_width - kx) % m_width]);
+                        first[kx] = (z + mirror) * 0.5;
+                        if (second) Row(y + 1)[kx] = (z - mirror) * Complex(0.0, -0.5);
+                    }
+                }
+            });
+
+            Scheduler::ForEachRange(m_bins, ColumnBlock, [&](size_t begin, size_t length)
+            {
+                std::vector<Complex> columns(length * m_height), scratch(m_height);
+                for (size_t ky = 0; ky < m_height; ++ky)
+                {
+                    for (size_t c = 0; c < length; ++c) columns[c * m_height + ky] = Row(ky)[begin + c];
+                }
+                for (size_t c = 0; c < length; ++c) m_columnPlan.Forward(columns.data() + c * m_height, scratch.data());
+                for (size_t ky = 0; ky < m_height; ++ky)
+                {
+                    for (size_t c = 0; c < length; ++c) Row(ky)[begin + c] = columns[c * m_height + ky];
+                }
+            });
+        }
+
+        void Spectrum::Inverse(double* image, size_t stride)
+        {
+            Scheduler::ForEachRange(m_bins, ColumnBlock, [&](size_t begin, size_t length)
+            {
+                std::vector<Complex> columns(length * m_height), scratch(m_height);
+                for (size_t ky = 0; ky < m_height; ++ky)
+                {
+                    for (size_t c = 0; c < length; ++c) columns[c * m_height + ky] = Row(ky)[begin + c];
+                }
+                for (size_t c = 0; c < length; ++c) m_columnPlan.Inverse(columns.data() + c * m_height, scratch.data());
+                for (size_t ky = 0; ky < m_height; ++ky)
+                {
+                    for (size_t c = 0; c < length; ++c) Row(ky)[begin + c] = columns[c * m_height + ky];
+                }
+            });
+
+            // The missing bins are the conjugates of the kept ones, and A + iB transforms back to a in the real
+            // part and b in the imaginary part
+            Scheduler::ForEachRange((m_height + 1) / 2, 8, [&](size_t begin, size_t length)
+            {
+                std::vector<Complex> row(m_width), scratch(m_width);
+                for (size_t pair = begin; pair < begin + length; ++pair)
+                {
+                    const size_t y = pair * 2;
+                    const bool second = y + 1 < m_height;
+                    const Complex* a = Row(y);
+                    const Complex* b = second ? Row(y + 1) : nullptr;
+                    for (size_t kx = 0; kx < m_width; ++kx)
+                    {
+                        const bool kept = kx < m_bins;
+                        const size_t bin = kept ? kx : m_width - kx;
+                        const Complex first = kept ? a[bin] : std::conj(a[bin]);
+                        const Complex other = b ? (kept ? b[bin] : std::conj(b[bin])) : Complex();
+                        row[kx] = first + Complex(-other.imag(), other.real());
+                    }
+
+                    m_rowPlan.Inverse(row.data(), scratch.data());
+
+                    double* outA = image + y * stride;
+                    for (size_t x = 0; x < m_width; ++x) outA[x] = row[x].real();
+                    if (second)
+                    {
+                        double* outB = outA + stride;
+                        for (size_t x = 0; x < m_width; ++x) outB[x] = row[x].imag();
+                    }
+                }
+            });
+        }
+
+        void Spectrum::Multiply(const Spectrum& other)
+        {
+            if (other.m_width != m_width || other.m_height != m_height)
+                throw std::invalid_argument("Spectra must be the same size");
+
+            Scheduler::For(m_height, [&](size_t ky)
+            {
+                Complex* row = Row(ky);
+                const Complex* factor = other.Row(ky);
+                for (size_t kx = 0; kx < m_bins; ++kx) row[kx] *= factor[kx];
+            });
+        }
+        #pragma endregion
+    }
+}
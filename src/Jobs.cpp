@@ -0,0 +1,339 @@
+#include "../include/Jobs.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace KTLib
+{
+    namespace Jobs
+    {
+        namespace
+        {
+            #pragma region Canvas Locks
+            // Started jobs per canvas, WaitForCanvas blocks until a canvas drops out of here
+            std::mutex g_lockMutex;
+            std::condition_variable g_lockReleased;
+            std::unordered_map<const Canvas*, int> g_lockedCanvases;
+
+            // Views write into their parent's pixels, so a parent and all of its views share one lock
+            const Canvas* LockKey(const Canvas* canvas) { return canvas->GetParent() ? canvas->GetParent() : canvas; }
+
+            void LockCanvas(const Canvas* canvas)
+            {
+                std::lock_guard<std::mutex> lock(g_lockMutex);
+                ++g_lockedCanvases[LockKey(canvas)];
+            }
+
+            void UnlockCanvas(const Canvas* canvas)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(g_lockMutex);
+                    auto it = g_lockedCanvases.find(LockKey(canvas));
+                    if (--it->second == 0) g_lockedCanvases.erase(it);
+                }
+                g_lockReleased.notify_all();
+            }
+            #pragma endregion
+
+            #pragma region Operations
+            class Arguments
+            {
+                public:
+                    explicit Arguments(const std::vector<double>& values) : m_values(values) { }
+
+                    double operator()(size_t index) const
+                    {
+                        if (index >= m_values.size())
+                            throw std::invalid_argument("Missing operation argument");
+                        return m_values[index];
+                    }
+
+                    double operator()(size_t index, double fallback) const { return index < m_values.size() ? m_values[index] : fallback; }
+
+                    int Int(size_t index) const { return static_cast<int>((*this)(index)); }
+                    int Int(size_t index, int fallback) const { return static_cast<int>((*this)(index, fallback)); }
+                    uint64_t Seed(size_t index) const { return static_cast<uint64_t>((*this)(index, 0)); }
+                    Color ColorArg(size_t index, uint32_t fallback) const { return Color(static_cast<uint32_t>((*this)(index, fallback))); }
+
+                private:
+                    const std::vector<double>& m_values;
+            };
+
+            // Convolve takes width, height, the width * height weights, then bias and alpha
+            size_t KernelSize(const Arguments& a)
+            {
+                return static_cast<size_t>(std::max(a.Int(0), 0)) * static_cast<size_t>(std::max(a.Int(1), 0));
+            }
+
+            ConvolutionKernel KernelArg(const Arguments& a)
+            {
+                const size_t count = KernelSize(a);
+                std::vector<float> weights(count);
+                for (size_t i = 0; i < count; ++i) weights[i] = static_cast<float>(a(2 + i));
+                return ConvolutionKernel(a.Int(0), a.Int(1), std::move(weights), static_cast<float>(a(2 + count, 0.0)));
+            }
+
+            using Entry = void (*)(Canvas&, const Arguments&);
+
+            // Same names and defaults as the Canvas methods in Color.ahk, colors are passed as ARGB integers
+            const std::unordered_map<std::string, Entry>& GetOperations()
+            {
+                static const std::unordered_map<std::string, Entry> operations = {
+                    {"ShiftRed",              [](Canvas& c, const Arguments& a) { c.ShiftRed(a.Int(0)); }},
+                    {"ShiftGreen",            [](Canvas& c, const Arguments& a) { c.ShiftGreen(a.Int(0)); }},
+                    {"ShiftBlue",             [](Canvas& c, const Arguments& a) { c.ShiftBlue(a.Int(0)); }},
+                    {"ShiftAlpha",            [](Canvas& c, const Arguments& a) { c.ShiftAlpha(a.Int(0)); }},
+                    {"SetRed",                [](Canvas& c, const Arguments& a) { c.SetRed(a.Int(0)); }},
+                    {"SetGreen",              [](Canvas& c, const Arguments& a) { c.SetGreen(a.Int(0)); }},
+                    {"SetBlue",               [](Canvas& c, const Arguments& a) { c.SetBlue(a.Int(0)); }},
+                    {"SetAlpha",              [](Canvas& c, const Arguments& a) { c.SetAlpha(a.Int(0)); }},
+
+                    {"Invert",                [](Canvas& c, const Arguments&)   { c.Invert(); }},
+                    {"Complement",            [](Canvas& c, const Arguments&)   { c.Complement(); }},
+                    {"Grayscale",             [](Canvas& c, const Arguments&)   { c.Grayscale(); }},
+                    {"ShiftHue",              [](Canvas& c, const Arguments& a) { c.ShiftHue(a(0)); }},
+                    {"Sepia",                 [](Canvas& c, const Arguments& a) { c.Sepia(a(0)); }},
+                    {"CrossProcess",          [](Canvas& c, const Arguments& a) { c.CrossProcess(a(0)); }},
+                    {"Moonlight",             [](Canvas& c, const Arguments& a) { c.Moonlight(a(0)); }},
+                    {"VintageFilm",           [](Canvas& c, const Arguments& a) { c.VintageFilm(a(0)); }},
+                    {"Technicolor",           [](Canvas& c, const Arguments& a) { c.Technicolor(a(0)); }},
+                    {"Polaroid",              [](Canvas& c, const Arguments& a) { c.Polaroid(a(0)); }},
+                    {"ShiftSaturation",       [](Canvas& c, const Arguments& a) { c.ShiftSaturation(a(0)); }},
+                    {"ShiftLightness",        [](Canvas& c, const Arguments& a) { c.ShiftLightness(a(0)); }},
+                    {"ShiftValue",            [](Canvas& c, const Arguments& a) { c.ShiftValue(a(0)); }},
+                    {"ShiftIntensity",        [](Canvas& c, const Arguments& a) { c.ShiftIntensity(a(0)); }},
+                    {"ShiftWhiteLevel",       [](Canvas& c, const Arguments& a) { c.ShiftWhiteLevel(a(0)); }},
+                    {"ShiftBlackLevel",       [](Canvas& c, const Arguments& a) { c.ShiftBlackLevel(a(0)); }},
+                    {"ShiftContrast",         [](Canvas& c, const Arguments& a) { c.ShiftContrast(a(0)); }},
+                    {"AdjustContrast",        [](Canvas& c, const Arguments& a) { c.AdjustContrast(a(0)); }},
+                    {"ColorBalance",          [](Canvas& c, const Arguments& a) { c.AdjustColorBalance(a(0), a(1), a(2)); }},
+
+                    {"Pixelate",              [](Canvas& c, const Arguments& a) { c.Pixelate(a.Int(0)); }},
+                    {"Blur",                  [](Canvas& c, const Arguments& a) { c.Blur(a.Int(0), a.Int(1, 1)); }},
+                    {"GaussianBlur",          [](Canvas& c, const Arguments& a) { c.GaussianBlur(a(0)); }},
+                    {"GaussianBlurRadius",    [](Canvas& c, const Arguments& a) { c.GaussianBlurRadius(a.Int(0)); }},
+                    {"Convolve",              [](Canvas& c, const Arguments& a) { c.Convolve(KernelArg(a), static_cast<ConvolveAlpha>(a.Int(3 + KernelSize(a), 1))); }},
+                    {"LowPass",               [](Canvas& c, const Arguments& a) { c.LowPass(a(0)); }},
+                    {"HighPass",              [](Canvas& c, const Arguments& a) { c.HighPass(a(0)); }},
+                    {"Sharpen",               [](Canvas& c, const Arguments& a) { c.Sharpen(static_cast<float>(a(0))); }},
+                    {"Emboss",                [](Canvas& c, const Arguments&)   { c.Emboss(); }},
+                    {"EdgeDetect",            [](Canvas& c, const Arguments&)   { c.EdgeDetect(); }},
+                    {"Vignette",              [](Canvas& c, const Arguments& a) { c.Vignette(a(0, 0.3), a(1, 1.0)); }},
+                    {"Posterize",             [](Canvas& c, const Arguments& a) { c.Posterize(a.Int(0, 4)); }},
+
+                    {"Flip",                  [](Canvas& c, const Arguments& a) { c.Flip(a(0, 1) != 0); }},
+                    {"Crop",                  [](Canvas& c, const Arguments& a) { c.Crop(a.Int(0), a.Int(1), a.Int(2), a.Int(3)); }},
+                    {"Rotate",                [](Canvas& c, const Arguments& a) { c.Rotate(a(0)); }},
+                    {"Resize",                [](Canvas& c, const Arguments& a) { c.Resize(a.Int(0), a.Int(1), a.Int(2, 1), a.ColorArg(3, 0x00000000)); }},
+                    {"Scale",                 [](Canvas& c, const Arguments& a) { c.Scale(a(0)); }},
+                    {"Shuffle",               [](Canvas& c, const Arguments& a) { c.Shuffle(a.Seed(0)); }},
+
+                    {"TwoColorNoise",         [](Canvas& c, const Arguments& a) { c.TwoColorNoise(a(0, 0.05), a.ColorArg(1, 0xFFFFFFFF), a.ColorArg(2, 0xFF000000), a.Seed(3)); }},
+                    {"GaussianNoise",         [](Canvas& c, const Arguments& a) { c.GaussianNoise(a(0, 0.0), a(1, 10.0), a.Seed(2)); }},
+                    {"PerlinNoise",           [](Canvas& c, const Arguments& a) { c.PerlinNoise(a(0, 4.0), a(1, 1.0), a.Int(2, 4), a(3, 0.5), a(4, 2.0), a.Seed(5)); }},
+                    {"SimplexNoise",          [](Canvas& c, const Arguments& a) { c.SimplexNoise(a(0, 4.0), a(1, 1.0), a.Int(2, 4), a(3, 0.5), a(4, 2.0), a.Seed(5)); }},
+                    {"FractalBrownianMotion", [](Canvas& c, const Arguments& a) { c.FractalBrownianMotion(a(0, 4.0), a(1, 1.0), a.Int(2, 4), a(3, 0.5), a(4, 2.0), a.Seed(5)); }},
+                    {"VoronoiDiagram",        [](Canvas& c, const Arguments& a) { c.Voronoi(a.Int(0, 20), a(1, 1.0), a(2, 1.0), a.Seed(3)); }},
+                    {"Plasma",                [](Canvas& c, const Arguments& a) { c.Plasma(a(0, 5.0), a(1, 0.0)); }},
+                    {"DiamondSquare",         [](Canvas& c, const Arguments& a) { c.DiamondSquare(a(0, 5.0), a(1, 1.0), a(2, 5.0), a.Seed(3)); }}
+                };
+                return operations;
+            }
+            #pragma endregion
+        }
+
+        Operation MakeOperation(const std::string& name, const std::vector<double>& args)
+        {
+            auto it = GetOperations().find(name);
+            if (it == GetOperations().end())
+                throw std::invalid_argument("Unknown canvas operation: " + name);
+
+            Entry entry = it->second;
+            return [entry, args](Canvas& canvas) { entry(canvas, Arguments(args)); };
+        }
+
+        #pragma region Runner
+        // Owns the job thread and the queue. Like the Scheduler pool it is never destroyed, Shutdown joins the thread
+        class Runner
+        {
+            public:
+                static Runner& Get()
+                {
+                    static Runner* runner = new Runner();
+                    return *runner;
+                }
+
+                void Enqueue(Job* job)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (!m_thread.joinable()) m_thread = std::thread(&Runner::Loop, this);
+                        m_queue.push_back(job);
+                    }
+                    m_wake.notify_one();
+                }
+
+                void Shutdown()
+                {
+                    std::thread thread;
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (!m_thread.joinable()) return;
+
+                        m_stopping = true;
+                        thread = std::move(m_thread);
+                    }
+                    m_wake.notify_one();
+                    thread.join();
+
+                    m_stopping = false;
+                }
+
+            private:
+                void Loop()
+                {
+                    while (true)
+                    {
+                        Job* job;
+                        {
+                            std::unique_lock<std::mutex> lock(m_mutex);
+                            m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+
+                            // Drain before stopping, cancelled jobs still have to report that they finished
+                            if (m_queue.empty()) return;
+                            job = m_queue.front();
+                            m_queue.pop_front();
+                        }
+
+                        job->Run(m_stopping);
+                    }
+                }
+
+                std::mutex m_mutex;
+                std::condition_variable m_wake;
+                std::deque<Job*> m_queue;
+                std::thread m_thread;
+                std::atomic<bool> m_stopping{false};
+        };
+        #pragma endregion
+
+        #pragma region Job
+        Job::Job(Canvas* canvas) : m_canvas(canvas)
+        {
+            if (!canvas)
+                throw std::invalid_argument("Canvas cannot be null");
+        }
+
+        Job::~Job()
+        {
+            Cancel();
+            if (GetState() != JobState::Pending) Wait();
+        }
+
+        void Job::Add(Operation operation)
+        {
+            if (GetState() != JobState::Pending)
+                throw std::logic_error("Operations cannot be added to a job that has been started");
+
+            m_operations.push_back(std::move(operation));
+        }
+
+        void Job::Start()
+        {
+            if (GetState() != JobState::Pending)
+                throw std::logic_error("Job has already been started");
+
+            LockCanvas(m_canvas);
+            m_state = JobState::Queued;
+            Runner::Get().Enqueue(this);
+        }
+
+        void Job::Cancel() { m_cancelled = true; }
+
+        bool Job::Wait(int timeoutMs)
+        {
+            if (GetState() == JobState::Pending)
+                throw std::logic_error("Job has not been started");
+
+            auto finished = [this] { JobState state = GetState(); return state != JobState::Queued && state != JobState::Running; };
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (timeoutMs < 0)
+            {
+                m_finished.wait(lock, finished);
+                return true;
+            }
+
+            return m_finished.wait_for(lock, std::chrono::milliseconds(timeoutMs), finished);
+        }
+
+        double Job::GetProgress() const
+        {
+            if (m_operations.empty()) return GetState() == JobState::Completed ? 1.0 : 0.0;
+            return static_cast<double>(m_completed.load()) / m_operations.size();
+        }
+
+        void Job::Run(const std::atomic<bool>& stopping)
+        {
+            m_state = JobState::Running;
+
+            for (const Operation& operation : m_operations)
+            {
+                if (m_cancelled || stopping)
+                {
+                    Finish(JobState::Cancelled);
+                    return;
+                }
+
+                try
+                {
+                    operation(*m_canvas);
+                }
+                catch (const std::exception& e)
+                {
+                    m_error = e.what();
+                    Finish(JobState::Failed);
+                    return;
+                }
+                catch (...)
+                {
+                    m_error = "Unknown error";
+                    Finish(JobState::Failed);
+                    return;
+                }
+
+                ++m_completed;
+            }
+
+            Finish(JobState::Completed);
+        }
+
+        // A waiting owner may delete the job as soon as the state is set, so the canvas is unlocked
+        // from a copy of the pointer afterwards. That way WaitForCanvas never sees a job still running
+        void Job::Finish(JobState state)
+        {
+            Canvas* canvas = m_canvas;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_state = state;
+                m_finished.notify_all();
+            }
+            UnlockCanvas(canvas);
+        }
+        #pragma endregion
+
+        Canvas* WaitForCanvas(Canvas* canvas)
+        {
+            const Canvas* key = LockKey(canvas);
+            std::unique_lock<std::mutex> lock(g_lockMutex);
+            g_lockReleased.wait(lock, [key] { return g_lockedCanvases.find(key) == g_lockedCanvases.end(); });
+            return canvas;
+        }
+
+        void Shutdown() { Runner::Get().Shutdown(); }
+    }
+}
@@ -0,0 +1,1294 @@
+#include "../include/Kernels.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define KTLIB_KERNELS_X86
+#endif
+
+namespace KTLib
+{
+    namespace Kernels
+    {
+        namespace
+        {
+            Level DetectLevel()
+            {
+                #ifdef KTLIB_KERNELS_X86
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2")) return Level::AVX2;
+                if (__builtin_cpu_supports("sse2")) return Level::SSE2;
+                #endif
+                return Level::Scalar;
+            }
+
+            std::atomic<Level>& ActiveLevel()
+            {
+                static std::atomic<Level> level{GetSupportedLevel()};
+                return level;
+            }
+
+            #pragma region Scalar
+            // The SIMD paths below evaluate in exactly this order so every level produces identical pixels
+            inline uint32_t ApplyMatrixPixel(uint32_t pixel, const MatrixCoefficients& c)
+            {
+                const float in[4] = {
+                    static_cast<float>((pixel >> 16) & 0xFF),
+                    static_cast<float>((pixel >> 8) & 0xFF),
+                    static_cast<float>(pixel & 0xFF),
+                    static_cast<float>(pixel >> 24)
+                };
+
+                uint32_t out[4];
+                for (int row = 0; row < 4; ++row)
+                {
+                    float v = c.m[row][0] * in[0];
+                    v = v + c.m[row][1] * in[1];
+                    v = v + c.m[row][2] * in[2];
+                    v = v + c.m[row][3] * in[3];
+                    v = v + c.offset[row];
+                    out[row] = static_cast<uint32_t>(std::min(std::max(v, 0.0f), 255.0f));
+                }
+
+                return (out[3] << 24) | (out[0] << 16) | (out[1] << 8) | out[2];
+            }
+
+            void ApplyMatrixScalar(uint32_t* pixels, size_t count, const MatrixCoefficients& c)
+            {
+                for (size_t i = 0; i < count; ++i) pixels[i] = ApplyMatrixPixel(pixels[i], c);
+            }
+
+            inline float Clamp01(float v) { return std::min(std::max(v, 0.0f), 1.0f); }
+            inline float Clamp255(float v) { return std::min(std::max(v, 0.0f), 255.0f); }
+
+            // How far a channel sits between min and max at sextant hue `k`, the HSL/HSV hue wheel
+            inline float HueChannel(float k)
+            {
+                k = (k >= 6.0f) ? k - 6.0f : k;
+                return 1.0f - Clamp01(std::min(k, 4.0f - k));
+            }
+
+            // Channels are kept in 0-255 throughout. `delta` is already in the component's own units,
+            // see ShiftComponent. Greys get hue 0 (pure red) exactly like Color::ToHSL/FromHSL
+            template<ComponentShift C>
+            inline uint32_t ShiftComponentPixel(uint32_t pixel, float delta)
+            {
+                const float r = static_cast<float>((pixel >> 16) & 0xFF);
+                const float g = static_cast<float>((pixel >> 8) & 0xFF);
+                const float b = static_cast<float>(pixel & 0xFF);
+
+                const float mx = std::max(std::max(r, g), b);
+                const float mn = std::min(std::min(r, g), b);
+                const float c = mx - mn;
+                float outR, outG, outB;
+
+                if constexpr (C == ComponentShift::Intensity)
+                {
+                    const float i = (r + g + b) / 3.0f;
+                    const float shifted = Clamp255(i + delta);
+                    const float scale = shifted / i;
+                    outR = (i > 0.0f) ? r * scale : shifted;
+                    outG = (i > 0.0f) ? g * scale : shifted;
+                    outB = (i > 0.0f) ? b * scale : shifted;
+                }
+                else if constexpr (C == ComponentShift::Hue)
+                {
+                    float h = 0.0f;
+                    if (c > 0.0f)
+                    {
+                        if (mx == r)      h = (g - b) / c;
+                        else if (mx == g) h = 2.0f + (b - r) / c;
+                        else              h = 4.0f + (r - g) / c;
+                    }
+                    h = (h < 0.0f) ? h + 6.0f : h;
+                    h = std::min(std::max(h + delta, 0.0f), 6.0f);
+                    h = (h >= 6.0f) ? h - 6.0f : h;
+
+                    outR = mn + c * HueChannel(h + 5.0f);
+                    outG = mn + c * HueChannel(h + 3.0f);
+                    outB = mn + c * HueChannel(h + 1.0f);
+                }
+                else
+                {
+                    const float hr = (c > 0.0f) ? (r - mn) / c : 1.0f;
+                    const float hg = (c > 0.0f) ? (g - mn) / c : 0.0f;
+                    const float hb = (c > 0.0f) ? (b - mn) / c : 0.0f;
+
+                    if constexpr (C == ComponentShift::Value)
+                    {
+                        const float s = (mx > 0.0f) ? c / mx : 0.0f;
+                        const float v = Clamp255(mx + delta);
+                        const float chroma = s * v;
+                        outR = v + chroma * (hr - 1.0f);
+                        outG = v + chroma * (hg - 1.0f);
+                        outB = v + chroma * (hb - 1.0f);
+                    }
+                    else
+                    {
+                        const float l = (mx + mn) * 0.5f;
+                        const float span = 255.0f - std::abs(mx + mn - 255.0f);
+                        float s = (span > 0.0f) ? c / span : 0.0f;
+                        float newL = l, newSpan = span;
+
+                        if constexpr (C == ComponentShift::Saturation)
+                        {
+                            s = Clamp01(s + delta);
+                        }
+                        else
+                        {
+                            newL = Clamp255(l + delta);
+                            newSpan = 255.0f - std::abs(newL + newL - 255.0f);
+                        }
+
+                        const float chroma = s * newSpan;
+                        outR = newL + chroma * (hr - 0.5f);
+                        outG = newL + chroma * (hg - 0.5f);
+                        outB = newL + chroma * (hb - 0.5f);
+                    }
+                }
+
+                return (pixel & 0xFF000000)
+                     | (static_cast<uint32_t>(Clamp255(outR)) << 16)
+                     | (static_cast<uint32_t>(Clamp255(outG)) << 8)
+                     |  static_cast<uint32_t>(Clamp255(outB));
+            }
+
+            template<ComponentShift C>
+            void ShiftComponentScalar(uint32_t* pixels, size_t count, float delta)
+            {
+                for (size_t i = 0; i < count; ++i) pixels[i] = ShiftComponentPixel<C>(pixels[i], delta);
+            }
+
+            // x * y / 255 rounded to nearest, exact for 0-255 inputs. The SIMD paths take the same steps in 16-bit lanes
+            inline uint32_t MulDiv255(uint32_t x, uint32_t y)
+            {
+                uint32_t t = x * y + 128;
+                return (t + (t >> 8)) >> 8;
+            }
+
+            inline uint32_t PremultiplyPixel(uint32_t pixel)
+            {
+                uint32_t a = pixel >> 24;
+                return (pixel & 0xFF000000)
+                     | (MulDiv255((pixel >> 16) & 0xFF, a) << 16)
+                     | (MulDiv255((pixel >> 8) & 0xFF, a) << 8)
+                     |  MulDiv255(pixel & 0xFF, a);
+            }
+
+            inline uint32_t UnpremultiplyPixel(uint32_t pixel)
+            {
+                uint32_t a = pixel >> 24;
+                if (a == 0) return 0;
+
+                auto channel = [a](uint32_t c) { return std::min<uint32_t>((c * 255 + a / 2) / a, 255); };
+                return (pixel & 0xFF000000)
+                     | (channel((pixel >> 16) & 0xFF) << 16)
+                     | (channel((pixel >> 8) & 0xFF) << 8)
+                     |  channel(pixel & 0xFF);
+            }
+
+            inline uint32_t CompositeOverPixel(uint32_t dest, uint32_t source, uint32_t opacity)
+            {
+                uint32_t inverse = 255 - MulDiv255(source >> 24, opacity);
+                uint32_t out = 0;
+                for (int shift = 0; shift < 32; shift += 8)
+                {
+                    uint32_t s = MulDiv255((source >> shift) & 0xFF, opacity);
+                    uint32_t d = MulDiv255((dest >> shift) & 0xFF, inverse);
+                    out |= std::min<uint32_t>(s + d, 255) << shift;
+                }
+
+                return out;
+            }
+
+            // Box sums hold 4 ints per pixel in memory byte order (B G R A), so the SIMD paths can widen pixels
+            // straight into them
+            inline void AddPixelSums(int32_t* sums, uint32_t pixel, int32_t sign)
+            {
+                for (int k = 0; k < 4; ++k) sums[k] += sign * static_cast<int32_t>((pixel >> (8 * k)) & 0xFF);
+            }
+
+            inline uint32_t AveragePixelSums(const int32_t* sums, int divisor)
+            {
+                uint32_t out = 0;
+                for (int k = 0; k < 4; ++k) out |= static_cast<uint32_t>(sums[k] / divisor) << (8 * k);
+                return out;
+            }
+
+            // Pixels in [x - radius, x + radius] that fall inside the row
+            inline int BoxWindow(int x, int width, int radius)
+            {
+                return std::min(x, radius) + 1 + std::min(width - 1 - x, radius);
+            }
+
+            void BoxBlurRowScalar(const uint32_t* source, uint32_t* dest, int width, int radius)
+            {
+                int32_t sums[4] = {};
+                for (int x = 0; x < std::min(radius, width); ++x) AddPixelSums(sums, source[x], 1);
+
+                for (int x = 0; x < width; ++x)
+                {
+                    if (x > radius) AddPixelSums(sums, source[x - radius - 1], -1);
+                    if (x < width - radius) AddPixelSums(sums, source[x + radius], 1);
+                    dest[x] = AveragePixelSums(sums, BoxWindow(x, width, radius));
+                }
+            }
+
+            void SlideColumnsScalar(int32_t* sums, const uint32_t* entering, const uint32_t* leaving, size_t count)
+            {
+                for (size_t c = 0; c < count; ++c)
+                {
+                    if (entering) AddPixelSums(sums + c * 4, entering[c], 1);
+                    if (leaving) AddPixelSums(sums + c * 4, leaving[c], -1);
+                }
+            }
+
+            void AverageColumnsScalar(const int32_t* sums, size_t count, int divisor, uint32_t* dest)
+            {
+                for (size_t c = 0; c < count; ++c) dest[c] = AveragePixelSums(sums + c * 4, divisor);
+            }
+
+            // One step of the recursive Gaussian, the newest output goes to `oldest`. Same order of operations
+            // at every level
+            void RecursiveStepScalar(float* values, const double* newer, const double* older, double* oldest, size_t width, const GaussianCoefficients& g)
+            {
+                for (size_t k = 0; k < width; ++k)
+                {
+                    const double y = g.gain * values[k] + g.feedback[0] * newer[k] + g.feedback[1] * older[k] + g.feedback[2] * oldest[k];
+                    oldest[k] = y;
+                    values[k] = static_cast<float>(y);
+                }
+            }
+
+            inline uint32_t ConvolveFixedPixel(const uint32_t* const* rows, const FixedTap* taps, size_t tapCount, int shift, int32_t offset, size_t x)
+            {
+                int32_t acc[4] = {offset, offset, offset, offset};
+                for (size_t t = 0; t < tapCount; ++t)
+                {
+                    const uint32_t pixel = rows[taps[t].row][taps[t].column + x];
+                    for (int k = 0; k < 4; ++k) acc[k] += taps[t].weight * static_cast<int32_t>((pixel >> (8 * k)) & 0xFF);
+                }
+
+                uint32_t out = 0;
+                for (int k = 0; k < 4; ++k) out |= static_cast<uint32_t>(std::clamp(acc[k] >> shift, 0, 255)) << (8 * k);
+                return out;
+            }
+
+            void ConvolveFixedScalar(const uint32_t* const* rows, const FixedTap* taps, size_t tapCount, int shift, int32_t offset, size_t count, uint32_t* dest)
+            {
+                for (size_t x = 0; x < count; ++x) dest[x] = ConvolveFixedPixel(rows, taps, tapCount, shift, offset, x);
+            }
+
+            // Taps go through the SIMD paths in pairs, an odd one out is paired with itself at weight 0
+            inline int32_t TapPairWeights(const FixedTap* taps, size_t tapCount, size_t t)
+            {
+                const uint16_t second = (t + 1 < tapCount) ? static_cast<uint16_t>(taps[t + 1].weight) : 0;
+                return static_cast<int32_t>(static_cast<uint16_t>(taps[t].weight) | (static_cast<uint32_t>(second) << 16));
+            }
+
+            inline const FixedTap& SecondTap(const FixedTap* taps, size_t tapCount, size_t t)
+            {
+                return taps[(t + 1 < tapCount) ? t + 1 : t];
+            }
+            #pragma endregion
+
+            #ifdef KTLIB_KERNELS_X86
+            #pragma region SSE2
+            __attribute__((target("sse2"), always_inline))
+            inline __m128i MatrixRowSSE2(const __m128 (&m)[4], __m128 offset, __m128 r, __m128 g, __m128 b, __m128 a)
+            {
+                __m128 v = _mm_mul_ps(m[0], r);
+                v = _mm_add_ps(v, _mm_mul_ps(m[1], g));
+                v = _mm_add_ps(v, _mm_mul_ps(m[2], b));
+                v = _mm_add_ps(v, _mm_mul_ps(m[3], a));
+                v = _mm_add_ps(v, offset);
+                v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+                return _mm_cvttps_epi32(v);
+            }
+
+            __attribute__((target("sse2")))
+            void ApplyMatrixSSE2(uint32_t* pixels, size_t count, const MatrixCoefficients& c)
+            {
+                __m128 m[4][4], offset[4];
+                for (int row = 0; row < 4; ++row)
+                {
+                    for (int col = 0; col < 4; ++col) m[row][col] = _mm_set1_ps(c.m[row][col]);
+                    offset[row] = _mm_set1_ps(c.offset[row]);
+                }
+
+                const __m128i mask = _mm_set1_epi32(0xFF);
+
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+                    __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 16), mask));
+                    __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 8), mask));
+                    __m128 b = _mm_cvtepi32_ps(_mm_and_si128(px, mask));
+                    __m128 a = _mm_cvtepi32_ps(_mm_srli_epi32(px, 24));
+
+                    __m128i outR = MatrixRowSSE2(m[0], offset[0], r, g, b, a);
+                    __m128i outG = MatrixRowSSE2(m[1], offset[1], r, g, b, a);
+                    __m128i outB = MatrixRowSSE2(m[2], offset[2], r, g, b, a);
+                    __m128i outA = MatrixRowSSE2(m[3], offset[3], r, g, b, a);
+
+                    __m128i out = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(outA, 24), _mm_slli_epi32(outR, 16)),
+                                               _mm_or_si128(_mm_slli_epi32(outG, 8), outB));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), out);
+                }
+
+                for (; i < count; ++i) pixels[i] = ApplyMatrixPixel(pixels[i], c);
+            }
+
+            __attribute__((target("sse2"), always_inline))
+            inline __m128 SelectSSE2(__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+            __attribute__((target("sse2"), always_inline))
+            inline __m128 ClampSSE2(__m128 v, float hi) { return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(hi)); }
+
+            __attribute__((target("sse2"), always_inline))
+            inline __m128 AbsSSE2(__m128 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+
+            __attribute__((target("sse2"), always_inline))
+            inline __m128 HueChannelSSE2(__m128 k)
+            {
+                const __m128 six = _mm_set1_ps(6.0f);
+                k = SelectSSE2(_mm_cmpge_ps(k, six), _mm_sub_ps(k, six), k);
+                return _mm_sub_ps(_mm_set1_ps(1.0f), ClampSSE2(_mm_min_ps(k, _mm_sub_ps(_mm_set1_ps(4.0f), k)), 1.0f));
+            }
+
+            // Same operations in the same order as ShiftComponentPixel, 4 pixels at a time
+            template<ComponentShift C>
+            __attribute__((target("sse2")))
+            void ShiftComponentSSE2(uint32_t* pixels, size_t count, float delta)
+            {
+                const __m128i mask = _mm_set1_epi32(0xFF);
+                const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 one = _mm_set1_ps(1.0f);
+                const __m128 half = _mm_set1_ps(0.5f);
+                const __m128 full = _mm_set1_ps(255.0f);
+                const __m128 shift = _mm_set1_ps(delta);
+
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+                    __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 16), mask));
+                    __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 8), mask));
+                    __m128 b = _mm_cvtepi32_ps(_mm_and_si128(px, mask));
+
+                    __m128 mx = _mm_max_ps(_mm_max_ps(r, g), b);
+                    __m128 mn = _mm_min_ps(_mm_min_ps(r, g), b);
+                    __m128 c = _mm_sub_ps(mx, mn);
+                    __m128 outR, outG, outB;
+
+                    if constexpr (C == ComponentShift::Intensity)
+                    {
+                        __m128 in = _mm_div_ps(_mm_add_ps(_mm_add_ps(r, g), b), _mm_set1_ps(3.0f));
+                        __m128 shifted = ClampSSE2(_mm_add_ps(in, shift), 255.0f);
+                        __m128 scale = _mm_div_ps(shifted, in);
+                        __m128 lit = _mm_cmpgt_ps(in, zero);
+                        outR = SelectSSE2(lit, _mm_mul_ps(r, scale), shifted);
+                        outG = SelectSSE2(lit, _mm_mul_ps(g, scale), shifted);
+                        outB = SelectSSE2(lit, _mm_mul_ps(b, scale), shifted);
+                    }
+                    else if constexpr (C == ComponentShift::Hue)
+                    {
+                        const __m128 six = _mm_set1_ps(6.0f);
+                        __m128 hR = _mm_div_ps(_mm_sub_ps(g, b), c);
+                        __m128 hG = _mm_add_ps(_mm_set1_ps(2.0f), _mm_div_ps(_mm_sub_ps(b, r), c));
+                        __m128 hB = _mm_add_ps(_mm_set1_ps(4.0f), _mm_div_ps(_mm_sub_ps(r, g), c));
+                        __m128 h = SelectSSE2(_mm_cmpeq_ps(mx, r), hR, SelectSSE2(_mm_cmpeq_ps(mx, g), hG, hB));
+                        h = SelectSSE2(_mm_cmpgt_ps(c, zero), h, zero);
+                        h = SelectSSE2(_mm_cmplt_ps(h, zero), _mm_add_ps(h, six), h);
+                        h = _mm_min_ps(_mm_max_ps(_mm_add_ps(h, shift), zero), six);
+                        h = SelectSSE2(_mm_cmpge_ps(h, six), _mm_sub_ps(h, six), h);
+
+                        outR = _mm_add_ps(mn, _mm_mul_ps(c, HueChannelSSE2(_mm_add_ps(h, _mm_set1_ps(5.0f)))));
+                        outG = _mm_add_ps(mn, _mm_mul_ps(c, HueChannelSSE2(_mm_add_ps(h, _mm_set1_ps(3.0f)))));
+                        outB = _mm_add_ps(mn, _mm_mul_ps(c, HueChannelSSE2(_mm_add_ps(h, one))));
+                    }
+                    else
+                    {
+                        __m128 chromatic = _mm_cmpgt_ps(c, zero);
+                        __m128 hr = SelectSSE2(chromatic, _mm_div_ps(_mm_sub_ps(r, mn), c), one);
+                        __m128 hg = SelectSSE2(chromatic, _mm_div_ps(_mm_sub_ps(g, mn), c), zero);
+                        __m128 hb = SelectSSE2(chromatic, _mm_div_ps(_mm_sub_ps(b, mn), c), zero);
+
+                        if constexpr (C == ComponentShift::Value)
+                        {
+                            __m128 sat = SelectSSE2(_mm_cmpgt_ps(mx, zero), _mm_div_ps(c, mx), zero);
+                            __m128 v = ClampSSE2(_mm_add_ps(mx, shift), 255.0f);
+                            __m128 chroma = _mm_mul_ps(sat, v);
+                            outR = _mm_add_ps(v, _mm_mul_ps(chroma, _mm_sub_ps(hr, one)));
+                            outG = _mm_add_ps(v, _mm_mul_ps(chroma, _mm_sub_ps(hg, one)));
+                            outB = _mm_add_ps(v, _mm_mul_ps(chroma, _mm_sub_ps(hb, one)));
+                        }
+                        else
+                        {
+                            __m128 l = _mm_mul_ps(_mm_add_ps(mx, mn), half);
+                            __m128 span = _mm_sub_ps(full, AbsSSE2(_mm_sub_ps(_mm_add_ps(mx, mn), full)));
+                            __m128 sat = SelectSSE2(_mm_cmpgt_ps(span, zero), _mm_div_ps(c, span), zero);
+                            __m128 newL = l, newSpan = span;
+
+                            if constexpr (C == ComponentShift::Saturation)
+                            {
+                                sat = ClampSSE2(_mm_add_ps(sat, shift), 1.0f);
+                            }
+                            else
+                            {
+                                newL = ClampSSE2(_mm_add_ps(l, shift), 255.0f);
+                                newSpan = _mm_sub_ps(full, AbsSSE2(_mm_sub_ps(_mm_add_ps(newL, newL), full)));
+                            }
+
+                            __m128 chroma = _mm_mul_ps(sat, newSpan);
+                            outR = _mm_add_ps(newL, _mm_mul_ps(chroma, _mm_sub_ps(hr, half)));
+                            outG = _mm_add_ps(newL, _mm_mul_ps(chroma, _mm_sub_ps(hg, half)));
+                            outB = _mm_add_ps(newL, _mm_mul_ps(chroma, _mm_sub_ps(hb, half)));
+                        }
+                    }
+
+                    __m128i out = _mm_or_si128(_mm_and_si128(px, alphaMask),
+                               _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_cvttps_epi32(ClampSSE2(outR, 255.0f)), 16),
+                                                  _mm_slli_epi32(_mm_cvttps_epi32(ClampSSE2(outG, 255.0f)), 8)),
+                                          _mm_cvttps_epi32(ClampSSE2(outB, 255.0f))));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), out);
+                }
+
+                for (; i < count; ++i) pixels[i] = ShiftComponentPixel<C>(pixels[i], delta);
+            }
+
+            __attribute__((target("sse2"), always_inline))
+            inline __m128i MulDiv255SSE2(__m128i x, __m128i y)
+            {
+                __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+                return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+            }
+
+            // Two pixels widened to 16-bit lanes, B G R A each
+            __attribute__((target("sse2"), always_inline))
+            inline __m128i CompositeOverSSE2(__m128i dest, __m128i source, __m128i opacity)
+            {
+                source = MulDiv255SSE2(source, opacity);
+                __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(source, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                dest = MulDiv255SSE2(dest, _mm_sub_epi16(_mm_set1_epi16(255), alpha));
+                return _mm_adds_epu16(source, dest);
+            }
+
+            __attribute__((target("sse2")))
+            void CompositeOverSSE2(uint32_t* dest, const uint32_t* source, size_t count, uint32_t opacity)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i k = _mm_set1_epi16(static_cast<short>(opacity));
+
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+                    __m128i lo = CompositeOverSSE2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), k);
+                    __m128i hi = CompositeOverSSE2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), k);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(lo, hi));
+                }
+
+                for (; i < count; ++i) dest[i] = CompositeOverPixel(dest[i], source[i], opacity);
+            }
+
+            __attribute__((target("sse2"), always_inline))
+            inline __m128i WidenPixelSSE2(uint32_t pixel)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(pixel)), zero), zero);
+            }
+
+            // Integer division by multiplying with the reciprocal, which is at most one off, then fixing that up
+            // from the remainder. Sums below 2^24 and divisors up to MaxBoxWindow keep every step exact in float
+            __attribute__((target("sse2"), always_inline))
+            inline __m128i DivideSumsSSE2(__m128i sums, __m128 divisor, __m128 reciprocal)
+            {
+                __m128 s = _mm_cvtepi32_ps(sums);
+                __m128i q = _mm_cvttps_epi32(_mm_mul_ps(s, reciprocal));
+                __m128 r = _mm_sub_ps(s, _mm_mul_ps(_mm_cvtepi32_ps(q), divisor));
+                q = _mm_sub_epi32(q, _mm_castps_si128(_mm_cmpge_ps(r, divisor)));
+                return _mm_add_epi32(q, _mm_castps_si128(_mm_cmplt_ps(r, _mm_setzero_ps())));
+            }
+
+            __attribute__((target("sse2"), always_inline))
+            inline uint32_t AverageSumsSSE2(__m128i sums, __m128 divisor, __m128 reciprocal)
+            {
+                __m128i q = DivideSumsSSE2(sums, divisor, reciprocal);
+                q = _mm_packs_epi32(q, q);
+                return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(q, q)));
+            }
+
+            // The edges, where the window is clipped and a pixel may not enter or leave
+            __attribute__((target("sse2"), always_inline))
+            inline void BoxBlurEdgeSSE2(__m128i& sums, const uint32_t* source, uint32_t* dest, int x, int width, int radius)
+            {
+                if (x > radius) sums = _mm_sub_epi32(sums, WidenPixelSSE2(source[x - radius - 1]));
+                if (x < width - radius) sums = _mm_add_epi32(sums, WidenPixelSSE2(source[x + radius]));
+
+                const float window = static_cast<float>(BoxWindow(x, width, radius));
+                dest[x] = AverageSumsSSE2(sums, _mm_set1_ps(window), _mm_set1_ps(1.0f / window));
+            }
+
+            // The sliding sum is one pixel's 4 channels in one register, the loop carries a single add
+            __attribute__((target("sse2")))
+            void BoxBlurRowSSE2(const uint32_t* source, uint32_t* dest, int width, int radius)
+            {
+                __m128i sums = _mm_setzero_si128();
+                for (int x = 0; x < std::min(radius, width); ++x) sums = _mm_add_epi32(sums, WidenPixelSSE2(source[x]));
+
+                // Between the edges every window is full, a pixel enters and one leaves at each step
+                const int interiorBegin = std::min(radius + 1, width);
+                const int interiorEnd = std::max(width - radius, interiorBegin);
+                const __m128 window = _mm_set1_ps(static_cast<float>(2 * radius + 1));
+                const __m128 reciprocal = _mm_set1_ps(1.0f / (2 * radius + 1));
+
+                int x = 0;
+                for (; x < interiorBegin; ++x) BoxBlurEdgeSSE2(sums, source, dest, x, width, radius);
+                for (; x < interiorEnd; ++x)
+                {
+                    sums = _mm_add_epi32(_mm_sub_epi32(sums, WidenPixelSSE2(source[x - radius - 1])), WidenPixelSSE2(source[x + radius]));
+                    dest[x] = AverageSumsSSE2(sums, window, reciprocal);
+                }
+                for (; x < width; ++x) BoxBlurEdgeSSE2(sums, source, dest, x, width, radius);
+            }
+
+            __attribute__((target("sse2")))
+            void SlideColumnsSSE2(int32_t* sums, const uint32_t* entering, const uint32_t* leaving, size_t count)
+            {
+                const __m128i zero = _mm_setzero_si128();
+
+                size_t c = 0;
+                for (; c + 4 <= count; c += 4)
+                {
+                    __m128i* s = reinterpret_cast<__m128i*>(sums + c * 4);
+                    __m128i s0 = _mm_loadu_si128(s), s1 = _mm_loadu_si128(s + 1), s2 = _mm_loadu_si128(s + 2), s3 = _mm_loadu_si128(s + 3);
+
+                    if (entering)
+                    {
+                        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(entering + c));
+                        __m128i lo = _mm_unpacklo_epi8(px, zero), hi = _mm_unpackhi_epi8(px, zero);
+                        s0 = _mm_add_epi32(s0, _mm_unpacklo_epi16(lo, zero));
+                        s1 = _mm_add_epi32(s1, _mm_unpackhi_epi16(lo, zero));
+                        s2 = _mm_add_epi32(s2, _mm_unpacklo_epi16(hi, zero));
+                        s3 = _mm_add_epi32(s3, _mm_unpackhi_epi16(hi, zero));
+                    }
+                    if (leaving)
+                    {
+                        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(leaving + c));
+                        __m128i lo = _mm_unpacklo_epi8(px, zero), hi = _mm_unpackhi_epi8(px, zero);
+                        s0 = _mm_sub_epi32(s0, _mm_unpacklo_epi16(lo, zero));
+                        s1 = _mm_sub_epi32(s1, _mm_unpackhi_epi16(lo, zero));
+                        s2 = _mm_sub_epi32(s2, _mm_unpacklo_epi16(hi, zero));
+                        s3 = _mm_sub_epi32(s3, _mm_unpackhi_epi16(hi, zero));
+                    }
+
+                    _mm_storeu_si128(s, s0);
+                    _mm_storeu_si128(s + 1, s1);
+                    _mm_storeu_si128(s + 2, s2);
+                    _mm_storeu_si128(s + 3, s3);
+                }
+
+                SlideColumnsScalar(sums + c * 4, entering ? entering + c : nullptr, leaving ? leaving + c : nullptr, count - c);
+            }
+
+            __attribute__((target("sse2")))
+            void AverageColumnsSSE2(const int32_t* sums, size_t count, int divisor, uint32_t* dest)
+            {
+                const __m128 d = _mm_set1_ps(static_cast<float>(divisor));
+                const __m128 rd = _mm_set1_ps(1.0f / divisor);
+
+                size_t c = 0;
+                for (; c + 4 <= count; c += 4)
+                {
+                    const __m128i* s = reinterpret_cast<const __m128i*>(sums + c * 4);
+                    __m128i lo = _mm_packs_epi32(DivideSumsSSE2(_mm_loadu_si128(s), d, rd), DivideSumsSSE2(_mm_loadu_si128(s + 1), d, rd));
+                    __m128i hi = _mm_packs_epi32(DivideSumsSSE2(_mm_loadu_si128(s + 2), d, rd), DivideSumsSSE2(_mm_loadu_si128(s + 3), d, rd));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + c), _mm_packus_epi16(lo, hi));
+                }
+
+                AverageColumnsScalar(sums + c * 4, count - c, divisor, dest + c);
+            }
+
+            __attribute__((target("sse2")))
+            void RecursiveStepSSE2(float* values, const double* newer, const double* older, double* oldest, size_t width, const GaussianCoefficients& g)
+            {
+                const __m128d b = _mm_set1_pd(g.gain), c0 = _mm_set1_pd(g.feedback[0]), c1 = _mm_set1_pd(g.feedback[1]), c2 = _mm_set1_pd(g.feedback[2]);
+
+                size_t k = 0;
+                for (; k + 4 <= width; k += 4)
+                {
+                    const __m128 v = _mm_loadu_ps(values + k);
+                    __m128d lo = _mm_mul_pd(b, _mm_cvtps_pd(v));
+                    __m128d hi = _mm_mul_pd(b, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+                    lo = _mm_add_pd(lo, _mm_mul_pd(c0, _mm_loadu_pd(newer + k)));
+                    hi = _mm_add_pd(hi, _mm_mul_pd(c0, _mm_loadu_pd(newer + k + 2)));
+                    lo = _mm_add_pd(lo, _mm_mul_pd(c1, _mm_loadu_pd(older + k)));
+                    hi = _mm_add_pd(hi, _mm_mul_pd(c1, _mm_loadu_pd(older + k + 2)));
+                    lo = _mm_add_pd(lo, _mm_mul_pd(c2, _mm_loadu_pd(oldest + k)));
+                    hi = _mm_add_pd(hi, _mm_mul_pd(c2, _mm_loadu_pd(oldest + k + 2)));
+                    _mm_storeu_pd(oldest + k, lo);
+                    _mm_storeu_pd(oldest + k + 2, hi);
+                    _mm_storeu_ps(values + k, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+                }
+
+                RecursiveStepScalar(values + k, newer + k, older + k, oldest + k, width - k, g);
+            }
+
+            // Interleaving the 16-bit channels of two taps lets madd multiply both by their weights and add them
+            // into 32 bits in one instruction, 4 pixels per pair of taps
+            __attribute__((target("sse2")))
+            void ConvolveFixedSSE2(const uint32_t* const* rows, const FixedTap* taps, size_t tapCount, int shift, int32_t offset, size_t count, uint32_t* dest)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i bias = _mm_set1_epi32(offset);
+                const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+
+                size_t x = 0;
+                for (; x + 4 <= count; x += 4)
+                {
+                    __m128i acc0 = bias, acc1 = bias, acc2 = bias, acc3 = bias;
+                    for (size_t t = 0; t < tapCount; t += 2)
+                    {
+                        const FixedTap& a = taps[t];
+                        const FixedTap& b = SecondTap(taps, tapCount, t);
+                        const __m128i w = _mm_set1_epi32(TapPairWeights(taps, tapCount, t));
+                        const __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[a.row] + a.column + x));
+                        const __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[b.row] + b.column + x));
+                        const __m128i alo = _mm_unpacklo_epi8(pa, zero), ahi = _mm_unpackhi_epi8(pa, zero);
+                        const __m128i blo = _mm_unpacklo_epi8(pb, zero), bhi = _mm_unpackhi_epi8(pb, zero);
+                        acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(alo, blo), w));
+                        acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(alo, blo), w));
+                        acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(ahi, bhi), w));
+                        acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(ahi, bhi), w));
+                    }
+
+                    // Saturating packs clamp to 0-255 exactly like the scalar path
+                    const __m128i lo = _mm_packs_epi32(_mm_sra_epi32(acc0, shiftCount), _mm_sra_epi32(acc1, shiftCount));
+                    const __m128i hi = _mm_packs_epi32(_mm_sra_epi32(acc2, shiftCount), _mm_sra_epi32(acc3, shiftCount));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x), _mm_packus_epi16(lo, hi));
+                }
+
+                for (; x < count; ++x) dest[x] = ConvolveFixedPixel(rows, taps, tapCount, shift, offset, x);
+            }
+            #pragma endregion
+
+            #pragma region AVX2
+            __attribute__((target("avx2"), always_inline))
+            inline __m256i MatrixRowAVX2(const __m256 (&m)[4], __m256 offset, __m256 r, __m256 g, __m256 b, __m256 a)
+            {
+                __m256 v = _mm256_mul_ps(m[0], r);
+                v = _mm256_add_ps(v, _mm256_mul_ps(m[1], g));
+                v = _mm256_add_ps(v, _mm256_mul_ps(m[2], b));
+                v = _mm256_add_ps(v, _mm256_mul_ps(m[3], a));
+                v = _mm256_add_ps(v, offset);
+                v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+                return _mm256_cvttps_epi32(v);
+            }
+
+            __attribute__((target("avx2")))
+            void ApplyMatrixAVX2(uint32_t* pixels, size_t count, const MatrixCoefficients& c)
+            {
+                __m256 m[4][4], offset[4];
+                for (int row = 0; row < 4; ++row)
+                {
+                    for (int col = 0; col < 4; ++col) m[row][col] = _mm256_set1_ps(c.m[row][col]);
+                    offset[row] = _mm256_set1_ps(c.offset[row]);
+                }
+
+                const __m256i mask = _mm256_set1_epi32(0xFF);
+
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8)
+                {
+                    __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i));
+                    __m256 r = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), mask));
+                    __m256 g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), mask));
+                    __m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(px, mask));
+                    __m256 a = _mm256_cvtepi32_ps(_mm256_srli_epi32(px, 24));
+
+                    __m256i outR = MatrixRowAVX2(m[0], offset[0], r, g, b, a);
+                    __m256i outG = MatrixRowAVX2(m[1], offset[1], r, g, b, a);
+                    __m256i outB = MatrixRowAVX2(m[2], offset[2], r, g, b, a);
+                    __m256i outA = MatrixRowAVX2(m[3], offset[3], r, g, b, a);
+
+                    __m256i out = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(outA, 24), _mm256_slli_epi32(outR, 16)),
+                                                  _mm256_or_si256(_mm256_slli_epi32(outG, 8), outB));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), out);
+                }
+
+                for (; i < count; ++i) pixels[i] = ApplyMatrixPixel(pixels[i], c);
+            }
+
+            __attribute__((target("avx2"), always_inline))
+            inline __m256 SelectAVX2(__m256 mask, __m256 a, __m256 b) { return _mm256_or_ps(_mm256_and_ps(mask, a), _mm256_andnot_ps(mask, b)); }
+
+            __attribute__((target("avx2"), always_inline))
+            inline __m256 ClampAVX2(__m256 v, float hi) { return _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(hi)); }
+
+            __attribute__((target("avx2"), always_inline))
+            inline __m256 AbsAVX2(__m256 v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+
+            __attribute__((target("avx2"), always_inline))
+            inline __m256 HueChannelAVX2(__m256 k)
+            {
+                const __m256 six = _mm256_set1_ps(6.0f);
+                k = SelectAVX2(_mm256_cmp_ps(k, six, _CMP_GE_OQ), _mm256_sub_ps(k, six), k);
+                return _mm256_sub_ps(_mm256_set1_ps(1.0f), ClampAVX2(_mm256_min_ps(k, _mm256_sub_ps(_mm256_set1_ps(4.0f), k)), 1.0f));
+            }
+
+            // Same operations in the same order as ShiftComponentPixel, 8 pixels at a time
+            template<ComponentShift C>
+            __attribute__((target("avx2")))
+            void ShiftComponentAVX2(uint32_t* pixels, size_t count, float delta)
+            {
+                const __m256i mask = _mm256_set1_epi32(0xFF);
+                const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+                const __m256 zero = _mm256_setzero_ps();
+                const __m256 one = _mm256_set1_ps(1.0f);
+                const __m256 half = _mm256_set1_ps(0.5f);
+                const __m256 full = _mm256_set1_ps(255.0f);
+                const __m256 shift = _mm256_set1_ps(delta);
+
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8)
+                {
+                    __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i));
+                    __m256 r = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), mask));
+                    __m256 g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), mask));
+                    __m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(px, mask));
+
+                    __m256 mx = _mm256_max_ps(_mm256_max_ps(r, g), b);
+                    __m256 mn = _mm256_min_ps(_mm256_min_ps(r, g), b);
+                    __m256 c = _mm256_sub_ps(mx, mn);
+                    __m256 outR, outG, outB;
+
+                    if constexpr (C == ComponentShift::Intensity)
+                    {
+                        __m256 in = _mm256_div_ps(_mm256_add_ps(_mm256_add_ps(r, g), b), _mm256_set1_ps(3.0f));
+                        __m256 shifted = ClampAVX2(_mm256_add_ps(in, shift), 255.0f);
+                        __m256 scale = _mm256_div_ps(shifted, in);
+                        __m256 lit = _mm256_cmp_ps(in, zero, _CMP_GT_OQ);
+                        outR = SelectAVX2(lit, _mm256_mul_ps(r, scale), shifted);
+                        outG = SelectAVX2(lit, _mm256_mul_ps(g, scale), shifted);
+                        outB = SelectAVX2(lit, _mm256_mul_ps(b, scale), shifted);
+                    }
+                    else if constexpr (C == ComponentShift::Hue)
+                    {
+                        const __m256 six = _mm256_set1_ps(6.0f);
+                        __m256 hR = _mm256_div_ps(_mm256_sub_ps(g, b), c);
+                        __m256 hG = _mm256_add_ps(_mm256_set1_ps(2.0f), _mm256_div_ps(_mm256_sub_ps(b, r), c));
+                        __m256 hB = _mm256_add_ps(_mm256_set1_ps(4.0f), _mm256_div_ps(_mm256_sub_ps(r, g), c));
+                        __m256 h = SelectAVX2(_mm256_cmp_ps(mx, r, _CMP_EQ_OQ), hR, SelectAVX2(_mm256_cmp_ps(mx, g, _CMP_EQ_OQ), hG, hB));
+                        h = SelectAVX2(_mm256_cmp_ps(c, zero, _CMP_GT_OQ), h, zero);
+                        h = SelectAVX2(_mm256_cmp_ps(h, zero, _CMP_LT_OQ), _mm256_add_ps(h, six), h);
+                        h = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(h, shift), zero), six);
+                        h = SelectAVX2(_mm256_cmp_ps(h, six, _CMP_GE_OQ), _mm256_sub_ps(h, six), h);
+
+                        outR = _mm256_add_ps(mn, _mm256_mul_ps(c, HueChannelAVX2(_mm256_add_ps(h, _mm256_set1_ps(5.0f)))));
+                        outG = _mm256_add_ps(mn, _mm256_mul_ps(c, HueChannelAVX2(_mm256_add_ps(h, _mm256_set1_ps(3.0f)))));
+                        outB = _mm256_add_ps(mn, _mm256_mul_ps(c, HueChannelAVX2(_mm256_add_ps(h, one))));
+                    }
+                    else
+                    {
+                        __m256 chromatic = _mm256_cmp_ps(c, zero, _CMP_GT_OQ);
+                        __m256 hr = SelectAVX2(chromatic, _mm256_div_ps(_mm256_sub_ps(r, mn), c), one);
+                        __m256 hg = SelectAVX2(chromatic, _mm256_div_ps(_mm256_sub_ps(g, mn), c), zero);
+                        __m256 hb = SelectAVX2(chromatic, _mm256_div_ps(_mm256_sub_ps(b, mn), c), zero);
+
+                        if constexpr (C == ComponentShift::Value)
+                        {
+                            __m256 sat = SelectAVX2(_mm256_cmp_ps(mx, zero, _CMP_GT_OQ), _mm256_div_ps(c, mx), zero);
+                            __m256 v = ClampAVX2(_mm256_add_ps(mx, shift), 255.0f);
+                            __m256 chroma = _mm256_mul_ps(sat, v);
+                            outR = _mm256_add_ps(v, _mm256_mul_ps(chroma, _mm256_sub_ps(hr, one)));
+                            outG = _mm256_add_ps(v, _mm256_mul_ps(chroma, _mm256_sub_ps(hg, one)));
+                            outB = _mm256_add_ps(v, _mm256_mul_ps(chroma, _mm256_sub_ps(hb, one)));
+                        }
+                        else
+                        {
+                            __m256 l = _mm256_mul_ps(_mm256_add_ps(mx, mn), half);
+                            __m256 span = _mm256_sub_ps(full, AbsAVX2(_mm256_sub_ps(_mm256_add_ps(mx, mn), full)));
+                            __m256 sat = SelectAVX2(_mm256_cmp_ps(span, zero, _CMP_GT_OQ), _mm256_div_ps(c, span), zero);
+                            __m256 newL = l, newSpan = span;
+
+                            if constexpr (C == ComponentShift::Saturation)
+                            {
+                                sat = ClampAVX2(_mm256_add_ps(sat, shift), 1.0f);
+                            }
+                            else
+                            {
+                                newL = ClampAVX2(_mm256_add_ps(l, shift), 255.0f);
+                                newSpan = _mm256_sub_ps(full, AbsAVX2(_mm256_sub_ps(_mm256_add_ps(newL, newL), full)));
+                            }
+
+                            __m256 chroma = _mm256_mul_ps(sat, newSpan);
+                            outR = _mm256_add_ps(newL, _mm256_mul_ps(chroma, _mm256_sub_ps(hr, half)));
+                            outG = _mm256_add_ps(newL, _mm256_mul_ps(chroma, _mm256_sub_ps(hg, half)));
+                            outB = _mm256_add_ps(newL, _mm256_mul_ps(chroma, _mm256_sub_ps(hb, half)));
+                        }
+                    }
+
+                    __m256i out = _mm256_or_si256(_mm256_and_si256(px, alphaMask),
+                               _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(_mm256_cvttps_epi32(ClampAVX2(outR, 255.0f)), 16),
+                                                  _mm256_slli_epi32(_mm256_cvttps_epi32(ClampAVX2(outG, 255.0f)), 8)),
+                                          _mm256_cvttps_epi32(ClampAVX2(outB, 255.0f))));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), out);
+                }
+
+                for (; i < count; ++i) pixels[i] = ShiftComponentPixel<C>(pixels[i], delta);
+            }
+
+            __attribute__((target("avx2"), always_inline))
+            inline __m256i MulDiv255AVX2(__m256i x, __m256i y)
+            {
+                __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(128));
+                return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+            }
+
+            __attribute__((target("avx2"), always_inline))
+            inline __m256i CompositeOverAVX2(__m256i dest, __m256i source, __m256i opacity)
+            {
+                source = MulDiv255AVX2(source, opacity);
+                __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(source, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                dest = MulDiv255AVX2(dest, _mm256_sub_epi16(_mm256_set1_epi16(255), alpha));
+                return _mm256_adds_epu16(source, dest);
+            }
+
+            // Unpack and pack both stay inside 128-bit halves, so the pixels come back out in order
+            __attribute__((target("avx2")))
+            void CompositeOverAVX2(uint32_t* dest, const uint32_t* source, size_t count, uint32_t opacity)
+            {
+                const __m256i zero = _mm256_setzero_si256();
+                const __m256i k = _mm256_set1_epi16(static_cast<short>(opacity));
+
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8)
+                {
+                    __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+                    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dest + i));
+                    __m256i lo = CompositeOverAVX2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero), k);
+                    __m256i hi = CompositeOverAVX2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero), k);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), _mm256_packus_epi16(lo, hi));
+                }
+
+                for (; i < count; ++i) dest[i] = CompositeOverPixel(dest[i], source[i], opacity);
+            }
+
+            // Two pixels' channels as 8 ints, in order
+            __attribute__((target("avx2"), always_inline))
+            inline __m256i WidenPixelsAVX2(const uint32_t* pixels)
+            {
+                return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels)));
+            }
+
+            __attribute__((target("avx2"), always_inline))
+            inline __m256i DivideSumsAVX2(__m256i sums, __m256 divisor, __m256 reciprocal)
+            {
+                __m256 s = _mm256_cvtepi32_ps(sums);
+                __m256i q = _mm256_cvttps_epi32(_mm256_mul_ps(s, reciprocal));
+                __m256 r = _mm256_sub_ps(s, _mm256_mul_ps(_mm256_cvtepi32_ps(q), divisor));
+                q = _mm256_sub_epi32(q, _mm256_castps_si256(_mm256_cmp_ps(r, divisor, _CMP_GE_OQ)));
+                return _mm256_add_epi32(q, _mm256_castps_si256(_mm256_cmp_ps(r, _mm256_setzero_ps(), _CMP_LT_OQ)));
+            }
+
+            __attribute__((target("avx2")))
+            void SlideColumnsAVX2(int32_t* sums, const uint32_t* entering, const uint32_t* leaving, size_t count)
+            {
+                size_t c = 0;
+                for (; c + 8 <= count; c += 8)
+                {
+                    __m256i* s = reinterpret_cast<__m256i*>(sums + c * 4);
+                    for (int j = 0; j < 4; ++j)
+                    {
+                        __m256i v = _mm256_loadu_si256(s + j);
+                        if (entering) v = _mm256_add_epi32(v, WidenPixelsAVX2(entering + c + j * 2));
+                        if (leaving) v = _mm256_sub_epi32(v, WidenPixelsAVX2(leaving + c + j * 2));
+                        _mm256_storeu_si256(s + j, v);
+                    }
+                }
+
+                SlideColumnsScalar(sums + c * 4, entering ? entering + c : nullptr, leaving ? leaving + c : nullptr, count - c);
+            }
+
+            // Packing works inside 128-bit halves and leaves the pixels in 0 2 4 6 1 3 5 7 order
+            __attribute__((target("avx2")))
+            void AverageColumnsAVX2(const int32_t* sums, size_t count, int divisor, uint32_t* dest)
+            {
+                const __m256 d = _mm256_set1_ps(static_cast<float>(divisor));
+                const __m256 rd = _mm256_set1_ps(1.0f / divisor);
+                const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+                size_t c = 0;
+                for (; c + 8 <= count; c += 8)
+                {
+                    const __m256i* s = reinterpret_cast<const __m256i*>(sums + c * 4);
+                    __m256i lo = _mm256_packs_epi32(DivideSumsAVX2(_mm256_loadu_si256(s), d, rd), DivideSumsAVX2(_mm256_loadu_si256(s + 1), d, rd));
+                    __m256i hi = _mm256_packs_epi32(DivideSumsAVX2(_mm256_loadu_si256(s + 2), d, rd), DivideSumsAVX2(_mm256_loadu_si256(s + 3), d, rd));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + c), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order));
+                }
+
+                AverageColumnsScalar(sums + c * 4, count - c, divisor, dest + c);
+            }
+
+            __attribute__((target("avx2")))
+            void RecursiveStepAVX2(float* values, const double* newer, const double* older, double* oldest, size_t width, const GaussianCoefficients& g)
+            {
+                const __m256d b = _mm256_set1_pd(g.gain), c0 = _mm256_set1_pd(g.feedback[0]), c1 = _mm256_set1_pd(g.feedback[1]), c2 = _mm256_set1_pd(g.feedback[2]);
+
+                size_t k = 0;
+                for (; k + 4 <= width; k += 4)
+                {
+                    __m256d y = _mm256_mul_pd(b, _mm256_cvtps_pd(_mm_loadu_ps(values + k)));
+                    y = _mm256_add_pd(y, _mm256_mul_pd(c0, _mm256_loadu_pd(newer + k)));
+                    y = _mm256_add_pd(y, _mm256_mul_pd(c1, _mm256_loadu_pd(older + k)));
+                    y = _mm256_add_pd(y, _mm256_mul_pd(c2, _mm256_loadu_pd(oldest + k)));
+                    _mm256_storeu_pd(oldest + k, y);
+                    _mm_storeu_ps(values + k, _mm256_cvtpd_ps(y));
+                }
+
+                RecursiveStepScalar(values + k, newer + k, older + k, oldest + k, width - k, g);
+            }
+
+            // The in-lane unpacks leave pixels 0 and 4, 1 and 5 and so on sharing an accumulator, and the
+            // in-lane packs put them back in order
+            __attribute__((target("avx2")))
+            void ConvolveFixedAVX2(const uint32_t* const* rows, const FixedTap* taps, size_t tapCount, int shift, int32_t offset, size_t count, uint32_t* dest)
+            {
+                const __m256i zero = _mm256_setzero_si256();
+                const __m256i bias = _mm256_set1_epi32(offset);
+                const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+
+                size_t x = 0;
+                for (; x + 8 <= count; x += 8)
+                {
+                    __m256i acc0 = bias, acc1 = bias, acc2 = bias, acc3 = bias;
+                    for (size_t t = 0; t < tapCount; t += 2)
+                    {
+                        const FixedTap& a = taps[t];
+                        const FixedTap& b = SecondTap(taps, tapCount, t);
+                        const __m256i w = _mm256_set1_epi32(TapPairWeights(taps, tapCount, t));
+                        const __m256i pa = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[a.row] + a.column + x));
+                        const __m256i pb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[b.row] + b.column + x));
+                        const __m256i alo = _mm256_unpacklo_epi8(pa, zero), ahi = _mm256_unpackhi_epi8(pa, zero);
+                        const __m256i blo = _mm256_unpacklo_epi8(pb, zero), bhi = _mm256_unpackhi_epi8(pb, zero);
+                        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(alo, blo), w));
+                        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(alo, blo), w));
+                        acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(ahi, bhi), w));
+                        acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(ahi, bhi), w));
+                    }
+
+                    const __m256i lo = _mm256_packs_epi32(_mm256_sra_epi32(acc0, shiftCount), _mm256_sra_epi32(acc1, shiftCount));
+                    const __m256i hi = _mm256_packs_epi32(_mm256_sra_epi32(acc2, shiftCount), _mm256_sra_epi32(acc3, shiftCount));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + x), _mm256_packus_epi16(lo, hi));
+                }
+
+                for (; x < count; ++x) dest[x] = ConvolveFixedPixel(rows, taps, tapCount, shift, offset, x);
+            }
+            #pragma endregion
+            #endif
+        }
+
+        Level GetSupportedLevel()
+        {
+            static const Level level = DetectLevel();
+            return level;
+        }
+
+        Level GetLevel() { return ActiveLevel().load(std::memory_order_relaxed); }
+
+        void SetLevel(Level level)
+        {
+            ActiveLevel().store(std::min(level, GetSupportedLevel()), std::memory_order_relaxed);
+        }
+
+        MatrixCoefficients::MatrixCoefficients(const ColorMatrix& matrix)
+        {
+            // Color * ColorMatrix works on 0-1 channels, so only the offset column needs rescaling
+            for (int row = 0; row < 4; ++row)
+            {
+                for (int col = 0; col < 4; ++col) m[row][col] = static_cast<float>(matrix[row][col]);
+                offset[row] = static_cast<float>(matrix[row][4] * 255.0);
+            }
+        }
+
+        namespace
+        {
+            template<ComponentShift C>
+            void ShiftComponentDispatch(uint32_t* pixels, size_t count, float delta)
+            {
+                switch (GetLevel())
+                {
+                    #ifdef KTLIB_KERNELS_X86
+                    case Level::AVX2: ShiftComponentAVX2<C>(pixels, count, delta); break;
+                    case Level::SSE2: ShiftComponentSSE2<C>(pixels, count, delta); break;
+                    #endif
+                    default:          ShiftComponentScalar<C>(pixels, count, delta); break;
+                }
+            }
+        }
+
+        void ShiftComponent(uint32_t* pixels, size_t count, ComponentShift component, double amount)
+        {
+            // Convert `amount` to the kernels' units: hue in sextants (Color::ShiftHue treats degrees as
+            // a percentage of the wheel), saturation 0-1, everything else 0-255
+            switch (component)
+            {
+                case ComponentShift::Hue:        ShiftComponentDispatch<ComponentShift::Hue>(pixels, count, static_cast<float>(amount * 0.06)); break;
+                case ComponentShift::Saturation: ShiftComponentDispatch<ComponentShift::Saturation>(pixels, count, static_cast<float>(amount / 100.0)); break;
+                case ComponentShift::Lightness:  ShiftComponentDispatch<ComponentShift::Lightness>(pixels, count, static_cast<float>(amount * 2.55)); break;
+                case ComponentShift::Value:      ShiftComponentDispatch<ComponentShift::Value>(pixels, count, static_cast<float>(amount * 2.55)); break;
+                case ComponentShift::Intensity:  ShiftComponentDispatch<ComponentShift::Intensity>(pixels, count, static_cast<float>(amount * 2.55)); break;
+            }
+        }
+
+        void ApplyMatrix(uint32_t* pixels, size_t count, const MatrixCoefficients& coefficients)
+        {
+            switch (GetLevel())
+            {
+                #ifdef KTLIB_KERNELS_X86
+                case Level::AVX2: ApplyMatrixAVX2(pixels, count, coefficients); break;
+                case Level::SSE2: ApplyMatrixSSE2(pixels, count, coefficients); break;
+                #endif
+                default:          ApplyMatrixScalar(pixels, count, coefficients); break;
+            }
+        }
+
+        // Plain loops over 4-float pixels, simple enough for the compiler to vectorise on its own
+        void ExpandPixels(const uint32_t* pixels, size_t count, float* values)
+        {
+            constexpr float scale = 1.0f / 255.0f;
+            for (size_t i = 0; i < count; ++i, values += 4)
+            {
+                values[0] = ((pixels[i] >> 16) & 0xFF) * scale;
+                values[1] = ((pixels[i] >> 8) & 0xFF) * scale;
+                values[2] = (pixels[i] & 0xFF) * scale;
+                values[3] = (pixels[i] >> 24) * scale;
+            }
+        }
+
+        void QuantizePixels(const float* values, size_t count, uint32_t* pixels)
+        {
+            for (size_t i = 0; i < count; ++i, values += 4)
+            {
+                uint32_t out[4];
+                for (int c = 0; c < 4; ++c) out[c] = static_cast<uint32_t>(Clamp01(values[c]) * 255.0f + 0.5f);
+                pixels[i] = (out[3] << 24) | (out[0] << 16) | (out[1] << 8) | out[2];
+            }
+        }
+
+        // One-off conversions, not worth vectorising
+        void Premultiply(uint32_t* pixels, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) pixels[i] = PremultiplyPixel(pixels[i]);
+        }
+
+        void Unpremultiply(uint32_t* pixels, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) pixels[i] = UnpremultiplyPixel(pixels[i]);
+        }
+
+        void CompositeOver(uint32_t* dest, const uint32_t* source, size_t count, uint32_t opacity)
+        {
+            opacity = std::min<uint32_t>(opacity, 255);
+            switch (GetLevel())
+            {
+                #ifdef KTLIB_KERNELS_X86
+                case Level::AVX2: CompositeOverAVX2(dest, source, count, opacity); break;
+                case Level::SSE2: CompositeOverSSE2(dest, source, count, opacity); break;
+                #endif
+                default:          for (size_t i = 0; i < count; ++i) dest[i] = CompositeOverPixel(dest[i], source[i], opacity); break;
+            }
+        }
+
+        // The SIMD division is only exact up to MaxBoxWindow, wider windows stay scalar
+        void BoxBlurRow(const uint32_t* source, uint32_t* dest, int width, int radius)
+        {
+            #ifdef KTLIB_KERNELS_X86
+            if (GetLevel() != Level::Scalar && std::min<int64_t>(2 * static_cast<int64_t>(radius) + 1, width) <= MaxBoxWindow)
+            {
+                BoxBlurRowSSE2(source, dest, width, radius);
+                return;
+            }
+            #endif
+            BoxBlurRowScalar(source, dest, width, radius);
+        }
+
+        void SlideColumns(int32_t* sums, const uint32_t* entering, const uint32_t* leaving, size_t count)
+        {
+            switch (GetLevel())
+            {
+                #ifdef KTLIB_KERNELS_X86
+                case Level::AVX2: SlideColumnsAVX2(sums, entering, leaving, count); break;
+                case Level::SSE2: SlideColumnsSSE2(sums, entering, leaving, count); break;
+                #endif
+                default:          SlideColumnsScalar(sums, entering, leaving, count); break;
+            }
+        }
+
+        void AverageColumns(const int32_t* sums, size_t count, int divisor, uint32_t* dest)
+        {
+            switch (divisor <= MaxBoxWindow ? GetLevel() : Level::Scalar)
+            {
+                #ifdef KTLIB_KERNELS_X86
+                case Level::AVX2: AverageColumnsAVX2(sums, count, divisor, dest); break;
+                case Level::SSE2: AverageColumnsSSE2(sums, count, divisor, dest); break;
+                #endif
+                default:          AverageColumnsScalar(sums, count, divisor, dest); break;
+            }
+        }
+
+        void ApplyMatrix(float* values, size_t count, const ColorMatrix& matrix)
+        {
+            float m[4][5];
+            for (int row = 0; row < 4; ++row)
+            {
+                for (int col = 0; col < 5; ++col) m[row][col] = static_cast<float>(matrix[row][col]);
+            }
+
+            for (size_t i = 0; i < count; ++i, values += 4)
+            {
+                const float r = values[0], g = values[1], b = values[2], a = values[3];
+                for (int row = 0; row < 4; ++row)
+                    values[row] = m[row][0] * r + m[row][1] * g + m[row][2] * b + m[row][3] * a + m[row][4];
+            }
+        }
+
+        void ConvolveFixed(const uint32_t* const* rows, const FixedTap* taps, size_t tapCount, int shift, int32_t offset, size_t count, uint32_t* dest)
+        {
+            switch (GetLevel())
+            {
+                #ifdef KTLIB_KERNELS_X86
+                case Level::AVX2: ConvolveFixedAVX2(rows, taps, tapCount, shift, offset, count, dest); break;
+                case Level::SSE2: ConvolveFixedSSE2(rows, taps, tapCount, shift, offset, count, dest); break;
+                #endif
+                default:          ConvolveFixedScalar(rows, taps, tapCount, shift, offset, count, dest); break;
+            }
+        }
+
+        // Plain loops over contiguous floats again, left to the compiler
+        void AccumulateTaps(const uint32_t* source, const float* weights, int taps, size_t count, float* acc)
+        {
+            for (int j = 0; j < taps; ++j)
+            {
+                const float w = weights[j];
+                if (w == 0.0f) continue;
+
+                const uint32_t* px = source + j;
+                for (size_t x = 0; x < count; ++x)
+                {
+                    for (int k = 0; k < 4; ++k) acc[x * 4 + k] += w * static_cast<float>((px[x] >> (8 * k)) & 0xFF);
+                }
+            }
+        }
+
+        void PackChannels(const float* acc, size_t count, float bias, uint32_t* dest)
+        {
+            for (size_t x = 0; x < count; ++x, acc += 4)
+            {
+                uint32_t out = 0;
+                for (int k = 0; k < 4; ++k) out |= static_cast<uint32_t>(std::floor(std::min(std::max(acc[k] + bias, 0.0f), 255.0f) + 0.5f)) << (8 * k);
+                dest[x] = out;
+            }
+        }
+
+        GaussianCoefficients::GaussianCoefficients(double sigma)
+        {
+            // Young & van Vliet, "Recursive implementation of the Gaussian filter", 1995
+            const double q = (sigma >= 2.5) ? 0.98711 * sigma - 0.96330 : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+            const double q2 = q * q, q3 = q2 * q;
+            const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+            const double c[3] = {
+                (2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / b0,
+                -(1.4281 * q2 + 1.26661 * q3) / b0,
+                0.422205 * q3 / b0
+            };
+            const double g = 1.0 - (c[0] + c[1] + c[2]);
+
+            gain = g;
+            for (int i = 0; i < 3; ++i) feedback[i] = c[i];
+
+            // Past the right edge the last sample repeats forever. Both recursions are linear, so what the
+            // backward pass holds just past the edge is a fixed mix of how far the last three forward outputs
+            // sit from that sample: run the tail once per forward output to find the mix. The tail has decayed
+            // below double precision long before it ends
+            const size_t tail = static_cast<size_t>(std::ceil(q)) * 48 + 64;
+            std::vector<double> forward(tail + 6), backward(tail + 6);
+            for (int k = 0; k < 3; ++k)
+            {
+                std::fill(forward.begin(), forward.end(), 0.0);
+                std::fill(backward.begin(), backward.end(), 0.0);
+
+                forward[2 - k] = 1.0; // Indices 0-2 are the forward outputs at n - 3, n - 2 and n - 1
+                for (size_t t = 3; t < tail + 3; ++t)
+                    forward[t] = c[0] * forward[t - 1] + c[1] * forward[t - 2] + c[2] * forward[t - 3];
+                for (size_t t = tail + 2; t >= 3; --t)
+                    backward[t] = g * forward[t] + c[0] * backward[t + 1] + c[1] * backward[t + 2] + c[2] * backward[t + 3];
+
+                for (int j = 0; j < 3; ++j) edge[j][k] = backward[3 + j];
+            }
+        }
+
+        // The feedback coefficients nearly cancel for large sigma, so the state is kept in double. Which buffer
+        // holds the newest output rotates instead of shifting values along, each step writes one of them
+        void RecursiveGaussian(float* values, size_t width, size_t length, ptrdiff_t step, const GaussianCoefficients& g)
+        {
+            if (width == 0 || length == 0) return;
+
+            const Level level = GetLevel();
+            std::vector<double> state(width * 4);
+            double* y1 = state.data();
+            double* y2 = y1 + width;
+            double* y3 = y2 + width;
+            double* last = y3 + width;
+
+            auto slice = [&](size_t i) { return values + static_cast<ptrdiff_t>(i) * step; };
+
+            auto pass = [&](size_t i)
+            {
+                switch (level)
+                {
+                    #ifdef KTLIB_KERNELS_X86
+                    case Level::AVX2: RecursiveStepAVX2(slice(i), y1, y2, y3, width, g); break;
+                    case Level::SSE2: RecursiveStepSSE2(slice(i), y1, y2, y3, width, g); break;
+                    #endif
+                    default:          RecursiveStepScalar(slice(i), y1, y2, y3, width, g); break;
+                }
+                std::swap(y2, y3); // y3 now holds the newest output and y2 the oldest
+                std::swap(y1, y2);
+            };
+
+            // Left of the edge the first sample repeats, which is also the forward pass's steady state
+            const float* first = slice(0);
+            const float* end = slice(length - 1);
+            for (size_t k = 0; k < width; ++k)
+            {
+                y1[k] = y2[k] = y3[k] = first[k];
+                last[k] = end[k];
+            }
+
+            for (size_t i = 0; i < length; ++i) pass(i);
+
+            // Backward state just past the right edge, from the last three forward outputs
+            for (size_t k = 0; k < width; ++k)
+            {
+                const double u = last[k];
+                const double d[3] = {y1[k] - u, y2[k] - u, y3[k] - u};
+                double e[3];
+                for (int j = 0; j < 3; ++j) e[j] = u + g.edge[j][0] * d[0] + g.edge[j][1] * d[1] + g.edge[j][2] * d[2];
+                y1[k] = e[0];
+                y2[k] = e[1];
+                y3[k] = e[2];
+            }
+
+            for (size_t i = length; i-- > 0;) pass(i);
+        }
+    }
+}
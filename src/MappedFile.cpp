@@ -0,0 +1,64 @@
+#include "../include/MappedFile.hpp"
+
+#include <stdexcept>
+
+namespace KTLib
+{
+    std::unique_ptr<MappedFile> MappedFile::Create(const std::string& path, uint64_t size)
+    {
+        if (size == 0)
+            throw std::invalid_argument("Mapped file size must be positive");
+
+        std::unique_ptr<MappedFile> file(new MappedFile());
+        file->m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file->m_file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Cannot create file: " + path);
+
+        // Mapping past the end of a writable file extends it with zeros
+        file->m_size = size;
+        file->m_writable = true;
+        file->Map(path, PAGE_READWRITE, FILE_MAP_WRITE);
+        return file;
+    }
+
+    std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path, bool writable)
+    {
+        std::unique_ptr<MappedFile> file(new MappedFile());
+        DWORD access = writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+        file->m_file = CreateFileA(path.c_str(), access, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file->m_file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Cannot open file: " + path);
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file->m_file, &size) || size.QuadPart <= 0)
+            throw std::runtime_error("Cannot map an empty file: " + path);
+
+        file->m_size = static_cast<uint64_t>(size.QuadPart);
+        file->m_writable = writable;
+        file->Map(path, writable ? PAGE_READWRITE : PAGE_WRITECOPY, writable ? FILE_MAP_WRITE : FILE_MAP_COPY);
+        return file;
+    }
+
+    void MappedFile::Map(const std::string& path, DWORD protect, DWORD access)
+    {
+        m_mapping = CreateFileMappingA(m_file, nullptr, protect, static_cast<DWORD>(m_size >> 32), static_cast<DWORD>(m_size), nullptr);
+        if (!m_mapping)
+            throw std::runtime_error("Cannot map file: " + path);
+
+        m_data = static_cast<uint8_t*>(MapViewOfFile(m_mapping, access, 0, 0, 0));
+        if (!m_data)
+            throw std::runtime_error("Cannot map file: " + path);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    }
+
+    void MappedFile::Flush() const
+    {
+        if (m_writable) FlushViewOfFile(m_data, 0);
+    }
+}
@@ -0,0 +1,300 @@
+#include "../include/Scheduler.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+namespace KTLib
+{
+    namespace Scheduler
+    {
+        namespace
+        {
+            using Task = void (*)(void*, size_t);
+
+            // What is left of one thread's share as [begin, end) in a single word. The owner takes from
+            // the front and thieves cut the back off, both with a CAS on the whole range
+            struct alignas(64) Share
+            {
+                std::atomic<uint64_t> range{0};
+            };
+
+            inline uint64_t Pack(uint32_t begin, uint32_t end) { return (static_cast<uint64_t>(end) << 32) | begin; }
+            inline uint32_t Begin(uint64_t range) { return static_cast<uint32_t>(range); }
+            inline uint32_t End(uint64_t range) { return static_cast<uint32_t>(range >> 32); }
+
+            thread_local bool t_insideTask = false;
+
+            int ResolveThreadCount(int count)
+            {
+                if (count > 0) return count;
+                return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+            }
+
+            // One Run call. Its tasks are split over a share per thread of the pool, the caller works share 0
+            // and idle workers join the open pass with the fewest helpers, so concurrent passes (a background
+            // job and the UI thread) split the workers between them instead of queueing behind each other
+            struct Pass
+            {
+                Task task;
+                void* context;
+                int participants;
+                std::unique_ptr<Share[]> shares;
+                std::atomic<bool> failed{false};
+                std::exception_ptr error;
+
+                int helpers = 0;    // Workers inside Work, guarded by the pool mutex
+                bool open = true;   // False once someone found nothing left to claim, guarded by the pool mutex
+            };
+
+            class Pool
+            {
+                public:
+                    int GetThreadCount() const { return m_threadCount.load(); }
+
+                    void SetThreadCount(int count)
+                    {
+                        std::unique_lock<std::shared_mutex> runLock(m_runMutex);
+                        count = ResolveThreadCount(count);
+                        if (count == m_threadCount.load()) return;
+
+                        Stop();
+                        m_threadCount = count;
+                    }
+
+                    void Shutdown()
+                    {
+                        std::unique_lock<std::shared_mutex> runLock(m_runMutex);
+                        Stop();
+                    }
+
+                    void Run(size_t count, Task task, void* context)
+                    {
+                        // Shared, so passes only exclude thread count changes and not each other
+                        std::shared_lock<std::shared_mutex> runLock(m_runMutex);
+
+                        Pass pass;
+                        pass.task = task;
+                        pass.context = context;
+                        {
+                            std::lock_guard<std::mutex> lock(m_mutex);
+                            Start();
+                            pass.participants = static_cast<int>(m_workers.size()) + 1;
+                        }
+
+                        // The calling thread is participant 0, workers are 1..n
+                        pass.shares.reset(new Share[pass.participants]);
+                        for (int p = 0; p < pass.participants; ++p)
+                        {
+                            uint32_t begin = static_cast<uint32_t>(count * p / pass.participants);
+                            uint32_t end = static_cast<uint32_t>(count * (p + 1) / pass.participants);
+                            pass.shares[p].range.store(Pack(begin, end), std::memory_order_relaxed);
+                        }
+
+                        {
+                            std::lock_guard<std::mutex> lock(m_mutex);
+                            m_passes.push_back(&pass);
+                        }
+                        m_wake.notify_all();
+
+                        t_insideTask = true;
+                        Work(pass, 0);
+                        t_insideTask = false;
+
+                        {
+                            std::unique_lock<std::mutex> lock(m_mutex);
+                            pass.open = false;
+                            m_done.wait(lock, [&] { return pass.helpers == 0; });
+                            m_passes.erase(std::find(m_passes.begin(), m_passes.end(), &pass));
+                        }
+
+                        if (pass.error) std::rethrow_exception(pass.error);
+                    }
+
+                private:
+                    // Called with m_mutex held
+                    void Start()
+                    {
+                        const int participants = m_threadCount.load();
+                        if (static_cast<int>(m_workers.size()) + 1 == participants) return;
+
+                        for (int id = 1; id < participants; ++id)
+                            m_workers.emplace_back(&Pool::WorkerLoop, this, id);
+                    }
+
+                    // Called with m_runMutex held exclusively, so no pass is running
+                    void Stop()
+                    {
+                        {
+                            std::lock_guard<std::mutex> lock(m_mutex);
+                            m_stopping = true;
+                        }
+                        m_wake.notify_all();
+
+                        for (auto& worker : m_workers) worker.join();
+                        m_workers.clear();
+                        m_stopping = false;
+                    }
+
+                    // The open pass with the fewest helpers, or null. Called with m_mutex held
+                    Pass* PickPass() const
+                    {
+                        Pass* best = nullptr;
+                        for (Pass* pass : m_passes)
+                        {
+                            if (pass->open && (!best || pass->helpers < best->helpers)) best = pass;
+                        }
+                        return best;
+                    }
+
+                    void WorkerLoop(int id)
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        while (true)
+                        {
+                            Pass* pass = nullptr;
+                            m_wake.wait(lock, [&] { return m_stopping || (pass = PickPass()) != nullptr; });
+                            if (m_stopping) return;
+
+                            ++pass->helpers;
+                            lock.unlock();
+
+                            t_insideTask = true;
+                            Work(*pass, id);
+                            t_insideTask = false;
+
+                            lock.lock();
+                            pass->open = false;
+                            if (--pass->helpers == 0) m_done.notify_all();
+                        }
+                    }
+
+                    void Work(Pass& pass, int id)
+                    {
+                        size_t index;
+                        while (!pass.failed.load(std::memory_order_relaxed) && Claim(pass, id, index))
+                        {
+                            try
+                            {
+                                pass.task(pass.context, index);
+                            }
+                            catch (...)
+                            {
+                                std::lock_guard<std::mutex> lock(m_mutex);
+                                if (!pass.error) pass.error = std::current_exception();
+                                pass.failed = true;
+                            }
+                        }
+                    }
+
+                    bool Claim(Pass& pass, int id, size_t& index)
+                    {
+                        Share& own = pass.shares[id];
+                        uint64_t range = own.range.load(std::memory_order_acquire);
+                        while (Begin(range) < End(range))
+                        {
+                            if (own.range.compare_exchange_weak(range, Pack(Begin(range) + 1, End(range)), std::memory_order_acq_rel))
+                            {
+                                index = Begin(range);
+                                return true;
+                            }
+                        }
+
+                        // Out of work: take the back half of whoever has the most left. A failed CAS means
+                        // someone else made progress, so this always terminates. Shares nobody joined are
+                        // emptied this way too
+                        while (true)
+                        {
+                            int victim = -1;
+                            uint32_t most = 0;
+                            uint64_t seen = 0;
+                            for (int p = 0; p < pass.participants; ++p)
+                            {
+                                if (p == id) continue;
+                                uint64_t candidate = pass.shares[p].range.load(std::memory_order_acquire);
+                                uint32_t left = End(candidate) - Begin(candidate);
+                                if (left > most)
+                                {
+                                    most = left;
+                                    victim = p;
+                                    seen = candidate;
+                                }
+                            }
+
+                            if (victim < 0) return false;
+
+                            uint32_t begin = Begin(seen), end = End(seen);
+                            uint32_t middle = begin + (end - begin) / 2;
+                            if (pass.shares[victim].range.compare_exchange_strong(seen, Pack(begin, middle), std::memory_order_acq_rel))
+                            {
+                                own.range.store(Pack(middle + 1, end), std::memory_order_release);
+                                index = middle;
+                                return true;
+                            }
+                        }
+                    }
+
+                    std::shared_mutex m_runMutex;
+                    std::mutex m_mutex;
+                    std::condition_variable m_wake;
+                    std::condition_variable m_done;
+
+                    std::vector<std::thread> m_workers;
+                    std::vector<Pass*> m_passes;
+                    std::atomic<int> m_threadCount{ResolveThreadCount(0)};
+                    bool m_stopping = false;
+            };
+
+            // Never destroyed on purpose, see Shutdown
+            Pool& GetPool()
+            {
+                static Pool* pool = new Pool();
+                return *pool;
+            }
+        }
+
+        void SetThreadCount(int count) { GetPool().SetThreadCount(count); }
+        int GetThreadCount() { return GetPool().GetThreadCount(); }
+        void Shutdown() { GetPool().Shutdown(); }
+
+        void Run(size_t count, void (*task)(void* context, size_t index), void* context)
+        {
+            if (count == 0) return;
+
+            // Nested calls, single tasks and single-threaded runs skip the pool entirely
+            if (t_insideTask || count == 1 || GetThreadCount() == 1)
+            {
+                bool outer = !t_insideTask;
+                t_insideTask = true;
+                try
+                {
+                    for (size_t i = 0; i < count; ++i) task(context, i);
+                }
+                catch (...)
+                {
+                    if (outer) t_insideTask = false;
+                    throw;
+                }
+                if (outer) t_insideTask = false;
+                return;
+            }
+
+            // Shares are 32-bit ranges, anything bigger goes through in slices
+            const size_t slice = UINT32_MAX;
+            if (count <= slice)
+            {
+                GetPool().Run(count, task, context);
+                return;
+            }
+
+            for (size_t begin = 0; begin < count; begin += slice)
+            {
+                struct Offset { Task task; void* context; size_t begin; } offset{task, context, begin};
+                GetPool().Run(std::min(slice, count - begin), [](void* c, size_t i) { auto* o = static_cast<Offset*>(c); o->task(o->context, o->begin + i); }, &offset);
+            }
+        }
+    }
+}
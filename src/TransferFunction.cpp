@@ -0,0 +1,211 @@
+#include "../include/TransferFunction.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace KTLib
+{
+    namespace Transfer
+    {
+        namespace
+        {
+            constexpr int CurveCount = 4;
+
+            // Dense tables cover 0-1 in TableSize steps. Below TableStart the encode curves are too
+            // steep for linear interpolation (Adobe RGB has no linear toe at all), so we go exact there
+            constexpr int TableSize = 4096;
+            constexpr double TableStart = 1.0 / 256.0;
+
+            struct CurveTables
+            {
+                double decode8[256];
+                float decode[TableSize + 1];
+                float encode[TableSize + 1];
+            };
+
+            const CurveTables& Tables(TransferCurve curve)
+            {
+                static const std::array<CurveTables, CurveCount> tables = []
+                {
+                    std::array<CurveTables, CurveCount> result{};
+                    for (int c = 0; c < CurveCount; ++c)
+                    {
+                        TransferCurve curve = static_cast<TransferCurve>(c);
+                        CurveTables& t = result[c];
+
+                        for (int i = 0; i < 256; ++i)
+                            t.decode8[i] = DecodeExact(curve, i / 255.0);
+
+                        for (int i = 0; i <= TableSize; ++i)
+                        {
+                            t.decode[i] = static_cast<float>(DecodeExact(curve, static_cast<double>(i) / TableSize));
+                            t.encode[i] = static_cast<float>(EncodeExact(curve, static_cast<double>(i) / TableSize));
+                        }
+                    }
+                    return result;
+                }();
+
+                return tables[static_cast<int>(curve)];
+            }
+
+            // Exact round-to-nearest encode to 8 bits. threshold[k] is the linear value where code k
+            // starts winning. Indexing by the top float bits gives buckets 2^-8 wide relative to the value,
+            // narrower than the gap between neighbouring thresholds on every curve, so each bucket holds at
+            // most one threshold and a single compare finishes the lookup
+            constexpr int BucketShift = 23 - 8;
+
+            struct ByteTables
+            {
+                float threshold[257];
+                uint32_t minBits;
+                std::vector<uint8_t> candidate;
+            };
+
+            const ByteTables& EncodeTables(TransferCurve curve)
+            {
+                static const std::array<ByteTables, CurveCount> tables = []
+                {
+                    std::array<ByteTables, CurveCount> result{};
+                    for (int c = 0; c < CurveCount; ++c)
+                    {
+                        TransferCurve curve = static_cast<TransferCurve>(c);
+                        ByteTables& t = result[c];
+
+                        t.threshold[0] = -std::numeric_limits<float>::infinity();
+                        for (int k = 1; k < 256; ++k)
+                            t.threshold[k] = static_cast<float>(DecodeExact(curve, (k - 0.5) / 255.0));
+                        t.threshold[256] = std::numeric_limits<float>::infinity();
+
+                        // Start the buckets at the power of two below the first threshold, anything smaller is 0
+                        float minValue = std::exp2(std::floor(std::log2(t.threshold[1])));
+                        float one = 1.0f;
+                        uint32_t maxBits;
+                        std::memcpy(&t.minBits, &minValue, sizeof(float));
+                        std::memcpy(&maxBits, &one, sizeof(float));
+
+                        size_t buckets = ((maxBits - t.minBits) >> BucketShift) + 1;
+                        t.candidate.resize(buckets);
+                        int code = 0;
+                        for (size_t i = 0; i < buckets; ++i)
+                        {
+                            uint32_t bits = t.minBits + static_cast<uint32_t>(i << BucketShift);
+                            float start;
+                            std::memcpy(&start, &bits, sizeof(float));
+                            while (code < 255 && start >= t.threshold[code + 1]) ++code;
+                            t.candidate[i] = static_cast<uint8_t>(code);
+                        }
+                    }
+                    return result;
+                }();
+
+                return tables[static_cast<int>(curve)];
+            }
+
+            inline uint8_t EncodeByte(const ByteTables& t, float linear)
+            {
+                float v;
+                std::memcpy(&v, &t.minBits, sizeof(float));
+                v = (linear > v) ? std::min(linear, 1.0f) : v;
+
+                uint32_t bits;
+                std::memcpy(&bits, &v, sizeof(float));
+                int code = t.candidate[(bits - t.minBits) >> BucketShift];
+                return static_cast<uint8_t>(code + (v >= t.threshold[code + 1]));
+            }
+
+            inline double Interpolate(const float* table, double value)
+            {
+                double position = value * TableSize;
+                int index = std::min(static_cast<int>(position), TableSize - 1);
+                double t = position - index;
+                return table[index] + (table[index + 1] - table[index]) * t;
+            }
+        }
+
+        double DecodeExact(TransferCurve curve, double encoded)
+        {
+            switch (curve)
+            {
+                case TransferCurve::AdobeRGB:
+                    return encoded <= 0.0 ? 0.0 : std::pow(encoded, 2.19921875);
+                case TransferCurve::ProPhoto:
+                    return (encoded < 16.0 / 512.0) ? encoded / 16.0 : std::pow(encoded, 1.8);
+                case TransferCurve::Rec2020:
+                    return encoded < 0.08145 ? encoded / 4.5 : std::pow((encoded + 0.09929682680944) / 1.09929682680944, 1.0 / 0.45);
+                default:
+                    return (encoded <= 0.04045) ? (encoded / 12.92) : std::pow((encoded + 0.055) / 1.055, 2.4);
+            }
+        }
+
+        double EncodeExact(TransferCurve curve, double linear)
+        {
+            switch (curve)
+            {
+                case TransferCurve::AdobeRGB:
+                    return linear <= 0.0 ? 0.0 : std::pow(linear, 1.0 / 2.19921875);
+                case TransferCurve::ProPhoto:
+                    return (linear < 1.0 / 512.0) ? linear * 16.0 : std::pow(linear, 1.0 / 1.8);
+                case TransferCurve::Rec2020:
+                    return linear < 0.018053968510807 ? 4.5 * linear : 1.09929682680944 * std::pow(linear, 0.45) - 0.09929682680944;
+                default:
+                    return (linear > 0.0031308) ? (1.055 * std::pow(linear, 1.0 / 2.4) - 0.055) : (12.92 * linear);
+            }
+        }
+
+        double Decode8(TransferCurve curve, uint8_t encoded)
+        {
+            return Tables(curve).decode8[encoded];
+        }
+
+        double Decode(TransferCurve curve, double encoded)
+        {
+            if (encoded < TableStart || encoded > 1.0) return DecodeExact(curve, encoded);
+            return Interpolate(Tables(curve).decode, encoded);
+        }
+
+        double Encode(TransferCurve curve, double linear)
+        {
+            if (linear < TableStart || linear > 1.0) return EncodeExact(curve, linear);
+            return Interpolate(Tables(curve).encode, linear);
+        }
+
+        void DecodePixels(TransferCurve curve, const uint32_t* pixels, size_t count, float* linear)
+        {
+            const CurveTables& t = Tables(curve);
+            float decode[256];
+            for (int i = 0; i < 256; ++i) decode[i] = static_cast<float>(t.decode8[i]);
+
+            for (size_t i = 0; i < count; ++i, linear += 4)
+            {
+                uint32_t pixel = pixels[i];
+                linear[0] = decode[(pixel >> 16) & 0xFF];
+                linear[1] = decode[(pixel >> 8) & 0xFF];
+                linear[2] = decode[pixel & 0xFF];
+                linear[3] = (pixel >> 24) / 255.0f;
+            }
+        }
+
+        uint8_t EncodeByte(TransferCurve curve, float linear)
+        {
+            return EncodeByte(EncodeTables(curve), linear);
+        }
+
+        void EncodePixels(TransferCurve curve, const float* linear, size_t count, uint32_t* pixels)
+        {
+            const ByteTables& t = EncodeTables(curve);
+
+            for (size_t i = 0; i < count; ++i, linear += 4)
+            {
+                uint32_t r = EncodeByte(t, linear[0]);
+                uint32_t g = EncodeByte(t, linear[1]);
+                uint32_t b = EncodeByte(t, linear[2]);
+                uint32_t a = static_cast<uint32_t>(std::clamp(linear[3] * 255.0f + 0.5f, 0.0f, 255.0f));
+                pixels[i] = (a << 24) | (r << 16) | (g << 8) | b;
+            }
+        }
+    }
+}
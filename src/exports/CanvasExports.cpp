@@ -8,142 +8,216 @@ extern "C"
     COLOR_API Canvas* CreateCanvasFromBuffer(unsigned int* buffer, int width, int height) { return new Canvas(buffer, width, height); }
     COLOR_API Canvas* CreateCanvasFromGradient(Gradient* gradient, int width, int height) { return new Canvas(*gradient, width, height); }
 
+    // Zero-copy, the canvas works on the caller's memory in place
+    COLOR_API Canvas* CreateCanvasFromMemory(void* pixels, int width, int height, int stride, int format) { return Canvas::Wrap(pixels, width, height, stride, static_cast<PixelFormat>(format)); }
+    COLOR_API Canvas* CreateCanvasFromDIBSection(HBITMAP hBitmap) { return Canvas::WrapDIBSection(hBitmap); }
+    COLOR_API Canvas* CreateCanvasMapped(const char* path, int width, int height, Color* col) { return Canvas::CreateMapped(path, width, height, *col); }
+    COLOR_API Canvas* OpenCanvasMapped(const char* path, int writable) { return Canvas::OpenMapped(path, writable != 0); }
+
     // HBITMAP
-    COLOR_API HBITMAP ExportCanvasAsHBITMAP(Canvas* buffer, int targetWidth, int targetHeight) { return buffer->ToHBITMAP(targetWidth, targetHeight); }
+    COLOR_API HBITMAP ExportCanvasAsHBITMAP(Canvas* buffer, int targetWidth, int targetHeight) { return Jobs::WaitForCanvas(buffer)->ToHBITMAP(targetWidth, targetHeight); }
     COLOR_API Canvas* CreateCanvasFromHBITMAP(HBITMAP hBitmap, int width, int height) { return Canvas::FromHBITMAP(hBitmap, width, height); }
 
     // HDC
-    COLOR_API HDC ExportCanvasAsHDC(Canvas* buffer, int targetWidth, int targetHeight) { return buffer->ToHDC(targetWidth, targetHeight); }
+    COLOR_API HDC ExportCanvasAsHDC(Canvas* buffer, int targetWidth, int targetHeight) { return Jobs::WaitForCanvas(buffer)->ToHDC(targetWidth, targetHeight); }
     COLOR_API Canvas* CreateCanvasFromHDC(HDC hdc, int x, int y, int width, int height) { return Canvas::FromHDC(hdc, x, y, width, height); }
 
     // HICON
-    COLOR_API HICON ExportCanvasAsHICON(Canvas* buffer, int targetWidth, int targetHeight) { return buffer->ToHICON(targetWidth, targetHeight); }
+    COLOR_API HICON ExportCanvasAsHICON(Canvas* buffer, int targetWidth, int targetHeight) { return Jobs::WaitForCanvas(buffer)->ToHICON(targetWidth, targetHeight); }
     COLOR_API Canvas* CreateCanvasFromHICON(HICON hIcon) { return Canvas::FromHICON(hIcon); }
 
     // HCURSOR
-    COLOR_API HCURSOR ExportCanvasAsHCURSOR(Canvas* buffer, int targetWidth, int targetHeight) { return buffer->ToHCURSOR(targetWidth, targetHeight); }
+    COLOR_API HCURSOR ExportCanvasAsHCURSOR(Canvas* buffer, int targetWidth, int targetHeight) { return Jobs::WaitForCanvas(buffer)->ToHCURSOR(targetWidth, targetHeight); }
     COLOR_API Canvas* CreateCanvasFromHCURSOR(HCURSOR hCursor) { return Canvas::FromHCURSOR(hCursor); }
 
     COLOR_API Canvas* CreateCanvasFromHWND(HWND hWnd, int x, int y, int width, int height) { return Canvas::FromHWND(hWnd, x, y, width, height); }
     #pragma endregion
 
     #pragma region Canvas Functions
-    COLOR_API void ShiftRedCanvas(Canvas* buffer, int amount) { buffer->ShiftRed(amount); }
-    COLOR_API void ShiftGreenCanvas(Canvas* buffer, int amount) { buffer->ShiftGreen(amount); }
-    COLOR_API void ShiftBlueCanvas(Canvas* buffer, int amount) { buffer->ShiftBlue(amount); }
-    COLOR_API void ShiftAlphaCanvas(Canvas* buffer, int amount) { buffer->ShiftAlpha(amount); }
-    COLOR_API void SetRedCanvas(Canvas* buffer, int value) { buffer->SetRed(value); }
-    COLOR_API void SetGreenCanvas(Canvas* buffer, int value) { buffer->SetGreen(value); }
-    COLOR_API void SetBlueCanvas(Canvas* buffer, int value) { buffer->SetBlue(value); }
-    COLOR_API void SetAlphaCanvas(Canvas* buffer, int value) { buffer->SetAlpha(value); }
-
-    COLOR_API void RotateCanvas(Canvas* buffer, double angle) { buffer->Rotate(angle); }
-    COLOR_API void ResizeCanvas(Canvas* buffer, int newWidth, int newHeight, int resizeImage, Color* fillColor) { buffer->Resize(newWidth, newHeight, resizeImage, *fillColor); }
-    COLOR_API void ScaleCanvas(Canvas* buffer, double scale) { buffer->Scale(scale); }
-    COLOR_API void DeleteCanvas(Canvas* buffer) { delete buffer; }
-
-    COLOR_API int GetCanvasWidth(Canvas* buffer) { return buffer->GetWidth(); }
-    COLOR_API int GetCanvasHeight(Canvas* buffer) { return buffer->GetHeight(); }
-    COLOR_API int GetCanvasSize(Canvas* buffer) { return buffer->GetSize(); }
-    COLOR_API int GetCanvasStride(Canvas* buffer) { return buffer->GetStride(); }
-    COLOR_API Color* CanvasGetAt(Canvas* buffer, int index) { return new Color(buffer->GetAt(index)); }
-    COLOR_API void CanvasSetAt(Canvas* buffer, int index, Color* color) { buffer->SetAt(index, *color); }
-    COLOR_API void CanvasGetXY(Canvas* buffer, int index, int* x, int* y) { buffer->GetXY(index, *x, *y); }
-    COLOR_API void CanvasGetIndex(Canvas* buffer, int x, int y, int* index) { buffer->GetIndex(x, y, *index); }
-
-    COLOR_API unsigned int GetColorIntFromBuffer(Canvas* buffer, int x, int y) { return buffer->Get(x, y).ToInt(0); }
-    COLOR_API void SetColorIntInBuffer(Canvas* buffer, int x, int y, unsigned int colorInt) { buffer->Set(x, y, Color(colorInt)); }
-    COLOR_API Color* GetColorFromBuffer(Canvas* buffer, int x, int y) { return new Color(buffer->Get(x, y)); }
-    COLOR_API void SetColorInBuffer(Canvas* buffer, int x, int y, Color* color) { buffer->Set(x, y, *color); }
+    COLOR_API void ShiftRedCanvas(Canvas* buffer, int amount) { Jobs::WaitForCanvas(buffer)->ShiftRed(amount); }
+    COLOR_API void ShiftGreenCanvas(Canvas* buffer, int amount) { Jobs::WaitForCanvas(buffer)->ShiftGreen(amount); }
+    COLOR_API void ShiftBlueCanvas(Canvas* buffer, int amount) { Jobs::WaitForCanvas(buffer)->ShiftBlue(amount); }
+    COLOR_API void ShiftAlphaCanvas(Canvas* buffer, int amount) { Jobs::WaitForCanvas(buffer)->ShiftAlpha(amount); }
+    COLOR_API void SetRedCanvas(Canvas* buffer, int value) { Jobs::WaitForCanvas(buffer)->SetRed(value); }
+    COLOR_API void SetGreenCanvas(Canvas* buffer, int value) { Jobs::WaitForCanvas(buffer)->SetGreen(value); }
+    COLOR_API void SetBlueCanvas(Canvas* buffer, int value) { Jobs::WaitForCanvas(buffer)->SetBlue(value); }
+    COLOR_API void SetAlphaCanvas(Canvas* buffer, int value) { Jobs::WaitForCanvas(buffer)->SetAlpha(value); }
+
+    COLOR_API void RotateCanvas(Canvas* buffer, double angle) { Jobs::WaitForCanvas(buffer)->Rotate(angle); }
+    COLOR_API void ResizeCanvas(Canvas* buffer, int newWidth, int newHeight, int resizeImage, Color* fillColor) { Jobs::WaitForCanvas(buffer)->Resize(newWidth, newHeight, resizeImage, *fillColor); }
+    COLOR_API void ScaleCanvas(Canvas* buffer, double scale) { Jobs::WaitForCanvas(buffer)->Scale(scale); }
+    COLOR_API void DeleteCanvas(Canvas* buffer) { delete Jobs::WaitForCanvas(buffer); }
+
+    COLOR_API int GetCanvasWidth(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->GetWidth(); }
+    COLOR_API int GetCanvasHeight(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->GetHeight(); }
+    COLOR_API int64_t GetCanvasSize(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->GetSize(); }
+    COLOR_API int GetCanvasStride(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->GetStride(); }
+    COLOR_API uint32_t* GetCanvasPixels(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->GetPixels(); }
+    COLOR_API int GetCanvasFormat(Canvas* buffer) { return static_cast<int>(Jobs::WaitForCanvas(buffer)->GetFormat()); }
+    COLOR_API int IsCanvasWrapped(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->IsWrapped(); }
+    COLOR_API int IsCanvasMapped(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->IsMapped(); }
+    COLOR_API void FlushCanvasMapped(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->FlushMapped(); }
+    COLOR_API Color* CanvasGetAt(Canvas* buffer, int64_t index) { return new Color(Jobs::WaitForCanvas(buffer)->GetAt(index)); }
+    COLOR_API void CanvasSetAt(Canvas* buffer, int64_t index, Color* color) { Jobs::WaitForCanvas(buffer)->SetAt(index, *color); }
+    COLOR_API void CanvasGetXY(Canvas* buffer, int64_t index, int* x, int* y) { Jobs::WaitForCanvas(buffer)->GetXY(index, *x, *y); }
+    COLOR_API void CanvasGetIndex(Canvas* buffer, int x, int y, int64_t* index) { Jobs::WaitForCanvas(buffer)->GetIndex(x, y, *index); }
+
+    COLOR_API unsigned int GetColorIntFromBuffer(Canvas* buffer, int x, int y) { return Jobs::WaitForCanvas(buffer)->Get(x, y).ToInt(0); }
+    COLOR_API void SetColorIntInBuffer(Canvas* buffer, int x, int y, unsigned int colorInt) { Jobs::WaitForCanvas(buffer)->Set(x, y, Color(colorInt)); }
+    COLOR_API Color* GetColorFromBuffer(Canvas* buffer, int x, int y) { return new Color(Jobs::WaitForCanvas(buffer)->Get(x, y)); }
+    COLOR_API void SetColorInBuffer(Canvas* buffer, int x, int y, Color* color) { Jobs::WaitForCanvas(buffer)->Set(x, y, *color); }
     #pragma endregion
 
     #pragma region Color Modification Functions
-    COLOR_API void ShiftHueCanvas(Canvas* buffer, double degrees) { buffer->ShiftHue(degrees); }
-    COLOR_API void ShiftSaturationCanvas(Canvas* buffer, double amount) { buffer->ShiftSaturation(amount); }
-    COLOR_API void ShiftLightnessCanvas(Canvas* buffer, double amount) { buffer->ShiftLightness(amount); }
-    COLOR_API void ShiftValueCanvas(Canvas* buffer, double amount) { buffer->ShiftValue(amount); }
-    COLOR_API void ShiftIntensityCanvas(Canvas* buffer, double amount) { buffer->ShiftIntensity(amount); }
-    COLOR_API void ShiftWhiteLevelCanvas(Canvas* buffer, double amount) { buffer->ShiftWhiteLevel(amount); }
-    COLOR_API void ShiftBlackLevelCanvas(Canvas* buffer, double amount) { buffer->ShiftBlackLevel(amount); }
-    COLOR_API void ShiftContrastCanvas(Canvas* buffer, double amount) { buffer->ShiftContrast(amount); }
-    COLOR_API void AdjustContrastCanvas(Canvas* buffer, double factor) { buffer->AdjustContrast(factor); }
-    COLOR_API void AdjustColorBalanceCanvas(Canvas* buffer, double redFactor, double greenFactor, double blueFactor) { buffer->AdjustColorBalance(redFactor, greenFactor, blueFactor); }
-
-    COLOR_API void OverlayImageCanvas(Canvas* destBuffer, Canvas* overlayBuffer, int x, int y, double opacity) { destBuffer->OverlayImage(*overlayBuffer, x, y, opacity); }
-    COLOR_API void InvertCanvas(Canvas* buffer) { buffer->Invert(); }
-    COLOR_API void GrayscaleCanvas(Canvas* buffer) { buffer->Grayscale(); }
-    COLOR_API void SepiaCanvas(Canvas* buffer, double factor) { buffer->Sepia(factor); }
-    COLOR_API void PixelateCanvas(Canvas* buffer, int pixelSize) { buffer->Pixelate(pixelSize); }
-    COLOR_API void BlurCanvas(Canvas* buffer, int radius) { buffer->Blur(radius); }
-    COLOR_API void GaussianBlurCanvas(Canvas* buffer, int radius) { buffer->GaussianBlur(radius); }
-    COLOR_API void SharpenCanvas(Canvas* buffer, float amount) { buffer->Sharpen(amount); }
-    COLOR_API void CrossProcessCanvas(Canvas* buffer, double factor) { buffer->CrossProcess(factor); }
-    COLOR_API void MoonlightCanvas(Canvas* buffer, double factor) { buffer->Moonlight(factor); }
-    COLOR_API void VintageFilmCanvas(Canvas* buffer, double factor) { buffer->VintageFilm(factor); }
-    COLOR_API void TechnicolorCanvas(Canvas* buffer, double factor) { buffer->Technicolor(factor); }
-    COLOR_API void PolaroidCanvas(Canvas* buffer, double factor) { buffer->Polaroid(factor); }
-    COLOR_API void ComplementCanvas(Canvas* buffer) { buffer->Complement(); }
-    COLOR_API void ApplyEmbossCanvas(Canvas* buffer) { buffer->Emboss(); }
-    COLOR_API void ApplyEdgeDetectCanvas(Canvas* buffer) { buffer->EdgeDetect(); }
-    COLOR_API void ApplyVignetteCanvas(Canvas* buffer, double strength, double radius) { buffer->Vignette(strength, radius); }
-    COLOR_API void ApplyTwoColorNoiseCanvas(Canvas* buffer, double density, Color* saltColor, Color* pepperColor) { buffer->TwoColorNoise(density, *saltColor, *pepperColor); }
-    COLOR_API void ApplyGaussianNoiseCanvas(Canvas* buffer, double mean, double stdDev) { buffer->GaussianNoise(mean, stdDev); }
-    COLOR_API void ApplyPerlinNoiseCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity) { buffer->PerlinNoise(frequency, amplitude, octaves, persistence, lacunarity); }
-    COLOR_API void ApplySimplexNoiseCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity) { buffer->SimplexNoise(frequency, amplitude, octaves, persistence, lacunarity); }
-    COLOR_API void ApplyFractalBrownianMotionCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity) { buffer->FractalBrownianMotion(frequency, amplitude, octaves, persistence, lacunarity); }
-    COLOR_API void ApplyVoronoiDiagramCanvas(Canvas* buffer, int numberOfPoints, double falloff, double strength) { buffer->Voronoi(numberOfPoints, falloff, strength); }
-    COLOR_API void PlasmaEffectCanvas(Canvas* buffer, double frequency, double phase) { buffer->Plasma(frequency, phase); }
-    COLOR_API void DiamondSquareEffectCanvas(Canvas* buffer, double roughness, double waterLevel, double levelsPerStop) { buffer->DiamondSquare(roughness, waterLevel, levelsPerStop); }
-    COLOR_API void PosterizeCanvas(Canvas* buffer, int levels) { buffer->Posterize(levels); }
+    COLOR_API void ShiftHueCanvas(Canvas* buffer, double degrees) { Jobs::WaitForCanvas(buffer)->ShiftHue(degrees); }
+    COLOR_API void ShiftSaturationCanvas(Canvas* buffer, double amount) { Jobs::WaitForCanvas(buffer)->ShiftSaturation(amount); }
+    COLOR_API void ShiftLightnessCanvas(Canvas* buffer, double amount) { Jobs::WaitForCanvas(buffer)->ShiftLightness(amount); }
+    COLOR_API void ShiftValueCanvas(Canvas* buffer, double amount) { Jobs::WaitForCanvas(buffer)->ShiftValue(amount); }
+    COLOR_API void ShiftIntensityCanvas(Canvas* buffer, double amount) { Jobs::WaitForCanvas(buffer)->ShiftIntensity(amount); }
+    COLOR_API void ShiftWhiteLevelCanvas(Canvas* buffer, double amount) { Jobs::WaitForCanvas(buffer)->ShiftWhiteLevel(amount); }
+    COLOR_API void ShiftBlackLevelCanvas(Canvas* buffer, double amount) { Jobs::WaitForCanvas(buffer)->ShiftBlackLevel(amount); }
+    COLOR_API void ShiftContrastCanvas(Canvas* buffer, double amount) { Jobs::WaitForCanvas(buffer)->ShiftContrast(amount); }
+    COLOR_API void AdjustContrastCanvas(Canvas* buffer, double factor) { Jobs::WaitForCanvas(buffer)->AdjustContrast(factor); }
+    COLOR_API void AdjustColorBalanceCanvas(Canvas* buffer, double redFactor, double greenFactor, double blueFactor) { Jobs::WaitForCanvas(buffer)->AdjustColorBalance(redFactor, greenFactor, blueFactor); }
+
+    COLOR_API void OverlayImageCanvas(Canvas* destBuffer, Canvas* overlayBuffer, int x, int y, double opacity) { Jobs::WaitForCanvas(destBuffer)->OverlayImage(*Jobs::WaitForCanvas(overlayBuffer), x, y, opacity); }
+    COLOR_API void InvertCanvas(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->Invert(); }
+    COLOR_API void GrayscaleCanvas(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->Grayscale(); }
+    COLOR_API void SepiaCanvas(Canvas* buffer, double factor) { Jobs::WaitForCanvas(buffer)->Sepia(factor); }
+    COLOR_API void PixelateCanvas(Canvas* buffer, int pixelSize) { Jobs::WaitForCanvas(buffer)->Pixelate(pixelSize); }
+    COLOR_API void BlurCanvas(Canvas* buffer, int radius, int passes) { Jobs::WaitForCanvas(buffer)->Blur(radius, passes); }
+    COLOR_API void GaussianBlurCanvas(Canvas* buffer, double sigma) { Jobs::WaitForCanvas(buffer)->GaussianBlur(sigma); }
+    COLOR_API void GaussianBlurRadiusCanvas(Canvas* buffer, int radius) { Jobs::WaitForCanvas(buffer)->GaussianBlurRadius(radius); }
+    COLOR_API void ConvolveCanvas(Canvas* buffer, int width, int height, const float* weights, float bias, int alpha) { Jobs::WaitForCanvas(buffer)->Convolve(ConvolutionKernel(width, height, std::vector<float>(weights, weights + static_cast<size_t>(std::max(width, 0)) * std::max(height, 0)), bias), static_cast<ConvolveAlpha>(alpha)); }
+    COLOR_API void LowPassCanvas(Canvas* buffer, double cutoff) { Jobs::WaitForCanvas(buffer)->LowPass(cutoff); }
+    COLOR_API void HighPassCanvas(Canvas* buffer, double cutoff) { Jobs::WaitForCanvas(buffer)->HighPass(cutoff); }
+    COLOR_API double PhaseCorrelateCanvas(Canvas* buffer, Canvas* other, double* dx, double* dy) { PhaseCorrelation result = Jobs::WaitForCanvas(buffer)->PhaseCorrelate(*Jobs::WaitForCanvas(other)); *dx = result.dx; *dy = result.dy; return result.peak; }
+    COLOR_API void SharpenCanvas(Canvas* buffer, float amount) { Jobs::WaitForCanvas(buffer)->Sharpen(amount); }
+    COLOR_API void CrossProcessCanvas(Canvas* buffer, double factor) { Jobs::WaitForCanvas(buffer)->CrossProcess(factor); }
+    COLOR_API void MoonlightCanvas(Canvas* buffer, double factor) { Jobs::WaitForCanvas(buffer)->Moonlight(factor); }
+    COLOR_API void VintageFilmCanvas(Canvas* buffer, double factor) { Jobs::WaitForCanvas(buffer)->VintageFilm(factor); }
+    COLOR_API void TechnicolorCanvas(Canvas* buffer, double factor) { Jobs::WaitForCanvas(buffer)->Technicolor(factor); }
+    COLOR_API void PolaroidCanvas(Canvas* buffer, double factor) { Jobs::WaitForCanvas(buffer)->Polaroid(factor); }
+    COLOR_API void ComplementCanvas(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->Complement(); }
+    COLOR_API void ApplyEmbossCanvas(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->Emboss(); }
+    COLOR_API void ApplyEdgeDetectCanvas(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->EdgeDetect(); }
+    COLOR_API void ApplyVignetteCanvas(Canvas* buffer, double strength, double radius) { Jobs::WaitForCanvas(buffer)->Vignette(strength, radius); }
+    COLOR_API void ApplyTwoColorNoiseCanvas(Canvas* buffer, double density, Color* saltColor, Color* pepperColor, uint64_t seed) { Jobs::WaitForCanvas(buffer)->TwoColorNoise(density, *saltColor, *pepperColor, seed); }
+    COLOR_API void ApplyGaussianNoiseCanvas(Canvas* buffer, double mean, double stdDev, uint64_t seed) { Jobs::WaitForCanvas(buffer)->GaussianNoise(mean, stdDev, seed); }
+    COLOR_API void ApplyPerlinNoiseCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed) { Jobs::WaitForCanvas(buffer)->PerlinNoise(frequency, amplitude, octaves, persistence, lacunarity, seed); }
+    COLOR_API void ApplySimplexNoiseCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed) { Jobs::WaitForCanvas(buffer)->SimplexNoise(frequency, amplitude, octaves, persistence, lacunarity, seed); }
+    COLOR_API void ApplyFractalBrownianMotionCanvas(Canvas* buffer, double frequency, double amplitude, int octaves, double persistence, double lacunarity, uint64_t seed) { Jobs::WaitForCanvas(buffer)->FractalBrownianMotion(frequency, amplitude, octaves, persistence, lacunarity, seed); }
+    COLOR_API void ApplyVoronoiDiagramCanvas(Canvas* buffer, int numberOfPoints, double falloff, double strength, uint64_t seed) { Jobs::WaitForCanvas(buffer)->Voronoi(numberOfPoints, falloff, strength, seed); }
+    COLOR_API void PlasmaEffectCanvas(Canvas* buffer, double frequency, double phase) { Jobs::WaitForCanvas(buffer)->Plasma(frequency, phase); }
+    COLOR_API void DiamondSquareEffectCanvas(Canvas* buffer, double roughness, double waterLevel, double levelsPerStop, uint64_t seed) { Jobs::WaitForCanvas(buffer)->DiamondSquare(roughness, waterLevel, levelsPerStop, seed); }
+    COLOR_API void PosterizeCanvas(Canvas* buffer, int levels) { Jobs::WaitForCanvas(buffer)->Posterize(levels); }
     #pragma endregion
 
     #pragma region Utility
-    COLOR_API void FlipCanvas(Canvas* buffer, bool horizontal) { buffer->Flip(horizontal); }
-    COLOR_API void CropCanvas(Canvas* buffer, int x, int y, int width, int height) { buffer->Crop(x, y, width, height); }
-    COLOR_API Color* AverageCanvas(Canvas* buffer) { return new Color(buffer->CalculateAverageColor(0, 0, buffer->GetWidth(), buffer->GetHeight())); }
-    COLOR_API Canvas* CopyCanvasRegion(Canvas* buffer, int x, int y, int w, int h) { return buffer->CopyRegion(x, y, w, h); }
-    COLOR_API Canvas* CopyCanvas(Canvas* buffer) { return buffer->Copy(); }
-
-    COLOR_API int CanvasFind(Canvas* buffer, Color* color) { return buffer->Find(*color); };
-    COLOR_API int CanvasFindLast(Canvas* buffer, Color* color) { return buffer->FindLast(*color); }
-    COLOR_API void CanvasForEach(Canvas* buffer, void (*func)(Color*)) { buffer->ForEach([func](const Color& color) { func(const_cast<Color*>(&color)); }); }
-    COLOR_API void CanvasSwap(Canvas* buffer, int index1, int index2) { buffer->Swap(index1, index2); }
-    COLOR_API Canvas* CanvasFilter(Canvas* buffer, bool (*predicate)(Color*)) { return new Canvas(buffer->Filter([predicate](const Color& color) { return predicate(const_cast<Color*>(&color)); })); }
-    COLOR_API int CanvasCount(Canvas* buffer, Color* color) { return buffer->Count(*color); }
-    COLOR_API size_t CanvasCountUniqueColors(Canvas* buffer) { return buffer->CountUniqueColors(); }
-    COLOR_API void CanvasShuffle(Canvas* buffer) { buffer->Shuffle(); }
-    COLOR_API void CanvasClear(Canvas* buffer) { buffer->Clear(); }
+    COLOR_API void FlipCanvas(Canvas* buffer, bool horizontal) { Jobs::WaitForCanvas(buffer)->Flip(horizontal); }
+    COLOR_API void CropCanvas(Canvas* buffer, int x, int y, int width, int height) { Jobs::WaitForCanvas(buffer)->Crop(x, y, width, height); }
+    COLOR_API Color* AverageCanvas(Canvas* buffer)
+    {
+        // The size is read after the wait, a queued Crop or Resize could still be changing it
+        Canvas* canvas = Jobs::WaitForCanvas(buffer);
+        return new Color(canvas->CalculateAverageColor(0, 0, canvas->GetWidth(), canvas->GetHeight()));
+    }
+    COLOR_API Canvas* CopyCanvasRegion(Canvas* buffer, int x, int y, int w, int h) { return Jobs::WaitForCanvas(buffer)->CopyRegion(x, y, w, h); }
+    COLOR_API Canvas* CopyCanvas(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->Copy(); }
+    COLOR_API Canvas* CreateCanvasView(Canvas* buffer, int x, int y, int w, int h) { return Jobs::WaitForCanvas(buffer)->View(x, y, w, h); }
+
+    COLOR_API int64_t CanvasFind(Canvas* buffer, Color* color) { return Jobs::WaitForCanvas(buffer)->Find(*color); };
+    COLOR_API int64_t CanvasFindLast(Canvas* buffer, Color* color) { return Jobs::WaitForCanvas(buffer)->FindLast(*color); }
+    COLOR_API void CanvasForEach(Canvas* buffer, void (*func)(Color*))
+    {
+        Jobs::WaitForCanvas(buffer);
+
+        // One write preparation for the whole walk, then straight through the rows. Pixels are packed, so
+        // hand the callback a temporary and write back whatever it changed
+        uint8_t* row = reinterpret_cast<uint8_t*>(buffer->GetPixels());
+        for (int y = 0; y < buffer->GetHeight(); ++y, row += buffer->GetStride())
+        {
+            uint32_t* pixels = reinterpret_cast<uint32_t*>(row);
+            for (int x = 0; x < buffer->GetWidth(); ++x)
+            {
+                Color color(pixels[x]);
+                func(&color);
+                pixels[x] = color.argb;
+            }
+        }
+    }
+
+    COLOR_API void CanvasSwap(Canvas* buffer, int64_t index1, int64_t index2) { Jobs::WaitForCanvas(buffer)->Swap(index1, index2); }
+    COLOR_API Canvas* CanvasFilter(Canvas* buffer, bool (*predicate)(Color*)) { return new Canvas(Jobs::WaitForCanvas(buffer)->Filter([predicate](const Color& color) { return predicate(const_cast<Color*>(&color)); })); }
+    COLOR_API int64_t CanvasCount(Canvas* buffer, Color* color) { return Jobs::WaitForCanvas(buffer)->Count(*color); }
+    COLOR_API size_t CanvasCountUniqueColors(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->CountUniqueColors(); }
+    COLOR_API void CanvasShuffle(Canvas* buffer, uint64_t seed) { Jobs::WaitForCanvas(buffer)->Shuffle(seed); }
+    COLOR_API void CanvasClear(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->Clear(); }
     COLOR_API void CanvasSort(Canvas* buffer, int (*compare)(Color*, Color*))
     {
-        buffer->Sort([compare](const Color& a, const Color& b) {
-            Color* aPtr = new Color(a);
-            Color* bPtr = new Color(b);
-            int result = compare(aPtr, bPtr);
-            delete aPtr;
-            delete bPtr;
-            return result < 0;
+        Jobs::WaitForCanvas(buffer)->Sort([compare](const Color& a, const Color& b) {
+            Color aCopy = a, bCopy = b;
+            return compare(&aCopy, &bCopy) < 0;
         });
     }
 
-    COLOR_API void CanvasAppendRight(Canvas* buffer, Canvas* other) { buffer->AppendRight(*other); }
-    COLOR_API void CanvasAppendBottom(Canvas* buffer, Canvas* other) { buffer->AppendBottom(*other); }
+    COLOR_API void CanvasAppendRight(Canvas* buffer, Canvas* other) { Jobs::WaitForCanvas(buffer)->AppendRight(*Jobs::WaitForCanvas(other)); }
+    COLOR_API void CanvasAppendBottom(Canvas* buffer, Canvas* other) { Jobs::WaitForCanvas(buffer)->AppendBottom(*Jobs::WaitForCanvas(other)); }
 
     COLOR_API void MapColorsInBuffer(Canvas* buffer, int x, int y, int width, int height, void* mapFunction)
     {
         auto func = reinterpret_cast<unsigned int(*)(int, int, unsigned int)>(mapFunction);
-        buffer->MapColors(x, y, width, height, func);
+        Jobs::WaitForCanvas(buffer)->MapColors(x, y, width, height, func);
     }
 
-    COLOR_API int* CanvasFindAll(Canvas* buffer, Color* color, int* count)
+    COLOR_API int64_t* CanvasFindAll(Canvas* buffer, Color* color, int64_t* count)
     {
-        auto result = buffer->FindAll(*color);
+        auto result = Jobs::WaitForCanvas(buffer)->FindAll(*color);
         *count = result.size();
-        int* arr = new int[*count];
+        int64_t* arr = new int64_t[*count];
         std::copy(result.begin(), result.end(), arr);
         return arr;
     }
 
-    COLOR_API void CanvasApplyMatrix(Canvas* buffer, ColorMatrix* matrix) { buffer->ApplyMatrix(*matrix); }
-    COLOR_API void DrawCanvas(Canvas* buffer, HWND hwnd, int x, int y) { buffer->Draw(hwnd, x, y); }
+    COLOR_API void FreeCanvasIndices(int64_t* indices) { delete[] indices; }
+
+    COLOR_API void CanvasApplyMatrix(Canvas* buffer, ColorMatrix* matrix) { Jobs::WaitForCanvas(buffer)->ApplyMatrix(*matrix); }
+    COLOR_API void CanvasBeginMatrixBatch(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->BeginMatrixBatch(); }
+    COLOR_API void CanvasEndMatrixBatch(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->EndMatrixBatch(); }
+    COLOR_API void CanvasFlushMatrixBatch(Canvas* buffer) { Jobs::WaitForCanvas(buffer)->FlushMatrixBatch(); }
+    COLOR_API void CanvasSetPrecision(Canvas* buffer, int precision) { Jobs::WaitForCanvas(buffer)->SetPrecision(static_cast<PixelPrecision>(precision)); }
+    COLOR_API int GetCanvasPrecision(Canvas* buffer) { return static_cast<int>(Jobs::WaitForCanvas(buffer)->GetPrecision()); }
+    COLOR_API float* GetCanvasFloatPixels(Canvas* buffer) { return Jobs::WaitForCanvas(buffer)->GetFloatPixels(); }
+    COLOR_API void CanvasSetAlphaMode(Canvas* buffer, int mode) { Jobs::WaitForCanvas(buffer)->SetAlphaMode(static_cast<AlphaMode>(mode)); }
+    COLOR_API int GetCanvasAlphaMode(Canvas* buffer) { return static_cast<int>(Jobs::WaitForCanvas(buffer)->GetAlphaMode()); }
+    COLOR_API void DrawCanvas(Canvas* buffer, HWND hwnd, int x, int y) { Jobs::WaitForCanvas(buffer)->Draw(hwnd, x, y); }
+
+    // Straight into the caller's buffer rather than through a vector
+    COLOR_API void CanvasToSpace(Canvas* buffer, int space, float* out) { Jobs::WaitForCanvas(buffer)->ToSpace(static_cast<ColorSpace>(space), out); }
+
+    COLOR_API void CanvasFromSpace(Canvas* buffer, int space, const float* values) { Jobs::WaitForCanvas(buffer)->FromSpace(values, static_cast<ColorSpace>(space)); }
+    #pragma endregion
+
+    #pragma region Threading
+    COLOR_API void SetCanvasThreadCount(int count) { Scheduler::SetThreadCount(count); }
+    COLOR_API int GetCanvasThreadCount() { return Scheduler::GetThreadCount(); }
+    COLOR_API void ShutdownCanvasThreads() { Jobs::Shutdown(); Scheduler::Shutdown(); }
+    #pragma endregion
+
+    #pragma region Jobs
+    COLOR_API Jobs::Job* CreateCanvasJob(Canvas* buffer) { return new Jobs::Job(buffer); }
+
+    COLOR_API void CanvasJobAdd(Jobs::Job* job, const char* operation, const double* args, int argCount)
+    {
+        job->Add(Jobs::MakeOperation(operation, std::vector<double>(args, args + std::max(argCount, 0))));
+    }
+
+    COLOR_API void StartCanvasJob(Jobs::Job* job) { job->Start(); }
+    COLOR_API void CancelCanvasJob(Jobs::Job* job) { job->Cancel(); }
+    COLOR_API int WaitCanvasJob(Jobs::Job* job, int timeoutMs) { return job->Wait(timeoutMs) ? 1 : 0; }
+    COLOR_API int GetCanvasJobState(Jobs::Job* job) { return static_cast<int>(job->GetState()); }
+    COLOR_API double GetCanvasJobProgress(Jobs::Job* job) { return job->GetProgress(); }
+    COLOR_API const char* GetCanvasJobError(Jobs::Job* job) { return job->GetError().c_str(); }
+    COLOR_API void DeleteCanvasJob(Jobs::Job* job) { delete job; }
     #pragma endregion
 }
\ No newline at end of file
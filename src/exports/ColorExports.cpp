@@ -144,6 +144,9 @@ extern "C"
         b[2] = '\0';
     }
 
+    // Batch conversions over packed ARGB values, four floats per colour, see ColorSpaces::FromPixels
+    COLOR_API void ColorsToSpace(const unsigned int* colors, int count, int space, float* out) { if (count > 0) ColorSpaces::FromPixels(static_cast<ColorSpace>(space), colors, count, out); }
+    COLOR_API void ColorsFromSpace(const float* values, int count, int space, unsigned int* colors) { if (count > 0) ColorSpaces::ToPixels(static_cast<ColorSpace>(space), values, count, colors); }
     #pragma endregion
 
     #pragma region Color Scheme Generation
@@ -223,10 +226,6 @@ extern "C"
     COLOR_API double ColorGetContrast(Color* color1, Color* color2) { return color1->GetContrast(*color2); }
     COLOR_API bool IsColorAccessible(Color* color, Color* background, int level) { return color->IsAccessible(*background, static_cast<Color::AccessibilityLevel>(level)); }
     COLOR_API Color* CreateRandomColor(int alphaRand) { return new Color(Color::Random(alphaRand == 0 ? false : true)); }
-    COLOR_API const char* GetColorFormatString(Color* color) { return color->GetFormatString().c_str(); }
-    COLOR_API void SetColorFormatString(Color* color, const char* format) { color->SetFormatString(std::string(format)); }
-    COLOR_API const char* GetColorTypeString(Color* color) { return color->GetTypeString().c_str(); }
-    COLOR_API void SetColorTypeString(Color* color, const char* type) { color->SetTypeString(type); }
 
     COLOR_API unsigned int ColorToInt(Color* color, int format) { return color->ToInt(format); }
     COLOR_API int GetColorARGB(Color* color) { return color->argb; }
@@ -426,7 +425,7 @@ extern "C"
 
     COLOR_API void ColorToString(Color* color, const char* type, const char* format, char* fullStr)
     {
-        std::string result = color->ToString(type, format);
+        std::string result = ColorFormatter(type, format).Format(*color);
         strncpy(fullStr, result.c_str(), 255);
         fullStr[255] = '\0';
     }
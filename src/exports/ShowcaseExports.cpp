@@ -1,4 +1,5 @@
 #include "../../include/exports/ShowcaseExports.h"
+#include "../../include/Jobs.hpp"
 
 #include <iostream>
 
@@ -18,7 +19,7 @@ extern "C"
 
     SHOWCASE_API void ShowCanvasShowcase(Canvas* buffer, const char* title)
     {
-        Showcase showcase(buffer, title);
+        Showcase showcase(Jobs::WaitForCanvas(buffer), title);
         showcase.Show();
     }
 }
\ No newline at end of file